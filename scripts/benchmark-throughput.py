@@ -0,0 +1,216 @@
+"""
+Benchmarks the simulation's throughput on fixed configurations and checks for regressions
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+import shared
+
+# the fixed configurations, each run with and without perturbations and gradients
+# (name, parameter sets file, number of sets, simulation arguments)
+configs = [
+	("2cell", "set151113.params", 3, "-x 2 -w 2 -y 1 -m 600 -G 600"),
+	("1d", "set151119.params", 2, "-x 50 -w 10 -y 1"),
+	("2d-4", "set151204.params", 1, "-x 50 -w 10 -y 4"),
+	("2d-16", "set151204.params", 1, "-x 50 -w 10 -y 16 -M 1"),
+]
+perturb_file = "perturb.txt"
+gradients_file = "gradient25.txt" # defines gradients up to column 49 so it is only used with a width of 50
+seed = 2000
+
+def main():
+	# check the given arguments
+	print "Reading command-line arguments..."
+	args = sys.argv[1:]
+	num_args = len(args)
+	simulation = None
+	directory = "../simulation"
+	history_file = "benchmark-history.json"
+	threshold = 0.1
+	reps = 1
+	label = ""
+	baseline = None
+	selected = None
+	extra_args = ""
+	record = True
+
+	arg = 0
+	while arg < num_args:
+		option = args[arg]
+		value = None
+		if arg + 1 < num_args:
+			value = args[arg + 1]
+		if option == '-s' or option == '--simulation':
+			simulation = ensureValue(option, value)
+		elif option == '-d' or option == '--directory':
+			directory = ensureValue(option, value)
+		elif option == '-H' or option == '--history-file':
+			history_file = ensureValue(option, value)
+		elif option == '-t' or option == '--threshold':
+			threshold = shared.toFlo(ensureValue(option, value))
+		elif option == '-r' or option == '--repetitions':
+			reps = shared.toInt(ensureValue(option, value))
+		elif option == '-l' or option == '--label':
+			label = ensureValue(option, value)
+		elif option == '-b' or option == '--baseline':
+			baseline = ensureValue(option, value)
+		elif option == '-c' or option == '--configs':
+			selected = ensureValue(option, value).split(',')
+		elif option == '-e' or option == '--extra-args':
+			extra_args = ensureValue(option, value)
+		elif option == '-n' or option == '--no-record':
+			record = False
+			arg -= 1
+		elif option == '-h' or option == '--help':
+			usage()
+		else:
+			usage()
+		arg += 2
+	if simulation == None or reps < 1 or threshold <= 0:
+		usage()
+	simulation = os.path.abspath(simulation)
+	history = readHistory(history_file)
+
+	# run every selected configuration
+	results = {}
+	for name, params, sets, sim_args in configs:
+		for variant in ["", "-pg"]:
+			config = name + variant
+			if selected != None and config not in selected:
+				continue
+			run_args = sim_args + " -i " + params + " -p " + str(sets) + " -s " + str(seed)
+			if extra_args != "":
+				run_args += " " + extra_args
+			if variant != "":
+				run_args += " -u " + perturb_file
+				if "-x 50" in sim_args:
+					run_args += " -r " + gradients_file
+			print "Running " + config + " (" + run_args + ")..."
+			results[config] = runConfig(simulation, directory, run_args, sets, reps)
+			print "  %.3f sets/s, %d KB peak RSS" % (results[config]["sets_per_second"], results[config]["peak_rss_kb"])
+	if len(results) == 0:
+		print "No configurations matched the given names!"
+		exit(2)
+
+	# compare against the baseline and record the results if nothing regressed
+	regressions = findRegressions(history, results, threshold, baseline)
+	for regression in regressions:
+		print "Regression: " + regression
+	entry = {"time": time.strftime("%Y-%m-%d %H:%M:%S"), "label": label, "simulation": simulation, "extra_args": extra_args, "repetitions": reps, "results": results}
+	if record and len(regressions) == 0:
+		history.append(entry)
+		history_out = shared.openFile(history_file, "w")
+		json.dump(history, history_out, indent=1, sort_keys=True)
+		history_out.write("\n")
+		history_out.close()
+		print "Recorded the results in " + history_file + "."
+	if len(regressions) > 0:
+		exit(1)
+
+# run the simulation with the given arguments the given number of times, keeping the fastest run
+def runConfig(simulation, directory, run_args, sets, reps):
+	best = None
+	for rep in range(reps):
+		profile_fd, profile_file = tempfile.mkstemp(suffix=".json")
+		os.close(profile_fd)
+		command = [simulation] + run_args.split() + ["--profile", profile_file, "-q"]
+		start = time.time()
+		process = subprocess.Popen(command, cwd=directory)
+		pid, status, usage_info = os.wait4(process.pid, 0)
+		wall = time.time() - start
+		if status != 0:
+			print "The simulation exited with status " + str(status >> 8) + " when running '" + " ".join(command) + "'!"
+			os.remove(profile_file)
+			exit(1)
+		phases = readPhases(profile_file)
+		os.remove(profile_file)
+		result = {"wall_seconds": wall, "sets_per_second": sets / wall, "peak_rss_kb": usage_info.ru_maxrss, "phases": phases}
+		if best == None or result["wall_seconds"] < best["wall_seconds"]:
+			best = result
+	return best
+
+# read the whole run's phase times from the given profile report (see the simulation's --profile option)
+def readPhases(filename):
+	report = shared.openFile(filename, "r")
+	phases = {}
+	for line in report:
+		record = json.loads(line)
+		if "run" in record:
+			phases = record["run"]["phases"]
+	report.close()
+	return phases
+
+# read the history file, which holds a list of recorded benchmark entries
+def readHistory(filename):
+	if not os.path.exists(filename):
+		return []
+	history_in = shared.openFile(filename, "r")
+	try:
+		history = json.load(history_in)
+	except ValueError:
+		print "'" + filename + "' is not a valid history file!"
+		exit(2)
+	history_in.close()
+	return history
+
+# compare the given results with the baseline entry in the history (the latest one with each configuration unless a label is given)
+def findRegressions(history, results, threshold, baseline):
+	regressions = []
+	for config in sorted(results.keys()):
+		previous = None
+		for entry in reversed(history):
+			if config in entry["results"] and (baseline == None or entry["label"] == baseline):
+				previous = entry["results"][config]
+				break
+		if previous == None:
+			continue
+		current = results[config]
+		if current["sets_per_second"] < previous["sets_per_second"] * (1 - threshold):
+			regressions.append("%s throughput fell from %.3f to %.3f sets/s" % (config, previous["sets_per_second"], current["sets_per_second"]))
+		if current["peak_rss_kb"] > previous["peak_rss_kb"] * (1 + threshold):
+			regressions.append("%s peak RSS rose from %d to %d KB" % (config, previous["peak_rss_kb"], current["peak_rss_kb"]))
+	return regressions
+
+# exit with the usage information if an option is missing its value
+def ensureValue(option, value):
+	if value == None:
+		print "Missing the argument for the '" + option + "' option!"
+		usage()
+	return value
+
+def usage():
+	print 'Usage: python benchmark-throughput.py (-short_option value | --long_option value)...'
+	print '-s, --simulation   [filename]  : the relative filename of the simulation to benchmark, required'
+	print '-d, --directory    [directory] : the directory with the parameter sets, perturbations, and gradients files, default=../simulation'
+	print '-H, --history-file [filename]  : the JSON file to compare results with and record them in, default=benchmark-history.json'
+	print '-t, --threshold    [float]     : the relative slowdown or peak memory growth that counts as a regression, default=0.1'
+	print '-r, --repetitions  [int]       : the number of times to run each configuration (the fastest run is kept), default=1'
+	print '-l, --label        [string]    : a label to record the results with (e.g. a commit), default=none'
+	print '-b, --baseline     [string]    : compare with the latest results recorded with this label instead of the latest results, default=none'
+	print '-c, --configs      [names]     : a comma-separated list of the configurations to run, default=all'
+	print '                                 (2cell, 1d, 2d-4, 2d-16, each optionally followed by -pg for perturbations and gradients)'
+	print '-e, --extra-args   [string]    : extra arguments to run the simulation with (e.g. "--huge-pages thp --pin-threads"), default=none'
+	print '-n, --no-record    [N/A]       : do not record the results in the history file'
+	print '-h, --help         [N/A]       : view usage information (i.e. this)'
+	exit(0)
+
+main()
+
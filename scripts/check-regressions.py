@@ -0,0 +1,161 @@
+"""
+Checks that the simulation's scores with its default options still match the recorded baseline scores and that forking induced mutants does not change any results
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+"""
+
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import shared
+
+# the configurations whose scores are compared with the baseline scores recorded in the baselines directory, run with every other option left at its default
+# (name, parameter sets file, number of sets, simulation arguments)
+baseline_configs = [
+	("defaults", "set151119.params", 1, "-x 16 -w 10 -y 4"),
+]
+# the configurations run with and without --fork-inductions, whose scores and features files must be identical
+# (name, parameter sets file, number of sets, simulation arguments), each with explicit induction times that differ between the mutants
+fork_configs = [
+	("fork-2d", "set151119.params", 2, "-x 16 -w 10 -y 4 -V 500 -Y 550 -Z 600 -Q 650 -K 700"),
+	("fork-1d", "set151119.params", 2, "-x 30 -w 10 -y 1 -u perturb.txt -V 450 -Y 500 -Z 550 -Q 600 -K 650"),
+]
+seed = 7
+
+def main():
+	# check the given arguments
+	print "Reading command-line arguments..."
+	args = sys.argv[1:]
+	num_args = len(args)
+	simulation = None
+	directory = "../simulation"
+	baselines = os.path.join(os.path.dirname(os.path.abspath(__file__)), "regression-baselines")
+	selected = None
+	keep = None
+	update = False
+
+	arg = 0
+	while arg < num_args:
+		option = args[arg]
+		value = None
+		if arg + 1 < num_args:
+			value = args[arg + 1]
+		if option == '-s' or option == '--simulation':
+			simulation = ensureValue(option, value)
+		elif option == '-d' or option == '--directory':
+			directory = ensureValue(option, value)
+		elif option == '-b' or option == '--baselines':
+			baselines = ensureValue(option, value)
+		elif option == '-c' or option == '--configs':
+			selected = ensureValue(option, value).split(',')
+		elif option == '-k' or option == '--keep':
+			keep = ensureValue(option, value)
+		elif option == '-u' or option == '--update':
+			update = True
+			arg -= 1
+		elif option == '-h' or option == '--help':
+			usage()
+		else:
+			usage()
+		arg += 2
+	if simulation == None:
+		usage()
+	simulation = os.path.abspath(simulation)
+	if keep != None:
+		shared.ensureDir(keep)
+		out_dir = os.path.abspath(keep)
+	else:
+		out_dir = tempfile.mkdtemp()
+
+	# run every selected configuration and compare its scores with the baseline (or record them as the new baseline)
+	failed = False
+	checked = 0
+	for name, params, sets, sim_args in baseline_configs:
+		if selected != None and name not in selected:
+			continue
+		checked += 1
+		scores = os.path.join(out_dir, name + "-scores.csv")
+		runSimulation(simulation, directory, name, sim_args + " -i " + params + " -p " + str(sets) + " -s " + str(seed) + " -E " + scores)
+		baseline = os.path.join(baselines, name + "-scores.csv")
+		if update:
+			shared.ensureDir(baselines)
+			shutil.copyfile(scores, baseline)
+			print "  Recorded the scores as the baseline in " + baseline + "."
+		elif not os.path.exists(baseline):
+			print "  There is no baseline for " + name + " (" + baseline + ")! Record one with -u or --update."
+			failed = True
+		elif filecmp.cmp(scores, baseline, shallow=False):
+			print "  The scores match the baseline."
+		else:
+			print "  The scores differ from the baseline (" + baseline + ")!"
+			failed = True
+
+	# run every selected fork configuration with and without forking and compare the scores and features files the runs printed
+	for name, params, sets, sim_args in fork_configs:
+		if selected != None and name not in selected:
+			continue
+		checked += 1
+		outputs = {}
+		for variant in ["", "-forked"]:
+			outputs[variant] = [os.path.join(out_dir, name + variant + "-scores.csv"), os.path.join(out_dir, name + variant + "-features.csv")]
+			run_args = sim_args + " -i " + params + " -p " + str(sets) + " -s " + str(seed) + " -E " + outputs[variant][0] + " -f " + outputs[variant][1]
+			if variant != "":
+				run_args += " --fork-inductions"
+			runSimulation(simulation, directory, name + variant, run_args)
+		for i, output in enumerate(["scores", "features"]):
+			if filecmp.cmp(outputs[""][i], outputs["-forked"][i], shallow=False):
+				print "  The " + output + " match with and without forking."
+			else:
+				print "  The " + output + " differ with and without forking!"
+				failed = True
+	if checked == 0:
+		print "No configurations matched the given names!"
+		exit(2)
+	if keep == None:
+		shutil.rmtree(out_dir)
+	if failed:
+		exit(1)
+
+# run the simulation with the given arguments in the given directory, exiting if it fails
+def runSimulation(simulation, directory, name, run_args):
+	print "Running " + name + " (" + run_args + ")..."
+	command = [simulation] + run_args.split() + ["-q"]
+	if subprocess.call(command, cwd=directory) != 0:
+		print "The simulation exited with an error when running '" + " ".join(command) + "'!"
+		exit(1)
+
+# exit with the usage information if an option is missing its value
+def ensureValue(option, value):
+	if value == None:
+		print "Missing the argument for the '" + option + "' option!"
+		usage()
+	return value
+
+def usage():
+	print 'Usage: python check-regressions.py (-short_option value | --long_option value)...'
+	print '-s, --simulation [filename]  : the relative filename of the simulation to check, required'
+	print '-d, --directory  [directory] : the directory with the parameter sets and perturbations files, default=../simulation'
+	print '-b, --baselines  [directory] : the directory with the baseline scores files, default=regression-baselines next to this script'
+	print '-c, --configs    [names]     : a comma-separated list of the configurations to run (defaults, fork-2d, fork-1d), default=all'
+	print '-k, --keep       [directory] : the directory to keep the runs\' output files in, default=none (they are deleted)'
+	print '-u, --update     [N/A]       : record the scores as the new baselines instead of checking them'
+	print '-h, --help       [N/A]       : view usage information (i.e. this)'
+	exit(0)
+
+main()
+
@@ -0,0 +1,168 @@
+"""
+Compares the simulation's posterior period and amplitude estimates from its crit-point and spectral feature backends
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+"""
+
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import shared
+
+# the configurations to compare the backends on, using the bundled parameter sets files
+# (name, parameter sets file, number of sets, simulation arguments)
+configs = [
+	("2cell", "set151113.params", 3, "-x 2 -w 2 -y 1 -m 600 -G 600"),
+	("1d", "set151119.params", 2, "-x 30 -w 10 -y 1"),
+	("2d", "set151204.params", 1, "-x 30 -w 10 -y 2"),
+]
+backends = ["crit", "spectral"]
+genes = ["mh1", "mh7", "deltac"]
+seed = 2000
+
+def main():
+	# check the given arguments
+	print "Reading command-line arguments..."
+	args = sys.argv[1:]
+	num_args = len(args)
+	simulation = None
+	directory = "../simulation"
+	tolerance = 0.2
+	selected = None
+	keep = None
+
+	arg = 0
+	while arg < num_args:
+		option = args[arg]
+		value = None
+		if arg + 1 < num_args:
+			value = args[arg + 1]
+		if option == '-s' or option == '--simulation':
+			simulation = ensureValue(option, value)
+		elif option == '-d' or option == '--directory':
+			directory = ensureValue(option, value)
+		elif option == '-t' or option == '--tolerance':
+			tolerance = shared.toFlo(ensureValue(option, value))
+		elif option == '-c' or option == '--configs':
+			selected = ensureValue(option, value).split(',')
+		elif option == '-k' or option == '--keep':
+			keep = ensureValue(option, value)
+		elif option == '-h' or option == '--help':
+			usage()
+		else:
+			usage()
+		arg += 2
+	if simulation == None or tolerance <= 0:
+		usage()
+	simulation = os.path.abspath(simulation)
+	if keep != None:
+		shared.ensureDir(keep)
+		out_dir = os.path.abspath(keep)
+	else:
+		out_dir = tempfile.mkdtemp()
+
+	# run every selected configuration with each backend and compare the posterior feature files the runs printed
+	failed = False
+	compared = 0
+	for name, params, sets, sim_args in configs:
+		if selected != None and name not in selected:
+			continue
+		compared += 1
+		dirs = {}
+		for backend in backends:
+			dirs[backend] = os.path.join(out_dir, name + "-" + backend)
+			run_args = sim_args + " -i " + params + " -p " + str(sets) + " -s " + str(seed) + " -P -D " + dirs[backend] + " --feature-backend " + backend
+			print "Running " + name + " with the " + backend + " backend (" + run_args + ")..."
+			command = [simulation] + run_args.split() + ["-q"]
+			if subprocess.call(command, cwd=directory) != 0:
+				print "The simulation exited with an error when running '" + " ".join(command) + "'!"
+				exit(1)
+		for feature in ["period", "amplitude"]:
+			for gene in genes:
+				stats = compareFeature(dirs, sets, feature, gene)
+				line = "  %s %-9s %-6s: %4d cells, mean relative difference %.4f, max %.4f, %d cells oscillating in only one" % (name, feature, gene, stats["cells"], stats["mean"], stats["max"], stats["mismatched"])
+				if stats["mean"] > tolerance:
+					line += " (above the tolerance)"
+					failed = True
+				print line
+	if compared == 0:
+		print "No configurations matched the given names!"
+		exit(2)
+	if keep == None:
+		shutil.rmtree(out_dir)
+	if failed:
+		exit(1)
+
+# compare the average of each cell's estimates of the given feature between the backends across every mutant and set
+def compareFeature(dirs, sets, feature, gene):
+	differences = []
+	mismatched = 0
+	for mutant in sorted(os.listdir(dirs[backends[0]])):
+		for set_num in range(sets):
+			filename = "set_" + str(set_num) + "_" + feature + "_" + gene + "_post.feats"
+			values = [readCellAverages(os.path.join(dirs[backend], mutant, filename)) for backend in backends]
+			if values[0] == None or values[1] == None:
+				continue
+			for crit, spectral in zip(values[0], values[1]):
+				if crit == None and spectral == None:
+					continue
+				if crit == None or spectral == None:
+					mismatched += 1
+					continue
+				differences.append(abs(spectral - crit) / max(abs(crit), 1e-9))
+	stats = {"cells": len(differences), "mean": 0, "max": 0, "mismatched": mismatched}
+	if len(differences) > 0:
+		stats["mean"] = sum(differences) / len(differences)
+		stats["max"] = max(differences)
+	return stats
+
+# read the average of each cell's finite values in the given posterior feature file (None for cells without any)
+def readCellAverages(filename):
+	if not os.path.exists(filename):
+		return None
+	feats_file = shared.openFile(filename, "r")
+	averages = []
+	for line in feats_file.readlines()[1:]: # the first line holds the tissue size
+		values = [float(value) for value in line.split()]
+		values = [value for value in values if not math.isinf(value) and not math.isnan(value)]
+		if len(values) == 0:
+			averages.append(None)
+		else:
+			averages.append(sum(values) / len(values))
+	feats_file.close()
+	return averages
+
+# exit with the usage information if an option is missing its value
+def ensureValue(option, value):
+	if value == None:
+		print "Missing the argument for the '" + option + "' option!"
+		usage()
+	return value
+
+def usage():
+	print 'Usage: python compare-feature-backends.py (-short_option value | --long_option value)...'
+	print '-s, --simulation [filename]  : the relative filename of the simulation to run, required'
+	print '-d, --directory  [directory] : the directory with the parameter sets files, default=../simulation'
+	print '-t, --tolerance  [float]     : the largest mean relative difference between the backends that passes, default=0.2'
+	print '-c, --configs    [names]     : a comma-separated list of the configurations to run (2cell, 1d, 2d), default=all'
+	print '-k, --keep       [directory] : the directory to keep the runs\' feature files in, default=none (they are deleted)'
+	print '-h, --help       [N/A]       : view usage information (i.e. this)'
+	exit(0)
+
+main()
+
@@ -31,32 +31,40 @@ def main():
 	if len(sys.argv) < 5:
 		usage()
 	else:
-		f = shared.openFile(sys.argv[1], "r")
 		directory = sys.argv[2]
 		image_name = sys.argv[3]
 		step_size = shared.toFlo(sys.argv[4])
 	
 	print 'Plotting all the cells from ' + sys.argv[1] + '...'
-	# split the lines to get data
-	data = [line.split() for line in f]
-	max_time = len(data) - 1
-	
-	# calculate the tissue size
-	cells_width = shared.toInt(data[0][0])
-	cells_height = shared.toInt(data[0][1])
-	total_cells = cells_width * cells_height + 1
-	
-	# create a matrix to store the concentration values we obtain from the file
-	cons = numpy.zeros(shape = (max_time, total_cells))
-	
-	# put the concentration values from the file into the matrix
-	for i in range(1, max_time + 1):
-		cons[i - 1][0] = shared.toFlo(data[i][0]) * step_size
-		for j in range(1, total_cells):
-			cons[i - 1][j] = shared.toFlo(data[i][j])
-	
-	# close the file
-	f.close()
+	if sys.argv[1].endswith('.npy'): # read a NumPy array (see the simulation's --npy-output option)
+		times, cells_width, cells_height, cells = shared.readNpyCons(sys.argv[1])
+		max_time = len(times)
+		total_cells = cells_width * cells_height + 1
+		cons = numpy.zeros(shape = (max_time, total_cells))
+		cons[:, 0] = times * step_size
+		cons[:, 1:] = cells
+	else:
+		# split the lines to get data
+		f = shared.openFile(sys.argv[1], "r")
+		data = [line.split() for line in f]
+		max_time = len(data) - 1
+		
+		# calculate the tissue size
+		cells_width = shared.toInt(data[0][0])
+		cells_height = shared.toInt(data[0][1])
+		total_cells = cells_width * cells_height + 1
+		
+		# create a matrix to store the concentration values we obtain from the file
+		cons = numpy.zeros(shape = (max_time, total_cells))
+		
+		# put the concentration values from the file into the matrix
+		for i in range(1, max_time + 1):
+			cons[i - 1][0] = shared.toFlo(data[i][0]) * step_size
+			for j in range(1, total_cells):
+				cons[i - 1][j] = shared.toFlo(data[i][j])
+		
+		# close the file
+		f.close()
 	
 	# plot colors
 	colors = ['b', 'g', 'r', 'c', 'm', 'y', 'k']
@@ -69,6 +69,11 @@ def main():
 				if cons_length1 == height:
 					cons_data1.append(cons)
 					cons1 = []
+	elif cons_fname1.endswith('.npy'): # Read NumPy array (see the simulation's --npy-output option)
+		times, width, height, cons_data1 = shared.readNpyCons(cons_fname1)
+		checkSize(width, height)
+		min_con1 = float(cons_data1.min())
+		max_con1 = float(cons_data1.max())
 	else:
 		usage()
 		
@@ -109,6 +114,11 @@ def main():
 				if cons_length2 == height:
 					cons_data2.append(cons)
 					cons2 = []
+	elif cons_fname2.endswith('.npy'): # Read NumPy array (see the simulation's --npy-output option)
+		times, width, height, cons_data2 = shared.readNpyCons(cons_fname2)
+		checkSize(width, height)
+		min_con2 = float(cons_data2.min())
+		max_con2 = float(cons_data2.max())
 	else:
 		usage()
 		
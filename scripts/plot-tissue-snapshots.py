@@ -67,6 +67,11 @@ def main():
 				if cons_length == height:
 					cons_data.append(cons)
 					cons = []
+	elif cons_fname.endswith('.npy'): # Read NumPy array (see the simulation's --npy-output option)
+		times, width, height, cons_data = shared.readNpyCons(cons_fname)
+		checkSize(width, height)
+		min_con = float(cons_data.min())
+		max_con = float(cons_data.max())
 	else:
 		usage()
 	
@@ -17,15 +17,91 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 """
 
 import os
+import re
+import struct
+import StringIO
 
-# try to open the file specified by the given filename
+PACK_MAGIC = "SIMPACK\0" # the 8 bytes every pack file (see the simulation's --pack option) starts and ends with
+pack_indices = {} # the index of every pack file read so far, by filename
+
+# try to open the file specified by the given filename, reading it from a pack file if the filename is inside one (e.g. run.pack/wildtype/set_0.cons)
 def openFile(filename, mode):
+	if "r" in mode and not os.path.exists(filename):
+		packed = openPackedFile(filename)
+		if packed != None:
+			return packed
 	try:
 		return open(filename, mode)
 	except IOError:
 		print "Couldn't open '" + filename + "'!"
 		exit(1);
 
+# open the record the given filename names inside a pack file as a file object, None if the filename is not inside a pack file
+def openPackedFile(filename):
+	parts = filename.split("/")
+	if len(parts) < 3:
+		return None
+	pack_file = "/".join(parts[:-2])
+	match = re.match(r"set_(\d+)(.*)$", parts[-1])
+	if pack_file == "" or match == None or not os.path.isfile(pack_file):
+		return None
+	data = readPackRecord(pack_file, int(match.group(1)), parts[-2], match.group(2))
+	if data == None:
+		return None
+	return StringIO.StringIO(data)
+
+# read a concentrations or cells array printed with the simulation's --npy-output option, memory-mapping it unless it is inside a pack file
+# returns the time steps, the width and height of the grids, and the concentrations as one row of width * height values per time step
+def readNpyCons(filename):
+	import numpy
+	if os.path.exists(filename):
+		array = numpy.load(filename, mmap_mode='r')
+	else:
+		array = numpy.load(openFile(filename, "rb"))
+	cons = array['cons']
+	height, width = cons.shape[1], cons.shape[2]
+	return array['time'], width, height, cons.reshape(len(cons), width * height)
+
+# read the index of the given pack file as a list of (set, mutant, type, offset, size) entries, one per chunk in the order they were appended
+def readPackIndex(filename):
+	if filename in pack_indices:
+		return pack_indices[filename]
+	pack = openFile(filename, "rb")
+	if pack.read(8) != PACK_MAGIC:
+		print "'" + filename + "' is not a pack file!"
+		exit(2)
+	pack.seek(-16, os.SEEK_END)
+	index_offset, magic = struct.unpack("<q8s", pack.read(16))
+	if magic != PACK_MAGIC:
+		print "'" + filename + "' is not a complete pack file!"
+		exit(2)
+	pack.seek(index_offset)
+	num_entries = struct.unpack("<i", pack.read(4))[0]
+	index = []
+	for i in range(num_entries):
+		set_num, length = struct.unpack("<ii", pack.read(8))
+		mutant = pack.read(length)
+		length = struct.unpack("<i", pack.read(4))[0]
+		record_type = pack.read(length)
+		offset, size = struct.unpack("<qq", pack.read(16))
+		index.append((set_num, mutant, record_type, offset, size))
+	pack.close()
+	pack_indices[filename] = index
+	return index
+
+# read the record with the given set, mutant directory name, and file name suffix (e.g. ".cons" or "_period_mh1_post.feats") from the given pack file, None if it has no such record
+def readPackRecord(filename, set_num, mutant, record_type):
+	chunks = [(offset, size) for entry_set, entry_mutant, entry_type, offset, size in readPackIndex(filename) if entry_set == set_num and entry_mutant == mutant and entry_type == record_type]
+	if len(chunks) == 0:
+		return None
+	pack = openFile(filename, "rb")
+	data = []
+	for offset, size in chunks:
+		pack.seek(offset)
+		data.append(pack.read(size))
+	pack.close()
+	return "".join(data)
+
 # ensure the given directory exists
 def ensureDir(directory):
 	if directory[-1] == '/':
@@ -0,0 +1,628 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+bench.cpp contains the main, usage, and licensing functions of the kernel microbenchmarks along with the benchmarks themselves.
+The benchmarks are built with 'scons bench' and link every simulation source but main.cpp, so they time the exact code the simulation runs on synthetic data rather than through full runs.
+Every time is reported in nanoseconds per cell-step, i.e. per cell per time step for the integrator kernels and per cell per call (or per sample) for the others.
+*/
+
+#include <algorithm> // Needed for sort
+#include <iomanip> // Needed for setw and setprecision
+
+#include "bench.hpp" // Function declarations
+
+#include "main.hpp"
+#include "init.hpp"
+#include "sim.hpp"
+#include "feats.hpp"
+#include "profile.hpp"
+
+using namespace std;
+
+extern terminal* term; // Declared in init.cpp
+
+// The first parameter set of set2.params, used for every fixture's rates
+static double bench_set[NUM_RATES] = {
+	49.543080, 34.155352, 42.281804, 30.169085, 60.710704, 51.354659, 0.325181, 0.440741, 0.125915, 0.324304, 0.426594, 0.382471,
+	11.628790, 47.582779, 12.825721, 10.317911, 28.119150, 45.839809, 0.196628, 0.116499, 0.273233, 0.260938, 0.225902, 0.081418,
+	0.009829, 0.012664, 0.015920, 0.029735, 0.012993, 0.005894, 0.002968, 0.017257, 0.012398, 0.273985, 0.172248, 0.128611,
+	0.032670, 0.218732, 0.160099, 0.136427, 0.200692, 0.130890, 0.143758, 0.238289, 0.133975, 0.132601, 0.305126, 0.300521,
+	0.246428, 0.270347, 0.239516, 8.896067, 9.426640, 11.358007, 8.609028, 0.000000, 8.375841, 0.646034, 1.758765, 1.874648,
+	1.938120, 1.756888, 24.343241, 259.893837, 201.927228, 397.145445, 707.962843, 396.403874, 860.338895, 0.954173, 0.384012
+};
+
+// Every benchmark in the order they run
+static const bench_kernel kernels[] = {
+	{"con_protein_her",        true,  bench_con_protein_her},
+	{"dimer_proteins",         true,  bench_dimer_proteins},
+	{"mRNA_synthesis_1d",      false, bench_mrna_synthesis},
+	{"mRNA_synthesis_2d",      true,  bench_mrna_synthesis},
+	{"delay_indices",          true,  bench_delay_indices},
+	{"update_rates",           true,  bench_update_rates},
+	{"update_rates_gradients", true,  bench_update_rates_gradients},
+	{"split",                  true,  bench_split},
+	{"baby_to_cl",             true,  bench_baby_to_cl},
+	{"pearson_correlation",    true,  bench_pearson_correlation},
+	{"get_peaks_and_troughs",  true,  bench_peaks_and_troughs},
+	{"wave_testing",           true,  bench_wave_testing}
+};
+static const int num_kernels = sizeof(kernels) / sizeof(bench_kernel);
+
+/* main is called when the benchmarks are run and times every requested kernel
+	parameters:
+		argc: the number of command-line arguments
+		argv: the array of command-line arguments
+	returns: 0 on success, a positive integer on failure
+	notes:
+	todo:
+*/
+int main (int argc, char** argv) {
+	bench_params bp;
+	input_params ip;
+	init_terminal();
+	accept_bench_params(argc, argv, bp);
+	init_profiler(ip); // The kernels' counting macros expect a (disabled) profiler
+
+	bool found = bp.kernel == NULL;
+	for (int i = 0; i < num_kernels && !found; i++) {
+		found = strcmp(bp.kernel, kernels[i].name) == 0;
+	}
+	if (!found) {
+		usage("The given kernel does not exist. Set -k or --kernel to one of the names listed in the usage information.");
+	}
+
+	cout << term->blue << "Benchmarking " << term->reset << bp.width << " x 1 (1D) and " << bp.width << " x " << bp.height << " (2D) tissues, " << bp.steps << " steps per repetition, " << bp.warmup << " warm-up and " << bp.reps << " timed repetitions" << endl;
+	cout << left << setw(24) << "kernel" << right << setw(8) << "cells" << setw(12) << "min" << setw(12) << "median" << setw(12) << "mean" << "  (ns per cell-step)" << endl;
+	for (int i = 0; i < num_kernels; i++) {
+		if (bp.kernel == NULL || strcmp(bp.kernel, kernels[i].name) == 0) {
+			time_kernel(bp, kernels[i]);
+		}
+	}
+
+	free_profiler();
+	free_terminal();
+	return EXIT_SUCCESS;
+}
+
+/* accept_bench_params fills the given bench_params with values from the given command-line arguments
+	parameters:
+		num_args: the number of command-line arguments (i.e. argc)
+		args: the array of command-line arguments (i.e. argv)
+		bp: the benchmarks' parameters
+	returns: nothing
+	notes:
+		Ensure the usage function's message matches the arguments this function accepts whenever editing or adding command-line argument acceptance.
+	todo:
+*/
+void accept_bench_params (int num_args, char** args, bench_params& bp) {
+	for (int i = 1; i < num_args; i += 2) { // Iterate through each argument pair (if an argument does not have an accompanying value, i-- should be called when found)
+		char* option = args[i];
+		char* value;
+		if (i < num_args - 1) {
+			value = args[i + 1];
+		} else {
+			value = NULL;
+		}
+
+		if (option_set(option, "-x", "--total-width")) {
+			ensure_nonempty(option, value);
+			bp.width = atoi(value);
+			if (bp.width < 3) {
+				usage("The tissue width must be at least 3 cells. Set -x or --total-width to at least 3.");
+			}
+		} else if (option_set(option, "-y", "--height")) {
+			ensure_nonempty(option, value);
+			bp.height = atoi(value);
+			if (bp.height < 2) {
+				usage("The 2D tissue height must be at least 2 cells. Set -y or --height to at least 2.");
+			}
+		} else if (option_set(option, "-S", "--step-size")) {
+			ensure_nonempty(option, value);
+			bp.step_size = atof(value);
+			if (bp.step_size <= 0) {
+				usage("The step size must be a positive real number. Set -S or --step-size to be greater than 0.");
+			}
+		} else if (option_set(option, "-n", "--steps")) {
+			ensure_nonempty(option, value);
+			bp.steps = atoi(value);
+			if (bp.steps < 1) {
+				usage("The number of steps per repetition must be a positive integer. Set -n or --steps to at least 1.");
+			}
+		} else if (option_set(option, "-r", "--repetitions")) {
+			ensure_nonempty(option, value);
+			bp.reps = atoi(value);
+			if (bp.reps < 1) {
+				usage("The number of timed repetitions must be a positive integer. Set -r or --repetitions to at least 1.");
+			}
+		} else if (option_set(option, "-w", "--warmup")) {
+			ensure_nonempty(option, value);
+			bp.warmup = atoi(value);
+			if (bp.warmup < 0) {
+				usage("The number of warm-up repetitions must be a nonnegative integer. Set -w or --warmup to at least 0.");
+			}
+		} else if (option_set(option, "-s", "--seed")) {
+			ensure_nonempty(option, value);
+			bp.seed = atoi(value);
+			if (bp.seed <= 0) {
+				usage("The seed must be a positive integer. Set -s or --seed to at least 1.");
+			}
+		} else if (option_set(option, "-k", "--kernel")) {
+			ensure_nonempty(option, value);
+			mfree(bp.kernel);
+			bp.kernel = copy_str(value);
+		} else if (option_set(option, "-h", "--help")) {
+			usage("");
+			i--;
+		} else if (option_set(option, "-l", "--licensing")) {
+			licensing();
+			i--;
+		} else { // Do not ignore invalid arguments; exit with an error to let the user know this argument is problematic
+			const char* message_0 = "'";
+			const char* message_1 = "' is not a valid option! Please check that every argument matches one available in the following usage information.";
+			char* message = (char*)mallocate(sizeof(char) * (strlen(message_0) + strlen(option) + strlen(message_1) + 1));
+			sprintf(message, "%s%s%s", message_0, option, message_1);
+			usage(message);
+		}
+	}
+}
+
+/* create_fixture creates the synthetic simulation state a kernel is benchmarked on
+	parameters:
+		bp: the benchmarks' parameters
+		two_d: whether to create a 2D tissue (true) or a 1D one (false)
+	returns: a pointer to the new fixture
+	notes:
+		The tissue is fully grown and every cell is simulated as in the posterior. Columns are born steps_split time steps apart, youngest at the active start, so delays reach back through one or two parents like they do in the anterior.
+	todo:
+*/
+bench_fixture* create_fixture (bench_params& bp, bool two_d) {
+	bench_fixture* bf = new bench_fixture();
+	input_params& ip = bf->ip;
+	ip.width_total = ip.width_initial = bp.width;
+	ip.height = two_d ? bp.height : 1;
+	ip.step_size = bp.step_size;
+
+	// Set up the simulation data and rates the way a posterior simulation would
+	bf->sd = new sim_data(ip);
+	sim_data& sd = *(bf->sd);
+	sd.section = SEC_POST;
+	sd.time_end = bp.steps;
+	sd.initialize_active_data();
+	if (sd.height > 1) {
+		calc_neighbors_2d(sd);
+	}
+	bf->rs = new rates(sd.width_total, sd.cells_total);
+	rates& rs = *(bf->rs);
+	memcpy(rs.rates_base, bench_set, sizeof(rs.rates_base));
+	perturb_rates_all(rs);
+	update_rates(rs, sd.active_start);
+	calc_max_delay_size(sd, rs, rs.rates_base);
+	bf->md.index = MUTANT_WILDTYPE;
+	bf->md.wave_test = bench_wave_test;
+
+	// Fill baby_cl with smooth positive concentrations and each column's birth and parent records
+	bf->time = (sd.width_total - 1) * sd.steps_split + sd.max_delay_size;
+	bf->baby_cl.initialize(NUM_CON_LEVELS, sd.max_delay_size, sd.cells_total, sd.active_start);
+	for (int j = 0; j < sd.max_delay_size; j++) {
+		for (int k = 0; k < sd.cells_total; k++) {
+			int col = k % sd.width_total;
+			int age = WRAP(sd.active_start - col, sd.width_total); // How many columns were born after this one
+			for (int i = MIN_CON_LEVEL; i <= MAX_CON_LEVEL; i++) {
+				bf->baby_cl.cons[i][j][k] = 10 + 5 * sin(0.01 * j + 0.3 * k + i);
+			}
+			bf->baby_cl.cons[BIRTH][j][k] = bf->time - age * sd.steps_split;
+			if (age == sd.width_total - 1) { // The oldest column has no parent
+				bf->baby_cl.cons[PARENT][j][k] = k;
+			} else {
+				bf->baby_cl.cons[PARENT][j][k] = k - col + WRAP(col - 1, sd.width_total);
+			}
+		}
+		bf->baby_cl.active_start_record[j] = sd.active_start;
+		bf->baby_cl.active_end_record[j] = sd.active_end;
+	}
+
+	// Fill cl with her1 mRNA oscillations that travel across the tissue in three waves
+	bf->cl.initialize(NUM_CON_STORE, bp.steps, sd.cells_total, sd.active_start);
+	bf->series = new double*[sd.cells_total];
+	for (int k = 0; k < sd.cells_total; k++) {
+		bf->series[k] = new double[bp.steps];
+	}
+	for (int j = 0; j < bp.steps; j++) {
+		for (int k = 0; k < sd.cells_total; k++) {
+			double phase = 2 * M_PI * (j * sd.step_size / BENCH_PERIOD + 3.0 * (k % sd.width_total) / sd.width_total);
+			for (int i = CMH1; i < NUM_CON_STORE; i++) {
+				bf->cl.cons[i][j][k] = 30 + 20 * sin(phase + i);
+			}
+			bf->series[k][j] = bf->cl.cons[CMH1][j][k];
+		}
+		bf->cl.active_start_record[j] = sd.active_start;
+		bf->cl.active_end_record[j] = sd.active_end;
+	}
+
+	return bf;
+}
+
+/* delete_fixture frees the given fixture from memory
+	parameters:
+		bf: a pointer to the fixture to delete
+	returns: nothing
+	notes:
+	todo:
+*/
+void delete_fixture (bench_fixture* bf) {
+	for (int k = 0; k < bf->sd->cells_total; k++) {
+		delete[] bf->series[k];
+	}
+	delete[] bf->series;
+	delete bf->rs;
+	delete bf->sd;
+	delete bf;
+}
+
+/* advance_time moves the given fixture's baby_cl to the next time step
+	parameters:
+		bf: the fixture
+	returns: the previous time step
+	notes:
+	todo:
+*/
+int advance_time (bench_fixture& bf) {
+	int time_prev = bf.baby_time;
+	bf.baby_time = WRAP(bf.baby_time + 1, bf.sd->max_delay_size);
+	return time_prev;
+}
+
+/* time_kernel times the given kernel on a fresh fixture and prints the results
+	parameters:
+		bp: the benchmarks' parameters
+		bk: the kernel to time
+	returns: nothing
+	notes:
+		The minimum is the most repeatable number to compare builds with; the median and mean show how noisy the machine was.
+	todo:
+*/
+void time_kernel (bench_params& bp, const bench_kernel& bk) {
+	bench_fixture* bf = create_fixture(bp, bk.two_d);
+	srand(bp.seed);
+
+	for (int i = 0; i < bp.warmup; i++) {
+		bk.run(*bf, bp.steps);
+	}
+	double times[bp.reps];
+	double sum = 0;
+	for (int i = 0; i < bp.reps; i++) {
+		double start = profile_clock();
+		double cell_steps = bk.run(*bf, bp.steps);
+		times[i] = (profile_clock() - start) * 1e9 / cell_steps;
+		sum += times[i];
+	}
+	sort(times, times + bp.reps);
+
+	double median = (bp.reps % 2 == 1) ? times[bp.reps / 2] : (times[bp.reps / 2 - 1] + times[bp.reps / 2]) / 2;
+	cout << left << setw(24) << bk.name << right << setw(8) << bf->sd->cells_total << fixed << setprecision(2) << setw(12) << times[0] << setw(12) << median << setw(12) << sum / bp.reps << endl;
+	delete_fixture(bf);
+}
+
+/* bench_con_protein_her runs con_protein_her for her1 protein in every cell
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to run
+	returns: the number of cell-steps run
+	notes:
+	todo:
+*/
+double bench_con_protein_her (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	double dimer_effects[NUM_HER_INDICES] = {0};
+	int old_cells_protein[NUM_INDICES];
+	for (int j = 0; j < steps; j++) {
+		int time_prev = advance_time(bf);
+		for (int k = 0; k < sd.cells_total; k++) {
+			for (int l = 0; l < NUM_INDICES; l++) {
+				old_cells_protein[l] = k;
+			}
+			st_context stc(time_prev, bf.baby_time, k);
+			cp_args cpa(sd, bf.rs->rates_active, bf.baby_cl, stc, old_cells_protein, dimer_effects);
+			con_protein_her(cpa, cph_indices(CMH1, CPH1, CPH1H1, RPSH1, RPDH1, RDAH1H1, RDDIH1H1, RDELAYPH1, IH1, IPH1));
+		}
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_dimer_proteins runs dimer_proteins, i.e. con_dimer for every dimer, in every cell
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to run
+	returns: the number of cell-steps run
+	notes:
+		con_dimer is timed through its caller because it is inline; calling it directly would require an out-of-line copy, which the simulation then stops inlining.
+	todo:
+*/
+double bench_dimer_proteins (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	for (int j = 0; j < steps; j++) {
+		int time_prev = advance_time(bf);
+		for (int k = 0; k < sd.cells_total; k++) {
+			st_context stc(time_prev, bf.baby_time, k);
+			dimer_proteins(sd, bf.rs->rates_active, bf.baby_cl, stc);
+		}
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_mrna_synthesis runs mRNA_synthesis in every cell, which averages Delta over 1D or 2D neighbors depending on the fixture
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to run
+	returns: the number of cell-steps run
+	notes:
+	todo:
+*/
+double bench_mrna_synthesis (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	int old_cells_mrna[NUM_INDICES];
+	for (int j = 0; j < steps; j++) {
+		int time_prev = advance_time(bf);
+		for (int k = 0; k < sd.cells_total; k++) {
+			for (int l = 0; l < NUM_INDICES; l++) {
+				old_cells_mrna[l] = k;
+			}
+			st_context stc(time_prev, bf.baby_time, k);
+			mRNA_synthesis(sd, bf.rs->rates_active, bf.baby_cl, stc, old_cells_mrna, bf.md, false, false);
+		}
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_delay_indices finds where every cell was at the start of each mRNA and protein delay with calculate_delay_indices, as anterior simulations do every step
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to run
+	returns: the number of cell-steps run
+	notes:
+		index_with_splits is timed through its caller for the same reason as con_dimer. Each cell-step makes 2 * NUM_INDICES calls to it.
+	todo:
+*/
+double bench_delay_indices (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	int old_cells_mrna[NUM_INDICES];
+	int old_cells_protein[NUM_INDICES];
+	sd.section = SEC_ANT;
+	for (int j = 0; j < steps; j++) {
+		advance_time(bf);
+		for (int k = 0; k < sd.cells_total; k++) {
+			calculate_delay_indices(sd, bf.baby_cl, bf.baby_time, bf.time, k, bf.rs->rates_active, old_cells_mrna, old_cells_protein);
+		}
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_update_rates runs update_rates without gradients
+	parameters:
+		bf: the fixture
+		steps: the number of calls to make
+	returns: the number of cell-steps run
+	notes:
+	todo:
+*/
+double bench_update_rates (bench_fixture& bf, int steps) {
+	for (int j = 0; j < steps; j++) {
+		update_rates(*(bf.rs), bf.sd->active_start);
+	}
+	return (double)steps * bf.sd->cells_total;
+}
+
+/* bench_update_rates_gradients runs update_rates with a gradient on every mRNA synthesis rate
+	parameters:
+		bf: the fixture
+		steps: the number of calls to make
+	returns: the number of cell-steps run
+	notes:
+	todo:
+*/
+double bench_update_rates_gradients (bench_fixture& bf, int steps) {
+	rates& rs = *(bf.rs);
+	rs.using_gradients = true;
+	for (int i = RMSH1; i <= RMSDELTA; i++) {
+		rs.has_gradient[i] = true;
+		for (int x = 0; x < rs.width; x++) {
+			rs.factors_gradient[i][x] = 1 - 0.5 * x / rs.width;
+		}
+	}
+	for (int j = 0; j < steps; j++) {
+		update_rates(rs, bf.sd->active_start);
+	}
+	return (double)steps * bf.sd->cells_total;
+}
+
+/* bench_split splits the posterior-most column of cells repeatedly
+	parameters:
+		bf: the fixture
+		steps: the number of splits to make
+	returns: the number of cells split
+	notes:
+	todo:
+*/
+double bench_split (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	for (int j = 0; j < steps; j++) {
+		advance_time(bf);
+		split(sd, *(bf.rs), bf.baby_cl, bf.baby_time, bf.time);
+	}
+	return (double)steps * sd.height;
+}
+
+/* bench_baby_to_cl copies every time step from baby_cl to cl
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to copy
+	returns: the number of cell-steps copied
+	notes:
+	todo:
+*/
+double bench_baby_to_cl (bench_fixture& bf, int steps) {
+	for (int j = 0; j < steps; j++) {
+		advance_time(bf);
+		baby_to_cl(bf.baby_cl, bf.cl, bf.baby_time, j % bf.cl.time_steps);
+	}
+	return (double)steps * bf.sd->cells_total;
+}
+
+/* bench_pearson_correlation correlates every cell's her1 mRNA levels with the first cell's
+	parameters:
+		bf: the fixture
+		steps: the number of time steps in each series
+	returns: the number of cell-steps (samples) correlated
+	notes:
+	todo:
+*/
+double bench_pearson_correlation (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	for (int k = 0; k < sd.cells_total; k++) {
+		pearson_correlation(bf.series[0], bf.series[k], 0, steps);
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_peaks_and_troughs finds the peaks and troughs of every cell's levels of the five species the anterior features analyze
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to search
+	returns: the number of cell-steps searched
+	notes:
+		Every species is searched in the same sweep over time, as osc_features_ant does, so each cell-step covers all five.
+	todo:
+*/
+double bench_peaks_and_troughs (bench_fixture& bf, int steps) {
+	static const int cons[5] = {CMH1, CMH7, CMDELTA, CMMESPA, CMMESPB};
+	sim_data& sd = *(bf.sd);
+	sd.time_end = steps;
+	int cells[sd.cells_total];
+	int time_starts[sd.cells_total];
+	for (int k = 0; k < sd.cells_total; k++) {
+		cells[k] = k;
+		time_starts[k] = 0;
+	}
+	sd.scratch.reset();
+	peak_set ps(5, sd.cells_total, steps / (20 / sd.step_size) + 1, sd.scratch);
+	peaks_task pt;
+	pt.sd = &sd;
+	pt.cl = &(bf.cl);
+	pt.cells = cells;
+	pt.time_starts = time_starts;
+	pt.num_cells = sd.cells_total;
+	pt.cons = cons;
+	pt.num_cons = 5;
+	pt.ps = &ps;
+	pt.record_cons = NULL;
+	pt.num_records = 0;
+	pt.records = NULL;
+	pt.record_length = 0;
+	get_peaks_and_troughs(pt, 0, sd.cells_total, sd.scratch);
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_wave_testing counts the her1 mRNA waves across the tissue at every time step
+	parameters:
+		bf: the fixture
+		steps: the number of time steps to test
+	returns: the number of cell-steps tested
+	notes:
+		The fixture's mutant uses bench_wave_test, so only the wave counting is timed.
+	todo:
+*/
+double bench_wave_testing (bench_fixture& bf, int steps) {
+	sim_data& sd = *(bf.sd);
+	for (int j = 0; j < steps; j++) {
+		wave_testing(sd, bf.cl, bf.md, j, CMH1, sd.active_start);
+	}
+	return (double)steps * sd.cells_total;
+}
+
+/* bench_wave_test stands in for a mutant's traveling wave conditions test
+	parameters:
+		waves: the start and end of every wave found
+		num_waves: the number of waves found
+		md: the mutant's data
+		wlength_post: the length of the posterior wave
+		wlength_ant: the length of the anterior wave
+	returns: 0
+	notes:
+		The real tests print to cout, which would dwarf the wave counting being timed.
+	todo:
+*/
+int bench_wave_test (pair<int, int> waves[], int num_waves, mutant_data& md, int wlength_post, int wlength_ant) {
+	return 0;
+}
+
+/* usage prints the benchmarks' usage information and, optionally, an error message and then exits
+	parameters:
+		message: an error message to print before the usage information (set message to NULL or "\0" to not print any error)
+	returns: nothing
+	notes:
+		This replaces the simulation's usage in main.cpp, which the benchmarks do not link.
+	todo:
+*/
+void usage (const char* message) {
+	cout << endl;
+	bool error = message != NULL && message[0] != '\0';
+	if (error) {
+		cout << term->red << message << term->reset << endl << endl;
+	}
+	cout << "Usage: [-option [value]]. . . [--option [value]]. . ." << endl;
+	cout << "-x, --total-width        [int]        : the tissue width in cells, min=3, default=50" << endl;
+	cout << "-y, --height             [int]        : the tissue height in cells of the 2D fixtures, min=2, default=4" << endl;
+	cout << "-S, --step-size          [float]      : the size of the timestep, default=0.01" << endl;
+	cout << "-n, --steps              [int]        : the number of time steps (or calls) each repetition runs, min=1, default=3000" << endl;
+	cout << "-r, --repetitions        [int]        : the number of timed repetitions of each kernel, min=1, default=5" << endl;
+	cout << "-w, --warmup             [int]        : the number of untimed repetitions before timing each kernel, min=0, default=1" << endl;
+	cout << "-s, --seed               [int]        : the seed to generate random numbers, min=1, default=1" << endl;
+	cout << "-k, --kernel             [name]       : run only the given kernel, default=none (run every kernel)" << endl;
+	cout << "-l, --licensing          [N/A]        : view licensing information (no benchmarks will be run)" << endl;
+	cout << "-h, --help               [N/A]        : view usage information (i.e. this)" << endl;
+	cout << endl << "Kernels:";
+	for (int i = 0; i < num_kernels; i++) {
+		cout << " " << kernels[i].name;
+	}
+	cout << endl;
+	cout << endl << term->blue << "Example: ./bench -x 50 -y 16 -k mRNA_synthesis_2d" << term->reset << endl << endl;
+	if (error) {
+		exit(EXIT_INPUT_ERROR);
+	} else {
+		exit(EXIT_SUCCESS);
+	}
+}
+
+/* licensing prints the program's copyright and licensing information and then exits
+	parameters:
+	returns: nothing
+	notes:
+	todo:
+*/
+void licensing () {
+	cout << endl;
+	cout << "Simulation for zebrafish segmentation" << endl;
+	cout << "Copyright (C) 2013 Ahmet Ay (aay@colgate.edu), Jack Holland (jholland@colgate.edu), Adriana Sperlea (asperlea@colgate.edu), Sebastian Sangervasi (ssangervasi@colgate.edu)" << endl;
+	cout << "This program comes with ABSOLUTELY NO WARRANTY" << endl;
+	cout << "This is free software, and you are welcome to redistribute it under certain conditions;" << endl;
+	cout << "You can use this code and modify it as you wish under the condition that you refer to the article: \"Short-lived Her proteins drive robust synchronized oscillations in the zebrafish segmentation clock\" (Development 2013 140:3244-3253; doi:10.1242/dev.093278)" << endl;
+	cout << endl;
+	exit(EXIT_SUCCESS);
+}
+
@@ -0,0 +1,118 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+bench.hpp contains function declarations for bench.cpp as well as the structs only the benchmarks use.
+*/
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "structs.hpp"
+
+using namespace std;
+
+#define BENCH_PERIOD 30 // The period in minutes of the synthetic oscillations in each fixture's cl
+
+/* bench_params contains the benchmarks' command-line arguments
+	notes:
+	todo:
+*/
+struct bench_params {
+	int width; // The tissue width in cells of every fixture, default=50
+	int height; // The tissue height in cells of the 2D fixtures, default=4
+	double step_size; // The time step in minutes, default=0.01
+	int steps; // The number of time steps (or calls) each repetition runs, default=3000
+	int reps; // The number of timed repetitions of each kernel, default=5
+	int warmup; // The number of untimed repetitions run before timing each kernel, default=1
+	int seed; // The seed used for random numbers (only split draws any), default=1
+	char* kernel; // The name of the only kernel to run, default=none (run every kernel)
+
+	bench_params () {
+		this->width = 50;
+		this->height = 4;
+		this->step_size = 0.01;
+		this->steps = 3000;
+		this->reps = 5;
+		this->warmup = 1;
+		this->seed = 1;
+		this->kernel = NULL;
+	}
+
+	~bench_params () {
+		mfree(this->kernel);
+	}
+};
+
+/* bench_fixture contains the synthetic simulation state a kernel is benchmarked on
+	notes:
+		Every kernel gets a freshly created fixture so no kernel sees the state another one left behind.
+		baby_cl is filled with smooth positive concentrations and birth and parent records that make index_with_splits follow a realistic number of parents. cl holds oscillating mRNA levels with a traveling phase across the columns for the feature kernels.
+	todo:
+*/
+struct bench_fixture {
+	input_params ip; // Input parameters the simulation data are created from
+	sim_data* sd; // The fixture's simulation data
+	rates* rs; // The fixture's rates, taken from the built-in parameter set
+	con_levels baby_cl; // The concentration levels for simulating (cyclical over the maximum delay)
+	con_levels cl; // The concentration levels for analysis, one time step per benchmark step
+	mutant_data md; // A wildtype mutant
+	double** series; // A copy of every cell's her1 mRNA levels in cl, contiguous in time
+	int baby_time; // The current time step in baby_cl
+	int time; // The absolute time step the birth records are relative to
+
+	bench_fixture () {
+		this->sd = NULL;
+		this->rs = NULL;
+		this->series = NULL;
+		this->baby_time = 0;
+		this->time = 0;
+	}
+};
+
+/* bench_kernel describes one benchmark
+	notes:
+		run performs the given number of steps and returns how many cell-steps that was, which is what the reported times are divided by.
+	todo:
+*/
+struct bench_kernel {
+	const char* name; // The name to print and select the kernel by
+	bool two_d; // Whether the kernel runs on a 2D fixture (true) or a 1D one (false)
+	double (*run)(bench_fixture&, int); // The function that runs the kernel
+};
+
+void accept_bench_params(int, char**, bench_params&);
+bench_fixture* create_fixture(bench_params&, bool);
+void delete_fixture(bench_fixture*);
+int advance_time(bench_fixture&);
+void time_kernel(bench_params&, const bench_kernel&);
+double bench_con_protein_her(bench_fixture&, int);
+double bench_dimer_proteins(bench_fixture&, int);
+double bench_mrna_synthesis(bench_fixture&, int);
+double bench_delay_indices(bench_fixture&, int);
+double bench_update_rates(bench_fixture&, int);
+double bench_update_rates_gradients(bench_fixture&, int);
+double bench_split(bench_fixture&, int);
+double bench_baby_to_cl(bench_fixture&, int);
+double bench_pearson_correlation(bench_fixture&, int);
+double bench_peaks_and_troughs(bench_fixture&, int);
+double bench_wave_testing(bench_fixture&, int);
+int bench_wave_test(pair<int, int>[], int, mutant_data&, int, int);
+
+#endif
+
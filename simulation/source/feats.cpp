@@ -26,6 +26,8 @@ feats.cpp contains functions to analyze and test the oscillation features of sim
 
 #include "io.hpp"
 #include "sim.hpp"
+#include "profile.hpp"
+#include "threads.hpp"
 
 using namespace std;
 
@@ -37,112 +39,93 @@ In the future need to find a way to unify the functions in this file into some m
 For the time being, I'm focusing on obtaining the needed data.
 
 */
-int get_peaks_and_troughs1 (sim_data& sd, con_levels& cl, int actual_cell, int time_start, growin_array& crit_points, growin_array& type, growin_array& position, int mr) {
+void get_peaks_and_troughs (peaks_task& pt, int first_cell, int end_cell, scratch_arena& scratch) {
 	/*
-	Calculates all the peaks and troughs for the her1 mRNA oscillations in a cell within a time range. The cell number is given as a
-	number relative to the entire PSM.
+	Calculates all the peaks and troughs of the task's concentrations' oscillations in the task's cells from first_cell up to end_cell in a single
+	sweep over time. Each cell is analyzed from the time step after its start until it splits or the simulation ends, and a point is a peak (trough)
+	if it is higher (lower) than every other point within 2 minutes of it that is not before the cell's start.
+	Sweeping every cell and concentration at each time step reads each time step of cl once instead of once per concentration and cell.
+	Only the given cells' slots of the task's peak set and records are written and any memory needed is borrowed from scratch, so workers can
+	analyze different cells at the same time.
 	*/
-	int num_points = 0;
-	int col = actual_cell % sd.width_total;
+	sim_data& sd = *(pt.sd);
+	con_levels& cl = *(pt.cl);
+	int* cells = pt.cells;
+	int* time_starts = pt.time_starts;
+	const int* cons = pt.cons;
+	int num_cons = pt.num_cons;
+	peak_set& ps = *(pt.ps);
+	const int* record_cons = pt.record_cons;
+	int num_records = pt.num_records;
+	double* records = pt.records;
+	int record_length = pt.record_length;
 	
-	double** conc = cl.cons[mr];
-	for (int j = time_start + 1; j < sd.time_end - 1 && cl.cons[BIRTH][j][actual_cell] == cl.cons[BIRTH][j - 1][actual_cell] && cl.cons[BIRTH][j][actual_cell] == cl.cons[BIRTH][j + 1][actual_cell]; j++) {
-		
-		int pos = 0;
-		if (cl.active_start_record[j] >= col) {
-			pos = cl.active_start_record[j] - col;
-		} else {
-			pos = cl.active_start_record[j] + sd.width_total - col;
-		}
+	bool* analyzing = scratch.borrow_array<bool>(end_cell - first_cell); // Whether each cell is still being analyzed, from first_cell on
+	int num_analyzing = end_cell - first_cell;
+	int first_time = sd.time_end;
+	for (int i = first_cell; i < end_cell; i++) {
+		analyzing[i - first_cell] = true;
+		ps.initialize_cell(i, scratch);
+		first_time = MIN(first_time, time_starts[i] + 1);
+	}
 	
-		// check if the current point is a peak
-		bool is_peak = true;
-		for (int k = MAX(j - (2 / sd.step_size / sd.big_gran), time_start); k <= MIN(j + 2 / sd.step_size / sd.big_gran, sd.time_end - 1); k++) {
-			if (conc[j][actual_cell] <= conc[k][actual_cell] && j!=k) {
-				is_peak = false;
+	double** birth = cl.cons[BIRTH];
+	for (int j = first_time; j < sd.time_end - 1 && num_analyzing > 0; j++) {
+		for (int i = first_cell; i < end_cell; i++) {
+			int cell = cells[i];
+			if (!analyzing[i - first_cell] || j <= time_starts[i]) {
+				continue;
 			}
-		}
-		if (is_peak) {
-			crit_points[num_points] = j;
-			type[num_points] = 1;
-			position[num_points] = pos;
-			num_points++;
-		}
-		
-		// check if the current point is a trough
-		bool is_trough = true;
-		for (int k = MAX(j - (2 / sd.step_size / sd.big_gran), time_start); k <= MIN(j + 2 / sd.step_size / sd.big_gran, sd.time_end - 1); k++) {
-			if (conc[j][actual_cell] >= conc[k][actual_cell] && j!=k) {
-				is_trough = false;
+			
+			// stop analyzing the cell once it splits
+			if (birth[j][cell] != birth[j - 1][cell] || birth[j][cell] != birth[j + 1][cell]) {
+				analyzing[i - first_cell] = false;
+				num_analyzing--;
+				continue;
 			}
-		}
-		if (is_trough) {
-			crit_points[num_points] = j;
-			type[num_points] = -1;
-			position[num_points] = pos;
-			num_points++;
-		}
-	}
-	//cout<<max-min<<endl;
-	return num_points;
-}
-
-
-int get_peaks_and_troughs2 (sim_data& sd, con_levels& cl, int actual_cell, int time_start, growin_array& crit_points, growin_array& type, growin_array& position, int mr, double* mh1_comp, double* mespa_comp, double* mespb_comp) {
-	/*
-	151221: record the concentration value of mh1, mespa, mespb in the time specified in order to calculate the complementary expression score of mespa and mespb. 
-	*/
-	int num_points = 0;
-	int col = actual_cell % sd.width_total;
-	
-	double** conc = cl.cons[mr];
-	int compl_count=0;
-	for (int j = time_start + 1; j < sd.time_end - 1 && cl.cons[BIRTH][j][actual_cell] == cl.cons[BIRTH][j - 1][actual_cell] && cl.cons[BIRTH][j][actual_cell] == cl.cons[BIRTH][j + 1][actual_cell]; j++) {
-		// calculate position in the PSM of the cell
-		
-		mh1_comp[compl_count]=cl.cons[CMH1][j][actual_cell];                 //record concentration value of mh1 151221
-		mespa_comp[compl_count]=cl.cons[CMMESPA][j][actual_cell];           //record concentration value of mespa 151221
-		mespb_comp[compl_count]=cl.cons[CMMESPB][j][actual_cell];             //record concentration value of mespb 151221
-		compl_count++;
-		
-		int pos = 0;
-		if (cl.active_start_record[j] >= col) {
-			pos = cl.active_start_record[j] - col;
-		} else {
-			pos = cl.active_start_record[j] + sd.width_total - col;
-		}
-	
-		// check if the current point is a peak
-		bool is_peak = true;
-		for (int k = MAX(j - (2 / sd.step_size / sd.big_gran), time_start); k <= MIN(j + 2 / sd.step_size / sd.big_gran, sd.time_end - 1); k++) {
-			if (conc[j][actual_cell] <= conc[k][actual_cell] && j!=k) {
-				is_peak = false;
-				
+			
+			// calculate position in the PSM of the cell
+			int col = cell % sd.width_total;
+			int pos = 0;
+			if (cl.active_start_record[j] >= col) {
+				pos = cl.active_start_record[j] - col;
+			} else {
+				pos = cl.active_start_record[j] + sd.width_total - col;
 			}
-		}
-		if (is_peak) {
-			crit_points[num_points] = j;
-			type[num_points] = 1;
-			position[num_points] = pos;
-			num_points++;
-		}
-		
-		// check if the current point is a trough
-		bool is_trough = true;
-		for (int k = MAX(j - (2 / sd.step_size / sd.big_gran), time_start); k <= MIN(j + 2 / sd.step_size / sd.big_gran, sd.time_end - 1); k++) {
-			if (conc[j][actual_cell] >= conc[k][actual_cell] && j!=k) {
-				is_trough = false;
+			
+			if (records != NULL) {
+				for (int r = 0; r < num_records; r++) {
+					records[(i * num_records + r) * record_length + ps.lengths[i]] = cl.cons[record_cons[r]][j][cell];
+				}
+			}
+			ps.lengths[i]++;
+			
+			// check if the current point is a peak or a trough of each concentration
+			int window_start = MAX(j - (2 / sd.step_size / sd.big_gran), time_starts[i]);
+			int window_end = MIN(j + 2 / sd.step_size / sd.big_gran, sd.time_end - 1);
+			for (int c = 0; c < num_cons; c++) {
+				double** conc = cl.cons[cons[c]];
+				bool is_peak = true;
+				bool is_trough = true;
+				for (int k = window_start; k <= window_end && (is_peak || is_trough); k++) {
+					if (k != j) {
+						if (conc[j][cell] <= conc[k][cell]) {
+							is_peak = false;
+						}
+						if (conc[j][cell] >= conc[k][cell]) {
+							is_trough = false;
+						}
+					}
+				}
+				if (is_peak) {
+					ps.add(ps.index(c, i), j, 1, pos);
+				}
+				if (is_trough) {
+					ps.add(ps.index(c, i), j, -1, pos);
+				}
 			}
-		}
-		if (is_trough) {
-			crit_points[num_points] = j;
-			type[num_points] = -1;
-			position[num_points] = pos;
-			num_points++;
 		}
 	}
-	//cout<<max-min<<endl;
-	return num_points;
 }
 
 double test_complementary (sim_data& sd, con_levels& cl, int time, int con1, int con2) {   // calculate the complementary expression score of mespa and mespb. not used
@@ -171,6 +154,57 @@ double test_compl(sim_data& sd, double* con1, double* con2) {  // 151221: calcul
 	return pearson_correlation(con1, con2, (int)(0.6*(sd.width_total*sd.steps_split - 2)),sd.width_total*sd.steps_split - 2);   
 }
 
+void find_peaks_task (void* arg, int worker) {
+	/*
+	Runs get_peaks_and_troughs on the worker's share of the cells of the given peaks_task.
+	*/
+	peaks_task& pt = *(peaks_task*)arg;
+	int first_cell, end_cell;
+	worker_range(worker, num_workers(*(pt.sd)), pt.num_cells, &first_cell, &end_cell);
+	get_peaks_and_troughs(pt, first_cell, end_cell, worker_scratch(*(pt.sd), worker));
+}
+
+void comp_scores_task (void* arg, int worker) {
+	/*
+	151221: scores the complementary expression of mespa and mespb with mh1 in the worker's share of the cells of the given peaks_task, using the
+	mh1, mespa and mespb levels get_peaks_and_troughs recorded. Each cell is scored on buffers holding its own levels followed by whatever the
+	earlier cells left beyond them, as if every cell had been copied into the same buffers in order, so the scores do not depend on the workers.
+	A worker seeds its buffers with what the cells before its share would have left there, copying each position once from the last of those
+	cells that reached it, rather than copying every earlier cell.
+	*/
+	peaks_task& pt = *(peaks_task*)arg;
+	sim_data& sd = *(pt.sd);
+	int first_cell, end_cell;
+	worker_range(worker, num_workers(sd), pt.num_cells, &first_cell, &end_cell);
+	if (first_cell == end_cell) {
+		return;
+	}
+	
+	scratch_arena& scratch = worker_scratch(sd, worker);
+	int size = sd.width_total * sd.steps_split - 2;
+	double* comp[3]; // The mh1, mespa and mespb levels
+	for (int r = 0; r < 3; r++) {
+		comp[r] = scratch.borrow_array<double>(size);
+		memset(comp[r], 0, sizeof(double) * size);
+	}
+	for (int c = first_cell - 1, covered = 0; c >= 0 && covered < size; c--) { // Positions before covered were left by a later cell
+		int length = pt.ps->lengths[c];
+		if (length > covered) {
+			for (int r = 0; r < 3; r++) {
+				memcpy(comp[r] + covered, pt.records + (c * 3 + r) * pt.record_length + covered, sizeof(double) * (length - covered));
+			}
+			covered = length;
+		}
+	}
+	for (int c = first_cell; c < end_cell; c++) {
+		for (int r = 0; r < 3; r++) {
+			memcpy(comp[r], pt.records + (c * 3 + r) * pt.record_length, sizeof(double) * pt.ps->lengths[c]);
+		}
+		pt.comp_scores[0][c] = test_compl(sd, comp[0], comp[1]);
+		pt.comp_scores[1][c] = test_compl(sd, comp[0], comp[2]);
+	}
+}
+
 
 
 void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* filename_feats, con_levels& cl, mutant_data& md, int start_line, int end_line, int start_col, int end_col, int set_num) {
@@ -180,37 +214,66 @@ void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* f
 	static const char* feat_names[NUM_FEATURES] = {"period", "amplitude", "sync"};
 	static double curve[101] = {1, 1.003367003, 1.003367003, 1.003367003, 1.004713805, 1.004713805, 1.007407407, 1.015488215, 1.015488215, 1.020875421, 1.023569024, 1.023569024, 1.026262626, 1.028956229, 1.037037037, 1.037037037, 1.03973064, 1.042424242, 1.047811448, 1.050505051, 1.055892256, 1.058585859, 1.061279461, 1.066666667, 1.069360269, 1.072053872, 1.077441077, 1.082828283, 1.088215488, 1.090909091, 1.096296296, 1.098989899, 1.104377104, 1.10976431, 1.115151515, 1.115151515, 1.120538721, 1.125925926, 1.128619529, 1.139393939, 1.142087542, 1.15016835, 1.155555556, 1.160942761, 1.169023569, 1.174410774, 1.182491582, 1.187878788, 1.195959596, 1.201346801, 1.212121212, 1.22020202, 1.228282828, 1.239057239, 1.247138047, 1.255218855, 1.268686869, 1.276767677, 1.287542088, 1.301010101, 1.314478114, 1.325252525, 1.336026936, 1.352188552, 1.368350168, 1.381818182, 1.397979798, 1.414141414, 1.432996633, 1.454545455, 1.476094276, 1.492255892, 1.519191919, 1.546127946, 1.573063973, 1.6, 1.632323232, 1.672727273, 1.705050505, 1.742760943, 1.785858586, 1.837037037, 1.896296296, 1.955555556, 2.025589226, 2.106397306, 2.195286195, 2.303030303, 2.418855219, 2.572390572, 2.725925926, 2.941414141, 3.208080808, 3.574410774, 4, 8.399297321, 12.79859464, 17.19789196, 21.59718928, 25.99648661, 30.39578393};
 	
-	growin_array crit_points(sd.steps_total / (20/sd.step_size)); // Array that will hold all the critical points in the graph
-	growin_array type(sd.steps_total / (20/sd.step_size)); // Array that will specify whether each critical point is a peak or a trough (-1 for trough, 1 for peak)
-	growin_array position(sd.steps_total / (20/sd.step_size)); // Array that will hold the position in the PSM of the critical points
-	
-	int strlen_set_num = INT_STRLEN(set_num); // How many bytes the ASCII representation of set_num takes
-	char* str_set_num = (char*)mallocate(sizeof(char) * (strlen_set_num + 1));
-	sprintf(str_set_num, "%d", set_num);
+	scratch_arena& scratch = sd.scratch; // Every buffer below is borrowed from the arena, which takes them back before the next mutant is analyzed
 	
 	int num_cell = (end_line - start_line) * (end_col - start_col);
-	double mh1_comp[sd.width_total*sd.steps_split - 2];   //151221: structure to store concentration value for mh1, used in get_peaks_and_troughs2 
-	double mespa_comp[sd.width_total*sd.steps_split - 2]; //151221: structure to store concentration value for mespa, used in get_peaks_and_troughs2
-	double mespb_comp[sd.width_total*sd.steps_split - 2]; //151221: structure to store concentration value for mespb, used in get_peaks_and_troughs2
 	double comp_score_a = 0; //151221: complementary score for mespa
 	double comp_score_b = 0; //151221: complementary score for mespa
-	memset(mh1_comp, 0, sizeof(double) * (sd.width_total*sd.steps_split - 2));
-	memset(mespa_comp, 0, sizeof(double) * (sd.width_total*sd.steps_split - 2));
-	memset(mespb_comp, 0, sizeof(double) * (sd.width_total*sd.steps_split - 2));
 	
+	// Find the peaks and troughs of every species in every cell in one sweep, recording mh1, mespa and mespb for the complementary scores
+	int* cells = scratch.borrow_array<int>(num_cell); // The cells to analyze, the newest cell of each line when each column was formed
+	int* time_starts = scratch.borrow_array<int>(num_cell); // The time step after which each cell is analyzed
+	int time_start = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial) * sd.steps_split); // time after which the PSM is full of cells
+	for (int col = start_col, c = 0; col < end_col; col++) {
+		for (int line = start_line; line < end_line; line++, c++) {
+			cells[c] = line * sd.width_total + cl.active_start_record[time_start]; // always looking at cell at position active_start because that is the newest cell
+			time_starts[c] = time_start;
+		}
+		time_start += sd.steps_split / sd.big_gran; // skip in time until a new column of cells has been formed
+	}
+	static const int comp_cons[3] = {CMH1, CMMESPA, CMMESPB};
+	int record_length = MAX(sd.time_end - time_starts[0], 1);
+	peak_set ps(5, num_cell, sd.steps_total / (20/sd.step_size), scratch);
+	peaks_task pt;
+	pt.sd = &sd;
+	pt.cl = &cl;
+	pt.cells = cells;
+	pt.time_starts = time_starts;
+	pt.num_cells = num_cell;
+	pt.cons = con;
+	pt.num_cons = 5;
+	pt.ps = &ps;
+	pt.record_cons = comp_cons;
+	pt.num_records = 3;
+	pt.records = scratch.borrow_array<double>(num_cell * 3 * record_length);
+	pt.record_length = record_length;
+	pt.comp_scores[0] = scratch.borrow_array<double>(num_cell);
+	pt.comp_scores[1] = scratch.borrow_array<double>(num_cell);
+	run_in_pool(sd, find_peaks_task, &pt); // The cells are split between the analysis threads, if any
+	run_in_pool(sd, comp_scores_task, &pt);
+	
+	// The period and amplitude buffers are sized for the cell with the most critical points and reused for every cell
+	int max_points = 0;
+	for (int k = 0; k < 5 * num_cell; k++) {
+		max_points = MAX(max_points, ps.num_points[k]);
+	}
+	double* periods = scratch.borrow_array<double>(max_points);
+	double* per_pos = scratch.borrow_array<double>(max_points);
+	double* per_time = scratch.borrow_array<double>(max_points);
+	double* amplitudes = scratch.borrow_array<double>(max_points);
+	double* amp_pos = scratch.borrow_array<double>(max_points);
 	
 	for (int i = 0; i < 5; i++) {
-		ofstream features_files[NUM_FEATURES]; // Array that will hold the files in which to output the period and amplitude
+		output_file features_files[NUM_FEATURES]; // Array that will hold the files in which to output the period and amplitude
 	
 		int mr = con[i];
 		int index = ind[i];
 		if (ip.ant_features) {
 			for (int j = 0; j < NUM_FEATURES; j++) {
-				char* filename = (char*)mallocate(sizeof(char) * strlen(filename_feats) + strlen("set_") + strlen_set_num + 1 + strlen(feat_names[j]) + 1 + strlen(concs[i]) + strlen("_ant.feats") + 1);
-				sprintf(filename, "%sset_%s_%s_%s_ant.feats", filename_feats, str_set_num, feat_names[j], concs[i]);
+				char* type = scratch.borrow_array<char>(1 + strlen(feat_names[j]) + 1 + strlen(concs[i]) + strlen("_ant.feats") + 1);
+				sprintf(type, "_%s_%s_ant.feats", feat_names[j], concs[i]);
 				cout << "      ";
-				open_file(&(features_files[j]), filename, false);
-				mfree(filename);
+				open_set_output(&(features_files[j]), filename_feats, set_num, type, false);
 			}
 			
 			features_files[PERIOD] << sd.height << "," << sd.width_total << endl;
@@ -219,34 +282,21 @@ void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* f
 		double** conc = cl.cons[mr];
 		double amp_avg = 0;
 		double period_avg = 0;
-        int time_start;
-        if (md.induction == 0) {
-		    time_start = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial) * sd.steps_split); // time after which the PSM is full of cells
-        } else {
-            //time_start = anterior_time(sd, md.induction + (30 / sd.big_gran));
-			time_start = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial) * sd.steps_split);//anterior_time(sd, sd.steps_til_growth + (30 / sd.step_size));
-        }
 		int num_cells_passed = 0;
 		
-		for (int col = start_col; col < end_col; col++) {						
-			for (int line = start_line; line < end_line; line++) {
-				int pos = cl.active_start_record[time_start]; // always looking at cell at position active_start because that is the newest cell
-				int cell = line * sd.width_total + pos;
-				int num_points = 0;
-                if ( mr != CMMESPA) {
-				    num_points = get_peaks_and_troughs1(sd, cl, cell, time_start, crit_points, type, position, mr);
-                } else {
-					
-					num_points = get_peaks_and_troughs2(sd, cl, cell, time_start, crit_points, type, position, mr, mh1_comp, mespa_comp, mespb_comp);  // 151221: get_peaks_and_troughs2 records the concentration value of mh1, mespa and mespb and store them in mh1_comp, mespa_comp, mespb_comp
-					comp_score_a+=test_compl(sd, mh1_comp, mespa_comp);
-					comp_score_b+=test_compl(sd, mh1_comp, mespb_comp);
+		for (int col = start_col, c = 0; col < end_col; col++) {						
+			for (int line = start_line; line < end_line; line++, c++) {
+				int cell = cells[c];
+				int num_points = ps.num_points[ps.index(i, c)];
+				growin_array& crit_points = ps.times[ps.index(i, c)];
+				growin_array& type = ps.types[ps.index(i, c)];
+				growin_array& position = ps.positions[ps.index(i, c)];
+				PROFILE_COUNT(COUNT_FEATURES, 1);
+                if (mr == CMMESPA) {
+					comp_score_a+=pt.comp_scores[0][c]; // 151221: scored by comp_scores_task
+					comp_score_b+=pt.comp_scores[1][c];
 				} 
 			
-				double periods[num_points];
-				double per_pos[num_points];
-                double per_time[num_points];
-				double amplitudes[num_points];
-				double amp_pos[num_points];
                 //double amp_time[num_points]; // amp_time is not used in the new calculation methods
 				memset(periods, 0, sizeof(double) * num_points);
 				memset(amplitudes, 0, sizeof(double) * num_points);
@@ -369,15 +419,11 @@ void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* f
                     	}
 					}
                 }*/
-
-				type.reset(sd.steps_total / (20/sd.step_size));
-				crit_points.reset(sd.steps_total / (20/sd.step_size));
-			}		
-			time_start += sd.steps_split / sd.big_gran; // skip in time until a new column of cells has been formed
+			}
 		}
 		if (ip.ant_features) {
-			features_files[PERIOD].close();
-			features_files[AMPLITUDE].close();
+			close_output(&features_files[PERIOD]);
+			close_output(&features_files[AMPLITUDE]);
 		}
 
 		amp_avg /= (end_line - start_line) * (end_col - start_col);
@@ -586,7 +632,7 @@ void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* f
 				}
 				time_start += sd.steps_split;
 			}
-			features_files[SYNC].close();
+			close_output(&features_files[SYNC]);
 		}
 		if (index == IMMESPA) { //151221: complementary score for mespa and mespb
 			// for complementary mesp expression take 6 snapshots and average comp score
@@ -608,7 +654,332 @@ void osc_features_ant (sim_data& sd, input_params& ip, features& wtfeat, char* f
 		} 
 		//md.feat.sync_score_ant[index] = sync_avg / 5; // JY bug?
 	}
-	mfree(str_set_num);
+}
+
+void post_sweep_task (void* arg, int worker) {
+	/*
+	Finds the peaks and troughs of every gene of the given post_task in the worker's share of the posterior cells in a single sweep over time,
+	averaging each cell's period while its amplitude stays above 0.3 of the wild type's (or, for the wild type, of its first oscillation's).
+	Each gene and cell's progress is kept separately and its arrays are grown in the worker's scratch arena, so workers can sweep different cells at the same time.
+	*/
+	post_task& pt = *(post_task*)arg;
+	sim_data& sd = *(pt.sd);
+	con_levels& cl = *(pt.cl);
+	features& wtfeat = *(pt.wtfeat);
+	int first_cell, end_cell;
+	worker_range(worker, num_workers(sd), pt.cells, &first_cell, &end_cell);
+	scratch_arena& scratch = worker_scratch(sd, worker);
+	
+	growin_array* peaks = pt.peaks;
+	growin_array* troughs = pt.troughs;
+	growin_array* trough_peaks = pt.trough_peaks;
+	int* num_peaks = pt.num_peaks;
+	int* num_troughs = pt.num_troughs;
+	int* peaks_period = pt.peaks_period;
+	double* cell_period = pt.cell_period;
+	bool* calc_period = pt.calc_period;
+	bool* stopped = pt.stopped;
+	for (int i = 0; i < pt.num_genes; i++) {
+		for (int p = first_cell; p < end_cell; p++) {
+			int s = i * pt.cells + p;
+			peaks[s].initialize(sd.steps_total / (20/sd.step_size), scratch);
+			troughs[s].initialize(sd.steps_total / (20/sd.step_size), scratch);
+			trough_peaks[s].initialize(sd.steps_total / (20/sd.step_size), scratch);
+			num_peaks[s] = 0;
+			num_troughs[s] = 0;
+			peaks_period[s] = 0;
+			cell_period[s] = 0;
+			calc_period[s] = true;
+			stopped[s] = false;
+		}
+	}
+
+	for (int j = pt.start + 1; j < pt.end - 1; j++) {
+		for (int i = 0; i < pt.num_genes; i++) {
+			int mr = pt.cons[i];
+			double** conc = cl.cons[mr];
+			for (int p = first_cell; p < end_cell; p++) {
+				int cell = (p / sd.width_current) * sd.width_total + p % sd.width_current;
+				int s = i * pt.cells + p;
+				if (stopped[s]) {
+					continue;
+				}
+				if (abs(num_peaks[s] - num_troughs[s]) > 1) {
+					num_peaks[s] = 0;
+					stopped[s] = true;
+					continue;
+				}
+				
+				//check if the current point is a peak
+				if (conc[j - 1][cell] < conc[j][cell] && conc[j][cell] > conc[j + 1][cell]) {
+					peaks[s][num_peaks[s]] = j;
+					num_peaks[s]++;
+					if (calc_period[s]) {
+						peaks_period[s]++;
+					}
+					
+					// add the current period to the average calculation
+					if (num_peaks[s] >= 2 && calc_period[s]) {
+						double period = (peaks[s][num_peaks[s] - 1] - peaks[s][num_peaks[s] - 2]) * sd.step_size * sd.big_gran;
+						cell_period[s] += period;
+					}
+				}
+				
+				//check if the current point is a trough
+				if (conc[j - 1][cell] > conc[j][cell] && conc[j][cell] < conc[j + 1][cell]) {
+					troughs[s][num_troughs[s]] = j;
+					trough_peaks[s][num_troughs[s]] = num_peaks[s];
+					num_troughs[s]++;
+					
+					//check if the amplitude has dropped under 0.3 of the wildtype amplitude
+					if (num_troughs[s] >= 2) {
+						int last_peak = peaks[s][num_peaks[s] - 1];
+						int last_trough = troughs[s][num_troughs[s] - 1];
+						int sec_last_trough = troughs[s][num_troughs[s] - 2];
+						
+						double first_amp = peaks[s][1] - (troughs[s][0] + troughs[s][1]) / 2;
+						double cur_amp = conc[last_peak][cell] - (conc[last_trough][cell] + conc[sec_last_trough][cell]) / 2;
+						if (cur_amp < (wtfeat.amplitude_post[mr] > 0 ? 0.3 * wtfeat.amplitude_post[mr] : 0.3 * first_amp)) {
+							calc_period[s] = false;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void spectral_sweep_task (void* arg, int worker) {
+	/*
+	Estimates the dominant period and amplitude of every gene of the given spectral_task in the worker's share of the posterior cells, one half of
+	the analyzed time at a time. Each sample updates every filter of a fixed bank, so the cost depends only on the tissue and the number of time steps
+	and not on how well the cells oscillate. The strongest filter and its neighbors are fit with a parabola in log magnitude to estimate the frequency
+	and magnitude between filters.
+	*/
+	spectral_task& st = *(spectral_task*)arg;
+	sim_data& sd = *(st.sd);
+	con_levels& cl = *(st.cl);
+	int first_cell, end_cell;
+	worker_range(worker, num_workers(sd), st.cells, &first_cell, &end_cell);
+	int num_local = end_cell - first_cell;
+	if (num_local == 0) {
+		return;
+	}
+	
+	scratch_arena& scratch = worker_scratch(sd, worker);
+	int num_filters = st.num_filters;
+	int num_series = st.num_genes * num_local; // Each gene's levels in each of the worker's cells, at gene * num_local + cell - first_cell
+	double* coefs = scratch.borrow_array<double>(num_filters);
+	for (int f = 0; f < num_filters; f++) {
+		coefs[f] = 2 * cos(st.freqs[f]);
+	}
+	double* s1 = scratch.borrow_array<double>(num_series * num_filters); // The filters' last outputs
+	double* s2 = scratch.borrow_array<double>(num_series * num_filters); // The filters' second to last outputs
+	double* block = scratch.borrow_array<double>(num_series); // The sum of the levels in the current sample
+	double* offset = scratch.borrow_array<double>(num_series); // The first sample of the half, subtracted from every sample to keep the mean from leaking into the filters
+	double* sum = scratch.borrow_array<double>(num_series); // The sum of the half's samples
+	double* power = scratch.borrow_array<double>(num_filters);
+	
+	int half_steps = (st.end - st.start - 2) / 2;
+	int num_samples = half_steps / st.sample_steps;
+	double sample_minutes = st.sample_steps * sd.step_size * sd.big_gran;
+	for (int h = 0; h < 2; h++) {
+		int half_start = st.start + 1 + h * half_steps;
+		memset(s1, 0, sizeof(double) * num_series * num_filters);
+		memset(s2, 0, sizeof(double) * num_series * num_filters);
+		memset(sum, 0, sizeof(double) * num_series);
+		double window_sum = 0;
+		for (int m = 0; m < num_samples; m++) {
+			memset(block, 0, sizeof(double) * num_series);
+			for (int j = half_start + m * st.sample_steps; j < half_start + (m + 1) * st.sample_steps; j++) {
+				for (int i = 0; i < st.num_genes; i++) {
+					double* level = cl.cons[st.cons[i]][j];
+					for (int p = first_cell; p < end_cell; p++) {
+						block[i * num_local + p - first_cell] += level[(p / sd.width_current) * sd.width_total + p % sd.width_current];
+					}
+				}
+			}
+			
+			double weight = num_samples > 1 ? 0.5 - 0.5 * cos(2 * M_PI * m / (num_samples - 1)) : 1; // Hann window
+			window_sum += weight;
+			for (int n = 0; n < num_series; n++) {
+				double x = block[n] / st.sample_steps;
+				if (m == 0) {
+					offset[n] = x;
+				}
+				sum[n] += x;
+				double y = weight * (x - offset[n]);
+				double* last = s1 + n * num_filters;
+				double* second_last = s2 + n * num_filters;
+				for (int f = 0; f < num_filters; f++) {
+					double out = y + coefs[f] * last[f] - second_last[f];
+					second_last[f] = last[f];
+					last[f] = out;
+				}
+			}
+		}
+		
+		for (int i = 0; i < st.num_genes; i++) {
+			for (int p = first_cell; p < end_cell; p++) {
+				int n = i * num_local + p - first_cell;
+				int out = (i * st.cells + p) * 2 + h;
+				double* last = s1 + n * num_filters;
+				double* second_last = s2 + n * num_filters;
+				int best = 0;
+				for (int f = 0; f < num_filters; f++) {
+					power[f] = SQUARE(last[f]) + SQUARE(second_last[f]) - coefs[f] * last[f] * second_last[f];
+					if (power[f] > power[best]) {
+						best = f;
+					}
+				}
+				st.means[out] = num_samples > 0 ? sum[n] / num_samples : 0;
+				if (num_samples < 3 || power[best] <= 0 || best == 0 || best == num_filters - 1) { // The strongest response at either end of the bank means the dominant oscillation, if any, is outside the periods searched
+					st.periods[out] = INFINITY;
+					st.amplitudes[out] = 0;
+					continue;
+				}
+				
+				double delta = 0; // The estimated peak's offset from the strongest filter in filter spacings
+				double log_mag = 0.5 * log(power[best]);
+				if (power[best - 1] > 0 && power[best + 1] > 0) {
+					double left = 0.5 * log(power[best - 1]);
+					double right = 0.5 * log(power[best + 1]);
+					double curvature = left - 2 * log_mag + right;
+					if (curvature < 0) {
+						delta = 0.5 * (left - right) / curvature;
+						log_mag -= 0.25 * (left - right) * delta;
+					}
+				}
+				double freq = st.freqs[best] + delta * (st.freqs[1] - st.freqs[0]);
+				st.periods[out] = 2 * M_PI / freq * sample_minutes;
+				st.amplitudes[out] = 4 * exp(log_mag) / window_sum; // The sinusoid's amplitude is 2|X| / sum(window) and its peak to trough amplitude twice that
+			}
+		}
+	}
+}
+
+void osc_features_post_spectral (sim_data& sd, input_params& ip, con_levels& cl, features& feat, features& wtfeat, char* filename_feats, int start, int end, int set_num) {
+	/*
+	Calculates the same posterior features as osc_features_post from spectral estimates instead of peaks and troughs (see --feature-backend).
+	The first half of the analyzed time stands in for the middle of the oscillations and the second half for their end: the amplitude and the end peak
+	to trough ratio come from the second half, the middle ratio from the first, and the period averages both halves while the second half still
+	oscillates with at least 0.3 of the wild type's amplitude (or, for the wild type, of the first half's).
+	The period and amplitude files hold each cell's two halves' estimates instead of every oscillation's.
+	*/
+	scratch_arena& scratch = sd.scratch; // Every buffer below is borrowed from the arena, which takes them back before the next mutant is analyzed
+
+	int con[3] = {CMH1, CMH7, CMDELTA};
+	int ind[3] = {IMH1, IMH7, IMDELTA};
+	static const char* concs[3] = {"mh1", "mh7", "deltac"};
+	static const char* feat_names[NUM_FEATURES] = {"period", "amplitude", "sync"};
+	output_file features_files[NUM_FEATURES]; // Array that will hold the files in which to output the period and amplitude
+
+	int num_genes = 3;
+	int cells = sd.height * sd.width_current;
+	spectral_task st;
+	st.sd = &sd;
+	st.cl = &cl;
+	st.cons = con;
+	st.num_genes = num_genes;
+	st.cells = cells;
+	st.start = start;
+	st.end = end;
+	st.sample_steps = MAX((int)(SPECTRAL_SAMPLE_MINUTES / (sd.step_size * sd.big_gran) + 0.5), 1);
+	double sample_minutes = st.sample_steps * sd.step_size * sd.big_gran;
+	double half_minutes = ((end - start - 2) / 2 / st.sample_steps) * sample_minutes; // The minutes the samples of each half cover
+	st.num_filters = SPECTRAL_FILTERS;
+	st.freqs = scratch.borrow_array<double>(st.num_filters);
+	double freq_min = 2 * M_PI * sample_minutes / SPECTRAL_MAX_PERIOD;
+	double freq_max = 2 * M_PI * sample_minutes / SPECTRAL_MIN_PERIOD;
+	for (int f = 0; f < st.num_filters; f++) {
+		st.freqs[f] = freq_min + (freq_max - freq_min) * f / (st.num_filters - 1);
+	}
+	st.periods = scratch.borrow_array<double>(num_genes * cells * 2);
+	st.amplitudes = scratch.borrow_array<double>(num_genes * cells * 2);
+	st.means = scratch.borrow_array<double>(num_genes * cells * 2);
+	run_in_pool(sd, spectral_sweep_task, &st); // The cells are split between the analysis threads, if any
+
+	for (int i = 0; i < num_genes; i++) {
+		if (ip.post_features) {
+			for (int j = 0; j < NUM_FEATURES; j++) {
+				char* type = scratch.borrow_array<char>(1 + strlen(feat_names[j]) + 1 + strlen(concs[i]) + strlen("_post.feats") + 1);
+				sprintf(type, "_%s_%s_post.feats", feat_names[j], concs[i]);
+				cout << "      ";
+				open_set_output(&(features_files[j]), filename_feats, set_num, type, false);
+			}
+			
+			features_files[PERIOD] << sd.height << "," << sd.width_initial << endl;
+			features_files[AMPLITUDE] << sd.height << "," << sd.width_initial << endl;
+		}
+	
+		int mr = con[i];
+		int index = ind[i];
+
+		double period_tot = 0;
+		double amplitude = 0;
+		double peaktotrough_end = 0;
+		double peaktotrough_mid = 0; 
+		double num_good_somites = 0;
+
+		for (int p = 0; p < cells; p++) {
+			int s = (i * cells + p) * 2;
+			double* periods = st.periods + s;
+			double* amplitudes = st.amplitudes + s;
+			double* means = st.means + s;
+			PROFILE_COUNT(COUNT_FEATURES, 1);
+			
+			if (periods[0] < INFINITY && amplitudes[0] >= SPECTRAL_MIN_REL_AMP * ABS(means[0])) {
+				double cell_period = periods[0];
+				if (periods[1] < INFINITY && amplitudes[1] >= (wtfeat.amplitude_post[mr] > 0 ? 0.3 * wtfeat.amplitude_post[mr] : 0.3 * amplitudes[0])) {
+					cell_period = (periods[0] + periods[1]) / 2;
+				}
+				double peak_mid = means[0] + amplitudes[0] / 2;
+				double trough_mid = means[0] - amplitudes[0] / 2;
+				double peak_end = means[1] + amplitudes[1] / 2;
+				double trough_end = means[1] - amplitudes[1] / 2;
+				
+				period_tot += cell_period;
+				amplitude += amplitudes[1];
+				peaktotrough_end += trough_end > 1 ? peak_end / trough_end : peak_end;
+				peaktotrough_mid += trough_mid > 1 ? peak_mid / trough_mid : peak_mid;
+			} else {
+				period_tot += (period_tot < INFINITY ? INFINITY : 0);
+				amplitude ++;
+				peaktotrough_end ++;
+				peaktotrough_mid ++;
+			}
+			
+			// count the oscillations completed in each half that still oscillates
+			double cycles = 0;
+			for (int h = 0; h < 2; h++) {
+				if (periods[h] < INFINITY && amplitudes[h] >= SPECTRAL_MIN_REL_AMP * ABS(means[h])) {
+					cycles += half_minutes / periods[h];
+				}
+			}
+			num_good_somites += (int)cycles - 1;
+			if (ip.post_features) {
+				features_files[PERIOD] << periods[0] << " " << periods[1] << " ";
+				features_files[AMPLITUDE] << amplitudes[0] << " " << amplitudes[1] << " ";
+			}
+			features_files[PERIOD] << endl;
+			features_files[AMPLITUDE] << endl;
+		}
+		
+		close_output(&features_files[PERIOD]);
+		close_output(&features_files[AMPLITUDE]);
+		close_output(&features_files[SYNC]);
+		period_tot /= cells;
+		amplitude /= cells;
+		peaktotrough_end /= cells;
+		peaktotrough_mid /= cells;
+		num_good_somites /= cells;
+
+		//feat.period_post[index] = period_tot;
+		feat.amplitude_post[index] = amplitude;
+		feat.peaktotrough_end[index] = peaktotrough_end;
+		feat.peaktotrough_mid[index] = peaktotrough_mid;
+		feat.num_good_somites[index] = num_good_somites;
+	}
 }
 
 void osc_features_post (sim_data& sd, input_params& ip, con_levels& cl, features& feat, features& wtfeat, char* filename_feats, int start, int end, int set_num) {   //151221:  we are only using the this for the peaktotrough condition in wildtype mutant. maybe you can delete some unnecessary lines
@@ -616,28 +987,58 @@ void osc_features_post (sim_data& sd, input_params& ip, con_levels& cl, features
 	 Calculates the oscillation features: period, amplitude, and peak to trough ratio for a set of concentration levels.
 	 The values are calculated using the last peak and trough of the oscillations, since the amplitude of the first few oscillations can be slightly unstable.
 	 For the wild type, the peak and trough at the middle of the graph are also calculated in order to ensure that the oscillations are sustained.
+	 The peaks and troughs of every gene in every cell are found by post_sweep_task, split between the analysis threads by cell, and the features are then averaged and printed gene by gene in order.
 	*/
+	if (ip.feature_backend == FEATURE_BACKEND_SPECTRAL) {
+		osc_features_post_spectral(sd, ip, cl, feat, wtfeat, filename_feats, start, end, set_num);
+		return;
+	}
 
-	int strlen_set_num = INT_STRLEN(set_num); // How many bytes the ASCII representation of set_num takes
-	//char* str_set_num = (char*)mallocate(sizeof(char) * (strlen_set_num + 1));
-    char* str_set_num = (char*) mallocate(2);
-	sprintf(str_set_num, "%d", set_num);
+	scratch_arena& scratch = sd.scratch; // Every buffer below is borrowed from the arena, which takes them back before the next mutant is analyzed
 
 	int con[3] = {CMH1, CMH7, CMDELTA};
 	int ind[3] = {IMH1, IMH7, IMDELTA};
 	static const char* concs[3] = {"mh1", "mh7", "deltac"};
 	static const char* feat_names[NUM_FEATURES] = {"period", "amplitude", "sync"};
-	ofstream features_files[NUM_FEATURES]; // Array that will hold the files in which to output the period and amplitude
+	output_file features_files[NUM_FEATURES]; // Array that will hold the files in which to output the period and amplitude
 
 	int num_genes = 3;
+	int cells = sd.height * sd.width_current;
+	int num_states = num_genes * cells; // Each gene's oscillations in each cell are tracked separately, at gene * cells + x * sd.width_current + y
+	post_task pt;
+	pt.sd = &sd;
+	pt.cl = &cl;
+	pt.wtfeat = &wtfeat;
+	pt.cons = con;
+	pt.num_genes = num_genes;
+	pt.cells = cells;
+	pt.start = start;
+	pt.end = end;
+	pt.peaks = scratch.borrow_array<growin_array>(num_states);
+	pt.troughs = scratch.borrow_array<growin_array>(num_states);
+	pt.trough_peaks = scratch.borrow_array<growin_array>(num_states);
+	pt.num_peaks = scratch.borrow_array<int>(num_states);
+	pt.num_troughs = scratch.borrow_array<int>(num_states);
+	pt.peaks_period = scratch.borrow_array<int>(num_states);
+	pt.cell_period = scratch.borrow_array<double>(num_states);
+	pt.calc_period = scratch.borrow_array<bool>(num_states);
+	pt.stopped = scratch.borrow_array<bool>(num_states);
+	run_in_pool(sd, post_sweep_task, &pt); // The cells are split between the analysis threads, if any
+	growin_array* peaks = pt.peaks;
+	growin_array* troughs = pt.troughs;
+	growin_array* trough_peaks = pt.trough_peaks;
+	int* num_peaks = pt.num_peaks;
+	int* num_troughs = pt.num_troughs;
+	int* peaks_period = pt.peaks_period;
+	double* cell_period = pt.cell_period;
+
 	for (int i = 0; i < num_genes; i++) {
 		if (ip.post_features) {
 			for (int j = 0; j < NUM_FEATURES; j++) {
-				char* filename = (char*)mallocate(sizeof(char) * strlen(filename_feats) + strlen("set_") + strlen_set_num + 1 + strlen(feat_names[j]) + 1 + strlen(concs[i]) + strlen("_post.feats") + 1);
-				sprintf(filename, "%sset_%s_%s_%s_post.feats", filename_feats, str_set_num, feat_names[j], concs[i]);
+				char* type = scratch.borrow_array<char>(1 + strlen(feat_names[j]) + 1 + strlen(concs[i]) + strlen("_post.feats") + 1);
+				sprintf(type, "_%s_%s_post.feats", feat_names[j], concs[i]);
 				cout << "      ";
-				open_file(&(features_files[j]), filename, false);
-				mfree(filename);
+				open_set_output(&(features_files[j]), filename_feats, set_num, type, false);
 			}
 			
 			features_files[PERIOD] << sd.height << "," << sd.width_initial << endl;
@@ -653,75 +1054,22 @@ void osc_features_post (sim_data& sd, input_params& ip, con_levels& cl, features
 		double peaktotrough_mid = 0; 
 		double num_good_somites = 0;
 
+		double** conc = cl.cons[mr];
 		for (int x = 0; x < sd.height; x++) {
 			for (int y = 0; y < sd.width_current; y++) {
 				int cell = x * sd.width_total + y;
-				growin_array peaks(sd.steps_total / (20/sd.step_size)); 
-				growin_array troughs(sd.steps_total / (20/sd.step_size));
-				int num_peaks = 0;
-				int num_troughs = 0;
-				int peaks_period = 0;
-
-				double cell_period = 0;
-				bool calc_period = true;
-
-				double** conc = cl.cons[mr];
-				for (int j = start + 1; j < end - 1; j++) {
-					if (abs(num_peaks - num_troughs) > 1) {
-						num_peaks = 0;
-						break;
-					}
-					
-					//check if the current point is a peak
-					if (conc[j - 1][cell] < conc[j][cell] && conc[j][cell] > conc[j + 1][cell]) {
-						peaks[num_peaks] = j;
-						num_peaks++;
-						if (calc_period) {
-							peaks_period++;
-						}
-						
-						// add the current period to the average calculation
-						if (num_peaks >= 2 && calc_period) {
-							double period = (peaks[num_peaks - 1] - peaks[num_peaks - 2]) * sd.step_size * sd.big_gran;
-							cell_period += period;
-							if (num_peaks >= 4) {
-								features_files[PERIOD] << period << " ";
-							}
-						}
-					}
-					
-					//check if the current point is a trough
-					if (conc[j - 1][cell] > conc[j][cell] && conc[j][cell] < conc[j + 1][cell]) {
-						troughs[num_troughs] = j;
-						num_troughs++;
-						
-						//check if the amplitude has dropped under 0.3 of the wildtype amplitude
-						if (num_troughs >= 2) {
-							int last_peak = peaks[num_peaks - 1];
-							int last_trough = troughs[num_troughs - 1];
-							int sec_last_trough = troughs[num_troughs - 2];
-							
-							double first_amp = peaks[1] - (troughs[0] + troughs[1]) / 2;
-							double cur_amp = conc[last_peak][cell] - (conc[last_trough][cell] + conc[sec_last_trough][cell]) / 2;
-							if (num_peaks >= 4) {
-								features_files[AMPLITUDE] << cur_amp << " ";
-							}
-							if (cur_amp < (wtfeat.amplitude_post[mr] > 0 ? 0.3 * wtfeat.amplitude_post[mr] : 0.3 * first_amp)) {
-								calc_period = false;
-							}
-						}
-					}
-				}
-				cell_period /= peaks_period;
-
-				if (num_peaks >= 3) {
-					int peak_penult = peaks[num_peaks - 2];
-					int trough_ult = troughs[num_peaks - 2];	
-					int trough_penult = troughs[num_peaks - 3];	
-					int peak_mid = peaks[num_peaks / 2];
-					int trough_mid = troughs[num_peaks / 2];
-
-					period_tot += cell_period;
+				int s = i * cells + x * sd.width_current + y;
+				PROFILE_COUNT(COUNT_FEATURES, 1);
+				cell_period[s] /= peaks_period[s];
+
+				if (num_peaks[s] >= 3) {
+					int peak_penult = peaks[s][num_peaks[s] - 2];
+					int trough_ult = troughs[s][num_peaks[s] - 2];	
+					int trough_penult = troughs[s][num_peaks[s] - 3];	
+					int peak_mid = peaks[s][num_peaks[s] / 2];
+					int trough_mid = troughs[s][num_peaks[s] / 2];
+
+					period_tot += cell_period[s];
 					amplitude += (conc[peak_penult][cell] - (conc[trough_penult][cell] + conc[trough_ult][cell]) / 2);
 					peaktotrough_end += conc[trough_ult][cell] > 1 ? conc[peak_penult][cell] / conc[trough_ult][cell] : conc[peak_penult][cell];
 					peaktotrough_mid += conc[trough_mid][cell] > 1 ? conc[peak_mid][cell] / conc[trough_mid][cell] : conc[peak_mid][cell];
@@ -732,15 +1080,27 @@ void osc_features_post (sim_data& sd, input_params& ip, con_levels& cl, features
 					peaktotrough_end ++;
 					peaktotrough_mid ++;
 				}
-				num_good_somites += num_troughs - 1;
+				num_good_somites += num_troughs[s] - 1;
+				if (ip.post_features) {
+					// print the periods from the fourth peak on and the amplitudes once there were four peaks, while the periods were being averaged
+					for (int k = 3; k < peaks_period[s]; k++) {
+						features_files[PERIOD] << (peaks[s][k] - peaks[s][k - 1]) * sd.step_size * sd.big_gran << " ";
+					}
+					for (int k = 1; k < num_troughs[s]; k++) {
+						if (trough_peaks[s][k] >= 4) {
+							int last_peak = peaks[s][trough_peaks[s][k] - 1];
+							features_files[AMPLITUDE] << conc[last_peak][cell] - (conc[troughs[s][k]][cell] + conc[troughs[s][k - 1]][cell]) / 2 << " ";
+						}
+					}
+				}
 				features_files[PERIOD] << endl;
 				features_files[AMPLITUDE] << endl;
 			}
 		}
 		
-		features_files[PERIOD].close();
-		features_files[AMPLITUDE].close();
-		int cells = sd.height * sd.width_current;
+		close_output(&features_files[PERIOD]);
+		close_output(&features_files[AMPLITUDE]);
+		close_output(&features_files[SYNC]);
 		period_tot /= cells;
 		amplitude /= cells;
 		peaktotrough_end /= cells;
@@ -755,7 +1115,6 @@ void osc_features_post (sim_data& sd, input_params& ip, con_levels& cl, features
 		
 		//feat.sync_score_post[index] = post_sync(sd, cl, mr, (start + end) / 2, end);
 	}
-	mfree(str_set_num);
 }
 
 double avg_amp (sim_data& sd, con_levels& cl, int con, int time, int start , int end){              //151221: calculate the average concentration value, and use it as amplitude
@@ -778,114 +1137,146 @@ double avg_amp (sim_data& sd, con_levels& cl, int con, int time, int start , int
 }
 
 double ant_sync (sim_data& sd, con_levels& cl, int con, int time) {  //151221: calculate syncronization score
+	/*
+	Averages the correlations of every row with the first row at the given time. All the rows are correlated in one pass over the columns.
+	*/
 	if (sd.height == 1) {
 		return 1; // for 1d arrays there is no synchronization between rows 
 	}
 
-	double first_row[sd.width_total];
-	double cur_row[sd.width_total];
 	int pos_start = cl.active_start_record[time];
-	int pos_first = 0;
-	int pos_cur = 0;
-
-	for (int y = 0; y < sd.width_total; y++) {
+	int start = (con == 3 || con == 4) ? (int)(0.6 * sd.width_total) : 0; //mespa and mespb only express in anterior
+	double* levels = cl.cons[con][time];
+	sync_stats stats(sd.height - 1);
+	double cur_col[sd.height - 1];
+	for (int y = start; y < sd.width_total; y++) {
+		int pos_cur = 0;
 		if (con == 3 || con ==4){
 			if (pos_start - y < 0){
-				pos_first = pos_start -2*y + sd.width_total;
+				pos_cur = pos_start -2*y + sd.width_total;
 			} else {
-				pos_first = pos_start -2*y;
+				pos_cur = pos_start -2*y;
 			}
 		}
-		first_row[y] = cl.cons[con][time][y + pos_first];
+		for (int x = 1; x < sd.height; x++) {
+			cur_col[x - 1] = levels[x * sd.width_total + y + pos_cur];
+		}
+		stats.add(levels[y + pos_cur], cur_col);
 	}
 
 	double pearson_sum = 0;
 	for (int x = 1; x < sd.height; x++) {
-		for (int y = 0; y < sd.width_total; y++) {
-			if (con == 3 || con ==4){
-				if (pos_start - y < 0){
-					pos_cur = pos_start -2*y + sd.width_total;
-				} else {
-					pos_cur = pos_start -2*y;
-				}
-			}
-			int cell = x * sd.width_total + y + pos_cur;
-			cur_row[y] = cl.cons[con][time][cell];
-		}
-		if (con == 3 || con ==4){
-			
-			pearson_sum += pearson_correlation(first_row, cur_row, (int)(0.6*sd.width_total), sd.width_total );   //mespa and mespb only express in anterior
-		} else {
-			
-			pearson_sum += pearson_correlation(first_row, cur_row, 0, sd.width_total);
-		}
+		pearson_sum += stats.correlation(x - 1);
 	}
-
 	return pearson_sum / (sd.height - 1); 
 }
 
-void plot_ant_sync (sim_data& sd, con_levels& cl, int time_start, ofstream* file_pointer, bool first_col) {
+void plot_ant_sync (sim_data& sd, con_levels& cl, int time_start, output_file* file_pointer, bool first_col) {
+	/*
+	Prints the average correlation of every row with the first row over overlapping intervals of the given column's lifetime.
+	Each interval is made of two half-interval blocks, so every block's statistics are calculated once, for all the rows at the same time, and merged with the next block's.
+	*/
 	int col = cl.active_start_record[time_start];
 	
-	double first_row[sd.width_total * sd.steps_split];
-	double other_row[sd.width_total * sd.steps_split];
-	memset(first_row, 0, sizeof(double) * sd.width_total * sd.steps_split);
-	memset(other_row, 0, sizeof(double) * sd.width_total * sd.steps_split);
-	
-	first_row[0] = cl.cons[CMH1][time_start][col];	
 	int time = time_start + 1;
-	for (; cl.cons[BIRTH][time][col] == cl.cons[BIRTH][time - 1][col]; time++) {
-		first_row[time - time_start] = cl.cons[CMH1][time][col];
-	}
+	for (; cl.cons[BIRTH][time][col] == cl.cons[BIRTH][time - 1][col]; time++) {}
 	int time_end = time;
+	int span = time_end - time_start;
 	int interval = INTERVAL / sd.step_size;
-	int num_points = (time_end - time_start - interval) / (interval / 2); 
+	int half = interval / 2;
+	int num_points = MAX((span - interval) / half, 0);
+	int num_rows = sd.height - 1;
 	
 	if (first_col) {
 		*file_pointer << sd.height - 1 << "," << INTERVAL << "," << sd.steps_split * sd.small_gran << endl;
 	}
 
-	double sync_avg[num_points];
-	memset(sync_avg, 0, sizeof(double) * num_points);
+	// Every row's levels over the first row's lifetime, where a row's cell splits sooner the rest of its levels are kept from the previous row
+	double* first_row = sd.scratch.borrow_array<double>(span);
+	double* other_rows = sd.scratch.borrow_array<double>(span * num_rows);
+	for (int t = 0; t < span; t++) {
+		first_row[t] = cl.cons[CMH1][time_start + t][col];
+	}
 	for (int x = 1; x < sd.height; x++) {
-		int cell = x * sd.width_total + col;
-		for (int time = time_start + 1; cl.cons[BIRTH][time][cell] == cl.cons[BIRTH][time - 1][cell]; time++) {
-			other_row[time - time_start] = cl.cons[CMH1][time][cell];
+		double* row = other_rows + (x - 1) * span;
+		if (x == 1) {
+			memset(row, 0, sizeof(double) * span);
+		} else {
+			memcpy(row, row - span, sizeof(double) * span);
 		}
-		
-		for (int time = time_start; time <= time_end - interval; time += interval / 2) {
-			sync_avg[(time - time_start) / (interval / 2)] += pearson_correlation(first_row, other_row, time - time_start, time - time_start + interval);
+		int cell = x * sd.width_total + col;
+		for (int time = time_start + 1; time < time_end && cl.cons[BIRTH][time][cell] == cl.cons[BIRTH][time - 1][cell]; time++) {
+			row[time - time_start] = cl.cons[CMH1][time][cell];
 		}
 	}
 	
+	sync_stats block(num_rows);
+	sync_stats next_block(num_rows);
+	sync_stats window(num_rows);
+	double cur_col[MAX(num_rows, 1)];
+	for (int t = 0; t < half && num_points > 0; t++) {
+		for (int r = 0; r < num_rows; r++) {
+			cur_col[r] = other_rows[r * span + t];
+		}
+		block.add(first_row[t], cur_col);
+	}
 	for (int i = 0; i < num_points; i++) {
-		sync_avg[i] /= (sd.height - 1);
-		*file_pointer << sync_avg[i] << ",";
+		int next_start = (i + 1) * half;
+		next_block.reset();
+		for (int t = next_start; t < next_start + half; t++) {
+			for (int r = 0; r < num_rows; r++) {
+				cur_col[r] = other_rows[r * span + t];
+			}
+			next_block.add(first_row[t], cur_col);
+		}
+		window.reset();
+		window.merge(block);
+		window.merge(next_block);
+		for (int t = next_start + half; t < i * half + interval; t++) { // an odd interval is one point longer than its two blocks
+			for (int r = 0; r < num_rows; r++) {
+				cur_col[r] = other_rows[r * span + t];
+			}
+			window.add(first_row[t], cur_col);
+		}
+		
+		double sync_avg = 0;
+		for (int r = 0; r < num_rows; r++) {
+			sync_avg += window.correlation(r);
+		}
+		sync_avg /= (sd.height - 1);
+		*file_pointer << sync_avg << ",";
+		
+		block.reset();
+		block.merge(next_block);
 	}
 	*file_pointer << endl;
 }
 
 
 double post_sync (sim_data& sd, con_levels& cl, int con, int start, int end) {  //151221: not used
-	double comp_cell[end - start + 1];
-	double cur_cell[end - start + 1];
-	
+	/*
+	Averages the correlations of every posterior cell's levels with the middle cell's over the given time range. Every cell is correlated in one pass over time.
+	*/
 	int middle_cell = (sd.height / 2) * sd.width_total + (sd.width_current / 2);
+	int num_cells = sd.height * sd.width_initial;
 	
+	sync_stats stats(num_cells);
+	double cur_cells[num_cells];
 	for (int j = start; j < end; j++) {
-		comp_cell[j - start] = cl.cons[con][j][middle_cell];
+		for (int x = 0; x < sd.height; x++) {
+			for (int y = 0; y < sd.width_initial; y++) {
+				cur_cells[x * sd.width_initial + y] = cl.cons[con][j][x * sd.width_total + y];
+			}
+		}
+		stats.add(cl.cons[con][j][middle_cell], cur_cells);
 	}
 	
 	double pearson_sum = 0;
 	for (int x = 0; x < sd.height; x++) {
 		for (int y = 0; y < sd.width_initial; y++) {
 			int cell = x * sd.width_total + y;
-			
 			if (cell != middle_cell) {
-				for (int j = start; j < end; j++) {
-					cur_cell[j - start] = cl.cons[con][j][cell];
-				}
-				pearson_sum += pearson_correlation(comp_cell, cur_cell, 0, end - start);
+				pearson_sum += stats.correlation(x * sd.width_initial + y);
 			}
 		}
 	}
@@ -929,6 +1320,25 @@ double pearson_correlation (double* x, double* y, int start, int end) {
 }
 
 int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int con, int active_start) { //JY WT.4.5.6.7 151221: counting number of waves
+	wave_snapshot ws;
+	measure_waves(sd, cl, time, con, active_start, ws);
+	return test_waves(md, ws);
+}
+
+/* measure_waves finds the traveling waves of the given concentration across the PSM at the given time step
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		time: the time step to measure the waves at
+		con: the index of the concentration to measure the waves of
+		active_start: the column of cells at the posterior end of the PSM
+		ws: the snapshot to store the waves in
+	returns: nothing
+	notes:
+		The wave tests read only these measurements, so they are kept in the features database instead of the concentration levels.
+	todo:
+*/
+void measure_waves (sim_data& sd, con_levels& cl, int time, int con, int active_start, wave_snapshot& ws) {
 	// average the rows to create one array
 	double conc[sd.width_total];
 	memset(conc, 0, sizeof(double) * sd.width_total);
@@ -952,8 +1362,8 @@ int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int c
 	thresh /= 2;
 
 	int num_waves = 0;
-	pair <int, int> waves[3];
-	for (int wave = 0; wave < 3; wave++) {
+	pair <int, int>* waves = ws.waves;
+	for (int wave = 0; wave < MAX_WAVES; wave++) {
 		waves[wave].first = 0;
 		waves[wave].second = sd.width_total;
 	}
@@ -962,7 +1372,7 @@ int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int c
 	for (int x = 0; x < sd.width_total; x++) {
 		// check for wave start
 		if (conc[x] >= thresh && (x == 0 || conc[x - 1] < thresh)) {
-			if (num_waves == 3) {
+			if (num_waves == MAX_WAVES) {
 				num_waves++;
 				break;
 			}
@@ -971,7 +1381,7 @@ int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int c
 
 		// check for wave end
 		if (conc[x] < thresh && x > 0 && (conc[x - 1] >= thresh)) {
-			if (num_waves == 3) {
+			if (num_waves == MAX_WAVES) {
 				num_waves++;
 				break;
 			}
@@ -981,7 +1391,7 @@ int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int c
 	}
 	
 	int wlength_post = 5, wlength_ant = 2;
-	if (num_waves <= 3) {
+	if (num_waves <= MAX_WAVES) {
 		for (int wave = 0; wave < num_waves; wave++) {
 			int start = waves[wave].first;
 			int end = waves[wave].second;
@@ -994,8 +1404,21 @@ int wave_testing (sim_data& sd, con_levels& cl, mutant_data& md, int time, int c
 			}
 		}
 	}
-	int result = md.wave_test(waves, num_waves, md, wlength_post, wlength_ant); //JY WT.5.6.7
-	return result;
+	ws.num_waves = num_waves;
+	ws.wlength_post = wlength_post;
+	ws.wlength_ant = wlength_ant;
+}
+
+/* test_waves runs the given mutant's traveling wave conditions test on the given waves
+	parameters:
+		md: the mutant being tested
+		ws: the waves measured at one time step
+	returns: the score the mutant received for the waves
+	notes:
+	todo:
+*/
+int test_waves (mutant_data& md, wave_snapshot& ws) {
+	return md.wave_test(ws.waves, ws.num_waves, md, ws.wlength_post, ws.wlength_ant); //JY WT.5.6.7
 }
 
 
@@ -26,18 +26,24 @@ feats.hpp contains function declarations for feats.cpp.
 #include "structs.hpp"
 #include "tests.hpp"
 
-int get_peaks_and_troughs1(sim_data&, con_levels&, int, int, growin_array&, growin_array&, growin_array&, int);
-int get_peaks_and_troughs2(sim_data&, con_levels&, int, int, growin_array&, growin_array&, growin_array&, int, double*, double*, double*);
+void get_peaks_and_troughs(peaks_task&, int, int, scratch_arena&);
+void find_peaks_task(void*, int);
+void comp_scores_task(void*, int);
+void post_sweep_task(void*, int);
 void osc_features_post(sim_data&, input_params&, con_levels&, features&, features&, char*, int, int, int);
+void spectral_sweep_task(void*, int);
+void osc_features_post_spectral(sim_data&, input_params&, con_levels&, features&, features&, char*, int, int, int);
 double test_mesp_complementary(sim_data&, con_levels&, int);
 double test_compl(sim_data& sd, double* con1, double* con2, int num_cell);
 void osc_features_ant(sim_data&, input_params&, features&, char*, con_levels&, mutant_data&, int, int, int, int, int);
 double post_sync(sim_data&, con_levels&, int, int, int);
 double ant_sync(sim_data&, con_levels&, int, int);
 double avg_amp (sim_data& sd, con_levels&, int con, int time, int start, int end);
-void plot_ant_sync(sim_data&, con_levels&, int, ofstream*, bool);
+void plot_ant_sync(sim_data&, con_levels&, int, output_file*, bool);
 double pearson_correlation(double*, double*, int, int);
 int wave_testing(sim_data&, con_levels&, mutant_data&, int, int, int);
+void measure_waves(sim_data&, con_levels&, int, int, int, wave_snapshot&);
+int test_waves(mutant_data&, wave_snapshot&);
 int wave_testing_her1 (sim_data& sd, con_levels& cl, mutant_data& md, int time, int active_start);
 void wave_testing_mesp (sim_data& sd, con_levels& cl, mutant_data& md, int time, int active_start);
 
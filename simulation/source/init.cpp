@@ -21,6 +21,7 @@ init.cpp contains initialization functions used before any simulations start.
 Avoid adding biological functions in this file and add them to sim.cpp instead.
 */
 
+#include <strings.h> // Needed for strcasecmp
 #include <unistd.h> // Needed for getpid
 
 #include "init.hpp" // Function declarations
@@ -147,6 +148,10 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
 				ensure_nonempty(option, value);
 				store_filename(&(ip.perturb_file), value);
 				ip.read_perturb = true;
+			} else if (option_set(option, NULL, "--mutants-file")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.mutants_file), value);
+				ip.read_mutants = true;
 			} else if (option_set(option, "-r", "--gradients-file")) {
 				ensure_nonempty(option, value);
 				store_filename(&(ip.gradients_file), value);
@@ -164,6 +169,42 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
 			} else if (option_set(option, "-B", "--binary-cons-output")) {
 				ip.binary_cons_output = true;
 				i--;
+			} else if (option_set(option, NULL, "--npy-output")) {
+				ip.npy_output = true;
+				i--;
+			} else if (option_set(option, NULL, "--print-species")) {
+				ensure_nonempty(option, value);
+				ip.num_print_species = 0;
+				istringstream species(value);
+				string name;
+				while (getline(species, name, ',')) {
+					int con = mrna_index(name.c_str());
+					if (con == -1 || ip.num_print_species == NUM_CON_STORE) {
+						usage("The mRNAs to print concentrations of must be a comma-separated list of mh1, mh7, mespa, mespb, mh13, and mdelta. Set --print-species to such a list.");
+					}
+					ip.print_species[ip.num_print_species++] = con;
+				}
+			} else if (option_set(option, NULL, "--print-window")) {
+				ensure_nonempty(option, value);
+				if (!read_range(value, ip.print_window)) {
+					usage("The window to print concentrations of must be a first and last minute separated by a comma, e.g. 600,900. Set --print-window to such a pair.");
+				}
+			} else if (option_set(option, NULL, "--print-rows")) {
+				ensure_nonempty(option, value);
+				if (!read_range(value, ip.print_rows)) {
+					usage("The rows to print concentrations of must be a first and last row separated by a comma, e.g. 0,3. Set --print-rows to such a pair.");
+				}
+			} else if (option_set(option, NULL, "--print-columns")) {
+				ensure_nonempty(option, value);
+				if (!read_range(value, ip.print_columns)) {
+					usage("The columns to print concentrations of must be a first and last column separated by a comma, e.g. 0,9. Set --print-columns to such a pair.");
+				}
+			} else if (option_set(option, NULL, "--print-every")) {
+				ensure_nonempty(option, value);
+				ip.print_every = atoi(value);
+				if (ip.print_every < 1) {
+					usage("The stored time steps to print concentrations of must be every positive number of them. Set --print-every to at least 1.");
+				}
 			} else if (option_set(option, "-f", "--print-osc-features")) {
 				ensure_nonempty(option, value);
 				store_filename(&(ip.features_file), value);
@@ -191,6 +232,23 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
 				ensure_nonempty(option, value);
 				store_filename(&(ip.scores_file), value);
 				ip.print_scores = true;
+			} else if (option_set(option, NULL, "--features-db")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.features_db_file), value);
+				ip.print_features_db = true;
+			} else if (option_set(option, NULL, "--rescore")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.rescore_file), value);
+				ip.rescore = true;
+			} else if (option_set(option, NULL, "--async-output")) {
+				ensure_nonempty(option, value);
+				ip.output_buffer = atoi(value);
+				if (ip.output_buffer < 0) {
+					usage("The output a background thread may have queued must be a nonnegative number of megabytes. Set --async-output to at least 0.");
+				}
+			} else if (option_set(option, NULL, "--pack")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.pack_file), value);
 			} else if (option_set(option, "-L", "--print-cells")) {
 				ensure_nonempty(option, value);
 				ip.num_colls_print = atoi(value);
@@ -288,14 +346,74 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
 			} else if (option_set(option, "-C", "--short-circuit")) {
 				ip.short_circuit = true;
 				i--;
+			} else if (option_set(option, NULL, "--mutant-stats")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.mutant_stats_file), value);
+				ip.mutant_stats = true;
+			} else if (option_set(option, NULL, "--limit-cycle")) {
+				ensure_nonempty(option, value);
+				ip.limit_cycle_tol = atof(value);
+				if (ip.limit_cycle_tol < 0) {
+					usage("The limit cycle tolerance must be a nonnegative real number. Set --limit-cycle to be at least 0.");
+				}
+			} else if (option_set(option, NULL, "--fork-inductions")) {
+				ip.fork_inductions = true;
+				i--;
+			} else if (option_set(option, NULL, "--analysis-threads")) {
+				ensure_nonempty(option, value);
+				ip.analysis_threads = atoi(value);
+				if (ip.analysis_threads < 1) {
+					usage("The number of analysis threads must be a positive integer. Set --analysis-threads to be at least 1.");
+				}
+			} else if (option_set(option, NULL, "--feature-backend")) {
+				ensure_nonempty(option, value);
+				if (strcmp(value, "crit") == 0) {
+					ip.feature_backend = FEATURE_BACKEND_CRIT;
+				} else if (strcmp(value, "spectral") == 0) {
+					ip.feature_backend = FEATURE_BACKEND_SPECTRAL;
+				} else {
+					usage("The feature backend must be crit or spectral. Set --feature-backend to one of them.");
+				}
+			} else if (option_set(option, NULL, "--huge-pages")) {
+				ensure_nonempty(option, value);
+				if (strcmp(value, "none") == 0) {
+					ip.huge_pages = HUGE_PAGES_NONE;
+				} else if (strcmp(value, "thp") == 0) {
+					ip.huge_pages = HUGE_PAGES_THP;
+				} else if (strcmp(value, "explicit") == 0) {
+					ip.huge_pages = HUGE_PAGES_EXPLICIT;
+				} else {
+					usage("The huge pages mode must be none, thp, or explicit. Set --huge-pages to one of them.");
+				}
+			} else if (option_set(option, NULL, "--pin-threads")) {
+				ip.pin_threads = true;
+				i--;
+			} else if (option_set(option, NULL, "--profile")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.profile_file), value);
+				ip.profile = true;
 			} else if (option_set(option, "-M", "--mutants")) {
 				ensure_nonempty(option, value);
 				ip.num_active_mutants = atoi(value);
-				if (ip.num_active_mutants < 1 || ip.num_active_mutants > NUM_MUTANTS) {
-					int strlen_num = INT_STRLEN(NUM_MUTANTS);
-					char* message = (char*)mallocate(sizeof(char) * (strlen("The number of mutants to run must be a positive integer up to the number of coded-in mutants. Set -M or --mutants to be at least 1 and no more than .") + strlen_num + 1));
-					sprintf(message, "The number of mutants to run must be a positive integer up to the number of coded-in mutants. Set -M or --mutants to be at least 1 and no more than %d.", NUM_MUTANTS);
-					usage(message);
+				if (ip.num_active_mutants < 1) {
+					usage("The number of mutants to run must be a positive integer. Set -M or --mutants to be at least 1.");
+				}
+			} else if (option_set(option, NULL, "--select-mutants")) {
+				ensure_nonempty(option, value);
+				store_filename(&(ip.selected_mutants), value);
+			} else if (option_set(option, NULL, "--sections")) {
+				ensure_nonempty(option, value);
+				memset(ip.score_sections, false, sizeof(ip.score_sections));
+				static const char* section_names[NUM_SECTIONS] = {"post", "ant", "wave"};
+				istringstream sections(value);
+				string section;
+				while (getline(sections, section, ',')) {
+					int j = 0;
+					for (; j < NUM_SECTIONS && section != section_names[j]; j++) {}
+					if (j == NUM_SECTIONS) {
+						usage("The sections to score must be a comma-separated list of post, ant, and wave. Set --sections to such a list.");
+					}
+					ip.score_sections[j] = true;
 				}
 			} else if (option_set(option, "-I", "--pipe-in")) {
 				ensure_nonempty(option, value);
@@ -352,14 +470,14 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
 /* option_set checks if the given string matches either given version (short or long) of an option
 	parameters:
 		option: the string to check
-		short_name: the short version of the option
+		short_name: the short version of the option (NULL if the option only has a long version)
 		long_name: the long version of the option
 	returns: true if the string matches a version, false otherwise
 	notes:
 	todo:
 */
-inline bool option_set (const char* option, const char* short_name, const char* long_name) {
-	return strcmp(option, short_name) == 0 || strcmp(option, long_name) == 0;
+bool option_set (const char* option, const char* short_name, const char* long_name) {
+	return (short_name != NULL && strcmp(option, short_name) == 0) || strcmp(option, long_name) == 0;
 }
 
 /* ensure_nonempty ensures that an option that should have an associated value has one or exits with an error
@@ -378,6 +496,23 @@ void ensure_nonempty (const char* option, const char* arg) {
 	}
 }
 
+/* read_range reads a first and last index separated by a comma into the given pair
+	parameters:
+		value: the option's value
+		range: the pair to store the first and last index in
+	returns: true if the value is a valid range, false otherwise
+	notes:
+		Both ends are inclusive, so the first must be nonnegative and the last at least the first.
+	todo:
+*/
+bool read_range (const char* value, int range[]) {
+	char end;
+	if (sscanf(value, "%d,%d%c", &range[0], &range[1], &end) != 2) {
+		return false;
+	}
+	return range[0] >= 0 && range[1] >= range[0];
+}
+
 /* check_input_params checks that the given command-line arguments are semantically valid
 	parameters:
 		ip: the program's input parameters
@@ -405,11 +540,23 @@ void check_input_params (input_params& ip) {
 	if (ip.piping && (ip.pipe_in == 0 || ip.pipe_out == 0)) {
 		usage("If one end of a pipe is specified, the other must be as well. Set the file descriptors for both the pipe in (-I or --pipe-in) and the pipe out (-O or --pipe-out).");
 	}
-	if (!(ip.piping || ip.read_params || ip.read_ranges)) {
+	if (ip.selected_mutants != NULL && ip.num_active_mutants != 0) {
+		usage("The mutants to run can be chosen by number or by name but not both. Remove -M or --mutants or --select-mutants.");
+	}
+	if (ip.rescore && (ip.piping || ip.print_features_db)) {
+		usage("Rescoring a features database replaces simulating, so parameter sets cannot be piped in and no features database can be printed. Remove --rescore or the piping (-I or --pipe-in and -O or --pipe-out) and --features-db options.");
+	}
+	if (!(ip.piping || ip.read_params || ip.read_ranges || ip.rescore)) {
 		usage("Parameter must be piped in via -I or --pipe-in, read from a file via -i or --params-file, or generated from a ranges file and number of sets via -R or --ranges-file and -p or --parameter-sets, respectively.");
 	}
-	if (!ip.dir_path && (ip.print_cons || ip.ant_features || ip.post_features)) {
-		usage("An output directory must be specified to print concentrations or oscillation features in the anterior.");
+	if (!ip.dir_path && !ip.pack_file && (ip.print_cons || ip.ant_features || ip.post_features)) {
+		usage("An output directory or pack file must be specified to print concentrations or oscillation features in the anterior. Set -D or --directory or --pack.");
+	}
+	if (ip.npy_output && ip.binary_cons_output) {
+		usage("Concentrations can be printed as NumPy arrays or in the binary concentrations format but not both. Remove --npy-output or -B or --binary-cons-output.");
+	}
+	if (ip.print_rows[1] >= ip.height || ip.print_columns[1] >= ip.width_total) {
+		usage("The rows and columns to print concentrations of must be inside the tissue. Set --print-rows to less than the height (-y or --height) and --print-columns to less than the total width (-x or --total-width).");
 	}
 	if ((ip.width_initial == ip.width_total || ip.time_til_growth == ip.time_total) && ip.ant_features) {
 		usage("Printing oscillation features in the anterior was specified but there is not enough time for growth of the PSM in the anterior. Set the time until growth (-G or --time-til-growth) to < total time or set the initial width (-w or --initial-width) to less than the total width (-x or --total-width)");
@@ -520,7 +667,10 @@ void init_verbosity (input_params& ip) {
 */
 void read_sim_params (input_params& ip, input_data& params_data, double**& sets, input_data& ranges_data) {
 	cout << term->blue;
-	if (ip.piping) { // If the user specified piping
+	if (ip.rescore) { // If the user specified rescoring, each set's rates are read from the features database instead
+		cout << "Rescoring " << term->reset << "the parameter sets in " << ip.rescore_file << " instead of simulating" << endl;
+		ip.num_sets = 0;
+	} else if (ip.piping) { // If the user specified piping
 		cout << "Reading pipe " << term->reset << "(file descriptor " << ip.pipe_in << ") . . . ";
 		read_pipe(sets, ip);
 		term->done();
@@ -572,6 +722,20 @@ void read_perturb_params (input_params& ip, input_data& perturb_data) {
 	}
 }
 
+/* read_mutants_params reads the data from the mutants file if the user specified it
+	parameters:
+		ip: the program's input parameters
+		mutants_data: the input_data for the mutants input file
+	returns: nothing
+	notes:
+	todo:
+*/
+void read_mutants_params (input_params& ip, input_data& mutants_data) {
+	if (ip.read_mutants) {
+		read_file(&mutants_data);
+	}
+}
+
 /* read_gradients_params reads the data from the gradients file if the user specified it
 	parameters:
 		ip: the program's input parameters
@@ -692,25 +856,22 @@ void fill_gradients (rates& rs, char* gradients) {
 	}
 }
 
-/* calc_max_delay_size calculates the maximum delay any given parameter set includes and returns that +1 to size con_levels structs
+/* calc_max_delay_size calculates the maximum delay the given parameter set includes and stores that +1 to size con_levels structs
 	parameters:
-		ip: the program's input parameters
 		sd: the current simulation's data
 		rs: the current simulation's rates take perturbation factors from
-		sets: the array of parameter sets to take delays from
+		set: the parameter set to take delays from
 	returns: nothing
 	notes:
-		This function calculates the maximum delay using every parameter set because this way con_levels structs that are sized based on the maximum delay do not have to be resized for every set.
+		This function is called once per parameter set so a set with short delays does not pay for the longest delay of every other set. con_levels structs sized with the result reuse their memory when it is big enough.
 	todo:
 */
-void calc_max_delay_size (input_params& ip, sim_data& sd, rates& rs, double** sets) {
+void calc_max_delay_size (sim_data& sd, rates& rs, double* set) {
 	double max = 0;
-	for (int i = 0; i < ip.num_sets; i++) {
-		for (int j = MIN_DELAY; j <= MAX_DELAY; j++) {
-			for (int k = 0; k < sd.width_total; k++) {
-				// Calculate the minimum delay, accounting for the maximum allowable perturbation and gradients
-				max = MAX(max, (sets[i][j] + (sets[i][j] * rs.factors_perturb[j])) * rs.factors_gradient[j][k]);  
-			}
+	for (int j = MIN_DELAY; j <= MAX_DELAY; j++) {
+		for (int k = 0; k < sd.width_total; k++) {
+			// Calculate the maximum delay, accounting for the maximum allowable perturbation and gradients
+			max = MAX(max, (set[j] + (set[j] * rs.factors_perturb[j])) * rs.factors_gradient[j][k]);
 		}
 	}
 	sd.max_delay_size = MIN(max, sd.time_total) / sd.step_size + 1; // If the maximum delay is longer than the simulation time then set the maximum delay to the simulation time
@@ -727,8 +888,8 @@ void calc_max_delay_size (input_params& ip, sim_data& sd, rates& rs, double** se
 	notes:
 	todo:
 */
-void delete_file (ofstream* file) {
-	close_if_open(file);
+void delete_file (output_file* file) {
+	close_output(file);
 	delete file;
 }
 
@@ -739,10 +900,10 @@ void delete_file (ofstream* file) {
 	notes:
 	todo:
 */
-ofstream* create_passed_file (input_params& ip) {
-	ofstream* file_passed = new ofstream();
+output_file* create_passed_file (input_params& ip) {
+	output_file* file_passed = new output_file();
 	if (ip.print_passed) { // Print the passed sets only if the user specified it
-		open_file(file_passed, ip.passed_file, false);
+		open_output(file_passed, ip.passed_file, false);
 	}
 	return file_passed;
 }
@@ -756,7 +917,12 @@ ofstream* create_passed_file (input_params& ip) {
 */
 char** create_dirs (input_params& ip, sim_data& sd, mutant_data mds[]) {
 	char** dirnames = (char**)mallocate(sizeof(char*) * ip.num_active_mutants);
-	if (ip.print_cons || ip.ant_features || ip.post_features) { // If printing concentrations or oscillation features in the anterior was specified by the user then create them
+	if (ip.pack_file != NULL && (ip.print_cons || ip.ant_features || ip.post_features)) { // Packed files keep their mutant directory names as part of their keys but no directories are created
+		for (int i = 0; i < ip.num_active_mutants; i++) {
+			dirnames[i] = (char*)mallocate(sizeof(char) * (strlen(mds[i].dir_name) + 2)); // +1 for the slash and 1 for the NULL terminator
+			sprintf(dirnames[i], "%s/", mds[i].dir_name);
+		}
+	} else if (ip.print_cons || ip.ant_features || ip.post_features) { // If printing concentrations or oscillation features in the anterior was specified by the user then create them
 		// Find the path length
 		int path_length = strlen(ip.dir_path);
 		if (ip.dir_path[path_length - 1] == '/') { // Remove the trailing slash if necessary
@@ -823,10 +989,10 @@ void delete_dirs (input_params& ip, char** dirnames) {
 	notes:
 	todo:
 */
-ofstream* create_features_file (input_params& ip, mutant_data mds[]) {
-	ofstream* file_features = new ofstream();
+output_file* create_features_file (input_params& ip, mutant_data mds[]) {
+	output_file* file_features = new output_file();
 	if (ip.print_features) { // Print the oscillation features only if the user specified it
-		open_file(file_features, ip.features_file, false);
+		open_output(file_features, ip.features_file, false);
 		
 		// Print the file header
 		*file_features << "set,";
@@ -847,10 +1013,10 @@ ofstream* create_features_file (input_params& ip, mutant_data mds[]) {
 	notes:
 	todo:
 */
-ofstream* create_conditions_file (input_params& ip, mutant_data mds[]) {
-	ofstream* file_conditions = new ofstream();
+output_file* create_conditions_file (input_params& ip, mutant_data mds[]) {
+	output_file* file_conditions = new output_file();
 	if (ip.print_conditions) { // Print the condition scores only if the user specified it
-		open_file(file_conditions, ip.conditions_file, false);
+		open_output(file_conditions, ip.conditions_file, false);
 		
 		// Print the file header
 		*file_conditions << "set,";
@@ -877,10 +1043,10 @@ ofstream* create_conditions_file (input_params& ip, mutant_data mds[]) {
 	notes:
 	todo:
 */
-ofstream* create_scores_file (input_params& ip, mutant_data mds[]) {
-	ofstream* file_scores = new ofstream();
+output_file* create_scores_file (input_params& ip, mutant_data mds[]) {
+	output_file* file_scores = new output_file();
 	if (ip.print_scores) { // Print the total scores only if the user specified it
-		open_file(file_scores, ip.scores_file, false);
+		open_output(file_scores, ip.scores_file, false);
 		
 		// Print the file header
 		*file_scores << "set,";
@@ -892,29 +1058,263 @@ ofstream* create_scores_file (input_params& ip, mutant_data mds[]) {
 	return file_scores;
 }
 
-/* create_mutant_data fills in the name, knockouts, conditions, etc. for each mutant
+/* create_features_db_file creates the features database and prints its header
 	parameters:
-		sd: the current simulation's data
-	returns: the array of all mutant data
+		ip: the program's input parameters
+		mds: the array of all mutant data
+	returns: a pointer to the output file stream
 	notes:
+		The header holds the database's magic bytes, the array sizes its records depend on, and the directory name of every active mutant so rescoring can match mutants by name. See Section 2.2.5.7 of the README for the exact layout.
 	todo:
+*/
+output_file* create_features_db_file (input_params& ip, mutant_data mds[]) {
+	output_file* file_features_db = new output_file();
+	if (ip.print_features_db) { // Print the features database only if the user specified it
+		open_output(file_features_db, ip.features_db_file, false);
+		
+		// Print the file header
+		int sizes[] = {NUM_INDICES, NUM_SECTIONS, MAX_CONDS_ANY, MAX_WAVES, MAX_WAVE_SNAPSHOTS, NUM_RATES};
+		file_features_db->write(FEATURES_DB_MAGIC, sizeof(FEATURES_DB_MAGIC));
+		file_features_db->write((char*)sizes, sizeof(sizes));
+		file_features_db->write((char*)(&ip.num_active_mutants), sizeof(int));
+		for (int i = 0; i < ip.num_active_mutants; i++) {
+			int length = strlen(mds[i].dir_name);
+			file_features_db->write((char*)(&length), sizeof(int));
+			file_features_db->write(mds[i].dir_name, length);
+		}
+	}
+	return file_features_db;
+}
 
-	20151221: commented out unused mutant initialization.
+/* create_mutant_data creates the data of the mutants to simulate, in the order they are defined
+	parameters:
+		sd: the current simulation's data
+		ip: the program's input parameters
+		mutants: the mutants file buffer, NULL to use the coded-in mutants
+	returns: the array of the mutants to simulate
+	notes:
+		The mutants simulated are the ones named with --select-mutants, or otherwise the first num_active_mutants defined (every one by default). The first mutant defined, and only the first, must use the wild type's tests and is always simulated since every other mutant is tested against its features. The number of active mutants is updated to the number selected.
+		Mutants get no conditions in sections that are not scored, so those sections add nothing to the maximum scores.
+	todo:
 */
-mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
-	mutant_data* mds = new mutant_data[sd.num_active_mutants];
-	bool single_mutant = false;
-	if (sd.num_active_mutants == 2) {
-		if (MUTANT_DELTA != 1) {
-			single_mutant = true;
+mutant_data* create_mutant_data (sim_data& sd, input_params& ip, char* mutants) {
+	// Define the coded-in mutants and, if given, the mutants from the file (which borrow the coded-in mutants' tests)
+	mutant_data* builtins = new mutant_data[NUM_MUTANTS];
+	define_builtin_mutants(sd, ip, builtins);
+	mutant_data* defined = builtins;
+	int num_defined = NUM_MUTANTS;
+	if (mutants != NULL) {
+		num_defined = count_mutants(ip, mutants);
+		defined = new mutant_data[num_defined];
+		fill_mutants(ip, defined, builtins, mutants);
+	}
+	if (defined[0].index != MUTANT_WILDTYPE) {
+		usage("The first mutant in the mutants file must use the wildtype tests since every other mutant is tested against it.");
+	}
+	for (int i = 1; i < num_defined; i++) { // A mutant's index decides whether it is simulated and scored as the wild type
+		if (defined[i].index == MUTANT_WILDTYPE) {
+			usage("Only the first mutant in the mutants file can use the wildtype tests since a mutant using them is simulated and scored as the wild type.");
 		}
 	}
 	
-	// Index each mutant and initialize its concentration levels based on the maximum delay size
-	for (int i = 0; i < sd.num_active_mutants; i++) {
+	// Select the mutants to simulate
+	bool selected[num_defined];
+	if (ip.selected_mutants != NULL) {
+		memset(selected, false, sizeof(selected));
+		istringstream names(ip.selected_mutants);
+		string name;
+		while (getline(names, name, ',')) {
+			int i = 0;
+			for (; i < num_defined && strcasecmp(name.c_str(), defined[i].dir_name) != 0; i++) {}
+			if (i == num_defined) {
+				char* message = (char*)mallocate(sizeof(char) * (strlen("There is no mutant named ''. Set --select-mutants to a comma-separated list of mutants' directory names.") + name.length() + 1));
+				sprintf(message, "There is no mutant named '%s'. Set --select-mutants to a comma-separated list of mutants' directory names.", name.c_str());
+				usage(message);
+			}
+			selected[i] = true;
+		}
+	} else {
+		int num_first = ip.num_active_mutants == 0 ? num_defined : ip.num_active_mutants;
+		if (num_first > num_defined) {
+			char* message = (char*)mallocate(sizeof(char) * (strlen("The number of mutants to run must be a positive integer up to the number of defined mutants. Set -M or --mutants to be at least 1 and no more than .") + INT_STRLEN(num_defined) + 1));
+			sprintf(message, "The number of mutants to run must be a positive integer up to the number of defined mutants. Set -M or --mutants to be at least 1 and no more than %d.", num_defined);
+			usage(message);
+		}
+		for (int i = 0; i < num_defined; i++) {
+			selected[i] = i < num_first;
+		}
+	}
+	selected[0] = true;
+	
+	// Move the selected mutants to their own array (the names move with them so they are freed once)
+	int num_selected = 0;
+	for (int i = 0; i < num_defined; i++) {
+		num_selected += selected[i];
+	}
+	mutant_data* mds = new mutant_data[num_selected];
+	for (int i = 0, n = 0; i < num_defined; i++) {
+		if (selected[i]) {
+			mds[n] = defined[i];
+			defined[i].print_name = NULL;
+			defined[i].dir_name = NULL;
+			for (int j = 0; j < NUM_SECTIONS; j++) {
+				if (!ip.score_sections[j]) {
+					mds[n].num_conditions[j] = 0;
+				}
+			}
+			mds[n].calc_max_scores();
+			n++;
+		}
+	}
+	ip.num_active_mutants = sd.num_active_mutants = num_selected;
+	
+	if (defined != builtins) {
+		delete[] defined;
+	}
+	delete[] builtins;
+	return mds;
+}
+
+/* count_mutants counts the mutants defined in the given mutants file buffer
+	parameters:
+		ip: the program's input parameters
+		mutants: the mutants file buffer
+	returns: the number of mutants defined
+	notes:
+		Blank lines and lines starting with # are ignored.
+	todo:
+*/
+int count_mutants (input_params& ip, char* mutants) {
+	istringstream lines(mutants);
+	string line;
+	int num_mutants = 0;
+	while (getline(lines, line)) {
+		num_mutants += !line.empty() && line[0] != '#';
+	}
+	if (num_mutants < 1 || num_mutants > MAX_MUTANTS) {
+		cout << term->red << ip.mutants_file << " must define at least 1 and no more than " << MAX_MUTANTS << " mutants!" << term->reset << endl;
+		exit(EXIT_FILE_READ_ERROR);
+	}
+	return num_mutants;
+}
+
+/* fill_mutants fills in the given mutants from the given mutants file buffer
+	parameters:
+		ip: the program's input parameters
+		mds: the array of mutant data to fill, with room for every mutant in the file
+		builtins: the coded-in mutants, whose tests the file's mutants use
+		mutants: the mutants file buffer
+	returns: nothing
+	notes:
+		The buffer should contain one mutant per line with 12 comma-separated fields: the name to print, the directory name, the directory name of the coded-in mutant whose tests and analysis to use, the space-separated indices of the rates to knock out (up to 2), 1 if the knockouts wait for the induction or 0 if they apply from the start, the index of the mRNA synthesis rate to overexpress (-1 for none), the overexpression factor, the induction time in minutes, the recovery time in minutes (-1 for never), and the space-separated condition weights of the posterior, anterior, and wave sections. Blank lines and lines starting with # are ignored.
+	todo:
+*/
+void fill_mutants (input_params& ip, mutant_data mds[], mutant_data builtins[], char* mutants) {
+	istringstream lines(mutants);
+	string line;
+	int n = 0;
+	while (getline(lines, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		
+		// Split the line into its fields, keeping empty ones
+		string fields[NUM_MUTANT_FIELDS];
+		int num_fields = 0;
+		size_t start = 0;
+		size_t end;
+		do {
+			end = line.find(',', start);
+			if (num_fields == NUM_MUTANT_FIELDS) { // Too many fields
+				num_fields++;
+				break;
+			}
+			fields[num_fields++] = line.substr(start, end - start);
+			start = end + 1;
+		} while (end != string::npos);
+		if (num_fields != NUM_MUTANT_FIELDS) {
+			mutants_file_error(ip, line, "it needs 12 comma-separated fields");
+		}
 		
+		mutant_data& md = mds[n++];
+		md.print_name = copy_str(fields[0].c_str());
+		md.dir_name = copy_str(fields[1].c_str());
+		int i = 0;
+		for (; i < NUM_MUTANTS && strcasecmp(fields[2].c_str(), builtins[i].dir_name) != 0; i++) {}
+		if (i == NUM_MUTANTS) {
+			mutants_file_error(ip, line, "its tests must be named by a coded-in mutant's directory name");
+		}
+		md.index = builtins[i].index;
+		md.tests[SEC_POST] = builtins[i].tests[SEC_POST];
+		md.tests[SEC_ANT] = builtins[i].tests[SEC_ANT];
+		md.wave_test = builtins[i].wave_test;
+		
+		// Knockouts and overexpression
+		istringstream knockouts(fields[3]);
+		int rate;
+		while (knockouts >> rate) {
+			if (md.num_knockouts == 2 || rate < 0 || rate >= NUM_RATES) {
+				mutants_file_error(ip, line, "it can knock out up to 2 rates by their indices");
+			}
+			md.knockouts[md.num_knockouts++] = rate;
+		}
+		md.induced_knockouts = atoi(fields[4].c_str()) != 0;
+		md.overexpression_rate = atoi(fields[5].c_str());
+		if (md.overexpression_rate < -1 || md.overexpression_rate >= NUM_RATES) {
+			mutants_file_error(ip, line, "its overexpressed rate must be a rate's index or -1");
+		}
+		md.overexpression_factor = atof(fields[6].c_str());
+		
+		// Induction and recovery, converted from minutes to time steps
+		md.induction = atof(fields[7].c_str()) / ip.step_size;
+		double recovery = atof(fields[8].c_str());
+		md.recovery = recovery < 0 ? 999999999 : recovery / ip.step_size;
+		
+		// Condition weights
+		static const int max_conds[NUM_SECTIONS] = {MAX_CONDS_POST, MAX_CONDS_ANT, MAX_CONDS_WAVE};
+		for (int j = 0; j < NUM_SECTIONS; j++) {
+			istringstream weights(fields[9 + j]);
+			double weight;
+			while (weights >> weight) {
+				if (md.num_conditions[j] == max_conds[j]) {
+					mutants_file_error(ip, line, "it has more condition weights than the section has conditions");
+				}
+				md.cond_scores[j][md.num_conditions[j]++] = weight;
+			}
+		}
+		md.calc_max_scores();
+	}
+}
+
+/* mutants_file_error prints which line of the mutants file could not be parsed and why and then exits
+	parameters:
+		ip: the program's input parameters
+		line: the line that could not be parsed
+		problem: what is wrong with the line
+	returns: nothing
+	notes:
+	todo:
+*/
+void mutants_file_error (input_params& ip, string& line, const char* problem) {
+	cout << term->red << "Couldn't parse the line '" << line << "' of " << ip.mutants_file << " (" << problem << ")!" << term->reset << endl;
+	exit(EXIT_FILE_READ_ERROR);
+}
+
+/* define_builtin_mutants fills in the name, knockouts, conditions, etc. for each coded-in mutant
+	parameters:
+		sd: the current simulation's data
+		ip: the program's input parameters
+		mds: the array to fill, with room for NUM_MUTANTS mutants
+	returns: nothing
+	notes:
+	todo:
+
+	20151221: commented out unused mutant initialization.
+*/
+void define_builtin_mutants (sim_data& sd, input_params& ip, mutant_data mds[]) {
+	// Index each mutant (its concentration levels are sized for each parameter set's maximum delay size before simulating)
+	for (int i = 0; i < NUM_MUTANTS; i++) {
 		mds[i].index = i;
-		mds[i].cl.initialize(NUM_CON_LEVELS, sd.max_delay_size, sd.cells_total, sd.active_start);
 	}
 	
 	// Wild type
@@ -951,8 +1351,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	//mds[MUTANT_WILDTYPE].secs_passed[SEC_WAVE] = true;
 	
 	// Her7
-	/*if (MUTANT_HER7 >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER7].print_name = copy_str("her7 mutant");
+	/*mds[MUTANT_HER7].print_name = copy_str("her7 mutant");
 	mds[MUTANT_HER7].dir_name = copy_str("her7");
 	mds[MUTANT_HER7].num_knockouts = 1;
 	mds[MUTANT_HER7].knockouts[0] = RPSH7;
@@ -972,8 +1371,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER7].calc_max_scores();*/
 	
 	// Her13
-	/*if (MUTANT_HER13 >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER13].print_name = copy_str("her13 mutant");
+	/*mds[MUTANT_HER13].print_name = copy_str("her13 mutant");
 	mds[MUTANT_HER13].dir_name = copy_str("her13");
 	mds[MUTANT_HER13].num_knockouts = 1;
 	mds[MUTANT_HER13].knockouts[0] = RPSH13;
@@ -994,7 +1392,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER13].calc_max_scores();*/
 	
 	// Delta
-	if (MUTANT_DELTA >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_DELTA].print_name = copy_str("delta mutant");
 	mds[MUTANT_DELTA].dir_name = copy_str("delta");
 	mds[MUTANT_DELTA].num_knockouts = 1;
@@ -1018,8 +1415,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_DELTA].calc_max_scores();
 	
 	// Her7-Her13
-	/*if (MUTANT_HER7HER13 >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER7HER13].print_name = copy_str("her7-her13 mutant");
+	/*mds[MUTANT_HER7HER13].print_name = copy_str("her7-her13 mutant");
 	mds[MUTANT_HER7HER13].dir_name = copy_str("her7her13");
 	mds[MUTANT_HER7HER13].num_knockouts = 2;
 	mds[MUTANT_HER7HER13].knockouts[0] = RPSH7;
@@ -1041,8 +1437,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER7HER13].calc_max_scores();*/
 	
 	// Her1
-	/*if (MUTANT_HER1 >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER1].print_name = copy_str("her1 mutant");
+	/*mds[MUTANT_HER1].print_name = copy_str("her1 mutant");
 	mds[MUTANT_HER1].dir_name = copy_str("her1");
 	mds[MUTANT_HER1].num_knockouts = 1;
 	mds[MUTANT_HER1].knockouts[0] = RPSH1;
@@ -1065,8 +1460,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	//mds[MUTANT_HER1].secs_passed[SEC_WAVE] = true;*/
 	
 	// Her7-Delta
-	/*if (MUTANT_HER7DELTA >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER7DELTA].print_name = copy_str("her7-delta mutant");
+	/*mds[MUTANT_HER7DELTA].print_name = copy_str("her7-delta mutant");
 	mds[MUTANT_HER7DELTA].dir_name = copy_str("her7delta");
 	mds[MUTANT_HER7DELTA].num_knockouts = 2;
 	mds[MUTANT_HER7DELTA].knockouts[0] = RPSH7;
@@ -1086,8 +1480,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER7DELTA].calc_max_scores();*/
 	
 	// Her1-Delta
-	/*if (MUTANT_HER1DELTA >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER1DELTA].print_name = copy_str("her1-delta mutant");
+	/*mds[MUTANT_HER1DELTA].print_name = copy_str("her1-delta mutant");
 	mds[MUTANT_HER1DELTA].dir_name = copy_str("her7delta");
 	mds[MUTANT_HER1DELTA].num_knockouts = 2;
 	mds[MUTANT_HER1DELTA].knockouts[0] = RPSH1;
@@ -1107,7 +1500,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER1DELTA].calc_max_scores();*/
 	
 	// Her7-overexpressed
-	if (MUTANT_HER7OVER >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_HER7OVER].print_name = copy_str("her7-overexpressed mutant");
 	mds[MUTANT_HER7OVER].dir_name = copy_str("her7over");
 	mds[MUTANT_HER7OVER].num_knockouts = 0;
@@ -1132,7 +1524,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER7OVER].calc_max_scores();
 	
 	// Her1-overexpressed
-	if (MUTANT_HER1OVER >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_HER1OVER].print_name = copy_str("her1-overexpressed mutant");
 	mds[MUTANT_HER1OVER].dir_name = copy_str("her1over");
 	mds[MUTANT_HER1OVER].num_knockouts = 0;
@@ -1156,8 +1547,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	//mds[MUTANT_HER1OVER].print_con = CMH7;
 	
 	// Delta-overexpressed
-	/*if (MUTANT_DELTAOVER >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_DELTAOVER].print_name = copy_str("delta-overexpressed mutant");
+	/*mds[MUTANT_DELTAOVER].print_name = copy_str("delta-overexpressed mutant");
 	mds[MUTANT_DELTAOVER].dir_name = copy_str("deltaover");
 	mds[MUTANT_DELTAOVER].num_knockouts = 0;
 	mds[MUTANT_DELTAOVER].induction = 0;
@@ -1175,8 +1565,7 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_DELTAOVER].calc_max_scores();*/
 	
 	// Her1-Her7
-	/*if (MUTANT_HER1HER7 >= sd.num_active_mutants && single_mutant==false) {return mds;}
-	mds[MUTANT_HER1HER7].print_name = copy_str("her1-her7 mutant");
+	/*mds[MUTANT_HER1HER7].print_name = copy_str("her1-her7 mutant");
 	mds[MUTANT_HER1HER7].dir_name = copy_str("her1her7");
 	mds[MUTANT_HER1HER7].num_knockouts = 2;
 	mds[MUTANT_HER1HER7].knockouts[0] = RPSH1;
@@ -1197,10 +1586,10 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	mds[MUTANT_HER7HER13].calc_max_scores();*/
 	
 	// DAPT
-	if (MUTANT_DAPT >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_DAPT].print_name = copy_str("DAPT mutant");
 	mds[MUTANT_DAPT].dir_name = copy_str("DAPT");
 	mds[MUTANT_DAPT].num_knockouts = 1; 
+	mds[MUTANT_DAPT].induced_knockouts = true;
 	mds[MUTANT_DAPT].knockouts[0] = RPSDELTA;
 	//mds[MUTANT_DAPT].induction = ip.DAPT_induction / ip.small_gran;
 	mds[MUTANT_DAPT].induction = ip.DAPT_induction / ip.step_size;
@@ -1223,7 +1612,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	
 	
 	// MESPAOVER
-	if (MUTANT_MESPAOVER >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_MESPAOVER].print_name = copy_str("MESPAOVER mutant");
 	mds[MUTANT_MESPAOVER].dir_name = copy_str("MESPAOVER");
 	mds[MUTANT_MESPAOVER].num_knockouts = 0; 
@@ -1245,7 +1633,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	
 	
 	//MESPBOVER
-	if (MUTANT_MESPBOVER >= sd.num_active_mutants && single_mutant==false) {return mds;}
 	mds[MUTANT_MESPBOVER].print_name = copy_str("MESPbOVER mutant");
 	mds[MUTANT_MESPBOVER].dir_name = copy_str("MESPBOVER");
 	mds[MUTANT_MESPBOVER].num_knockouts = 0; 
@@ -1265,9 +1652,6 @@ mutant_data* create_mutant_data (sim_data& sd, input_params& ip) {
 	
 	mds[MUTANT_MESPBOVER].num_conditions[SEC_WAVE] = 0;
 	mds[MUTANT_MESPBOVER].calc_max_scores();
-	return mds;
-	
-	
 }
 
 /* delete_mutant_data frees the given array of mutant data from memory
@@ -1296,50 +1680,54 @@ void delete_sets (double** sets, input_params& ip) {
 	delete[] sets;
 }
 
-/* copy_cl_to_mutant copies the given concentration levels to the given mutant's concentration levels
+/* copy_cl_to_mutant copies the given concentration levels to the given mutant's snapshot
 	parameters:
 		sd: the current simulation's data
 		cl: the concentration levels to copy from
 		md: the data of the mutant that just ran
 	returns: nothing
 	notes:
+		Only the rows the snapshot keeps are copied (see cl_snapshot), a row of cells at a time.
 	todo:
 */
 void copy_cl_to_mutant (sim_data& sd, con_levels& cl, mutant_data& md) {
-	for (int i = 0; i < cl.num_con_levels; i++) {
-		for (int j_sim = sd.time_baby, j_md = 0; j_md < sd.max_delay_size; j_sim = WRAP(j_sim + 1, sd.max_delay_size), j_md++) {
-			for (int k = 0; k < cl.cells; k++) {
-				md.cl.cons[i][j_md][k] = cl.cons[i][j_sim][k];
-			}
-			md.cl.active_start_record[j_md] = cl.active_start_record[j_sim];
-			md.cl.active_end_record[j_md] = cl.active_end_record[j_sim];
+	cl_snapshot& snapshot = md.snapshot;
+	size_t row_size = sizeof(double) * snapshot.cells;
+	int time_last = WRAP(sd.time_baby - 1, sd.max_delay_size); // Where the simulation left off
+	for (int i = 0; i < NUM_CON_LEVELS; i++) {
+		for (int back = 0; back < snapshot.rows[i]; back++) {
+			memcpy(snapshot.row(i, back), cl.cons[i][WRAP(time_last - back, sd.max_delay_size)], row_size);
 		}
 	}
+	for (int j_sim = sd.time_baby, j_md = 0; j_md < sd.max_delay_size; j_sim = WRAP(j_sim + 1, sd.max_delay_size), j_md++) {
+		snapshot.active_start_record[j_md] = cl.active_start_record[j_sim];
+		snapshot.active_end_record[j_md] = cl.active_end_record[j_sim];
+	}
 }
 
-/* copy_mutant_to_cl copies the concentration levels of the given mutant to the given concentration levels
+/* copy_mutant_to_cl copies the snapshot of the given mutant to the given concentration levels
 	parameters:
 		sd: the current simulation's data
 		cl: the concentration levels to copy to
 		md: the data of the mutant that will run again
 	returns: nothing
 	notes:
+		The rows the snapshot does not keep are left as they are since the anterior simulation writes each of them before reading it. Births are only read at the current time step, so only the last one is shifted to anterior time.
 	todo:
 */
 void copy_mutant_to_cl (sim_data& sd, con_levels& cl, mutant_data& md) {
-	for (int i = 0; i < md.cl.num_con_levels; i++) {
-		for (int j = 0; j < md.cl.time_steps; j++) {
-			for (int k = 0; k < md.cl.cells; k++) {
-				cl.cons[i][j][k] = md.cl.cons[i][j][k];
-			}
-			cl.active_start_record[j] = md.cl.active_start_record[j];
-			cl.active_end_record[j] = md.cl.active_end_record[j];
+	cl_snapshot& snapshot = md.snapshot;
+	size_t row_size = sizeof(double) * snapshot.cells;
+	for (int i = 0; i < NUM_CON_LEVELS; i++) {
+		for (int back = 0; back < snapshot.rows[i]; back++) {
+			memcpy(cl.cons[i][snapshot.time_steps - 1 - back], snapshot.row(i, back), row_size);
 		}
 	}
-	for (int j = 0; j < md.cl.time_steps; j++) {
-		for (int k = 0; k < md.cl.cells; k++) {
-			cl.cons[BIRTH][j][k] -= sd.steps_til_growth + sd.max_delay_size;
-		}
+	memcpy(cl.active_start_record, snapshot.active_start_record, sizeof(int) * snapshot.time_steps);
+	memcpy(cl.active_end_record, snapshot.active_end_record, sizeof(int) * snapshot.time_steps);
+	double* births = cl.cons[BIRTH][snapshot.time_steps - 1];
+	for (int k = 0; k < snapshot.cells; k++) {
+		births[k] -= sd.steps_til_growth + sd.max_delay_size;
 	}
 }
 
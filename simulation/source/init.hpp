@@ -36,6 +36,7 @@ void free_terminal();
 void accept_input_params(int, char**, input_params&);
 bool option_set(const char*, const char*, const char*);
 void ensure_nonempty(const char*, const char*);
+bool read_range(const char*, int[]);
 void check_input_params(input_params&);
 int generate_seed();
 void init_seeds(input_params&, int, bool, bool);
@@ -43,18 +44,24 @@ void reset_seed(input_params&, sim_data& sd);
 void init_verbosity(input_params&);
 void read_sim_params(input_params&, input_data&, double**&, input_data&);
 void read_perturb_params(input_params&, input_data&);
+void read_mutants_params(input_params&, input_data&);
 void read_gradients_params(input_params&, input_data&);
 void fill_perturbations(rates&, char*);
 void fill_gradients(rates&, char*);
-void calc_max_delay_size(input_params&, sim_data&, rates&, double**);
-void delete_file(ofstream*);
-ofstream* create_passed_file(input_params&);
+void calc_max_delay_size(sim_data&, rates&, double*);
+void delete_file(output_file*);
+output_file* create_passed_file(input_params&);
 char** create_dirs(input_params&, sim_data&, mutant_data[]);
 void delete_dirs(input_params&, char**);
-ofstream* create_features_file(input_params&, mutant_data[]);
-ofstream* create_conditions_file(input_params&, mutant_data[]);
-ofstream* create_scores_file (input_params&, mutant_data[]);
-mutant_data* create_mutant_data(sim_data&, input_params&);
+output_file* create_features_file(input_params&, mutant_data[]);
+output_file* create_conditions_file(input_params&, mutant_data[]);
+output_file* create_scores_file (input_params&, mutant_data[]);
+output_file* create_features_db_file (input_params&, mutant_data[]);
+mutant_data* create_mutant_data(sim_data&, input_params&, char*);
+int count_mutants(input_params&, char*);
+void fill_mutants(input_params&, mutant_data[], mutant_data[], char*);
+void mutants_file_error(input_params&, string&, const char*);
+void define_builtin_mutants(sim_data&, input_params&, mutant_data[]);
 void delete_mutant_data(mutant_data[]);
 void delete_sets(double**, input_params&);
 void copy_cl_to_mutant(sim_data&, con_levels&, mutant_data&);
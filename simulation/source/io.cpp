@@ -23,10 +23,12 @@ io.cpp contains functions for input and output of files and pipes. All I/O relat
 #include <cerrno> // Needed for errno, EEXIST
 #include <cstdio> // Needed for fopen, fclose, fseek, ftell, rewind
 #include <sys/stat.h> // Needed for mkdir
-#include <unistd.h> // Needed for read, write, close
 
 #include "io.hpp" // Function declarations
 #include "sim.hpp" // Needed for anterior_time
+#include "threads.hpp" // Needed for output_async, submit_output
+#include "pack.hpp" // Needed for packing, open_pack_record, pack_chunk
+#include "ring.hpp" // Needed for init_pipe_end, read_pipe_bytes, write_pipe_bytes, close_pipe_end
 
 #include "main.hpp"
 
@@ -34,6 +36,9 @@ using namespace std;
 
 extern terminal* term; // Declared in init.cpp
 
+static const char* stats_section_names[NUM_SECTIONS] = {"posterior", "anterior", "wave"}; // The sections' names in the mutant stats file
+static const char* mrna_names[NUM_CON_STORE] = {"birth", "mh1", "mh7", "mespa", "mespb", "mh13", "mdelta"}; // The names of the stored concentrations, used by --print-species
+
 /* not_EOL returns whether or not a given character is the end of a line or file (i.e. '\n' or '\0', respectively)
 	parameters:
 		c: the character to check
@@ -105,6 +110,120 @@ void open_file (ofstream* file_pointer, char* file_name, bool append) {
 	term->done();
 }
 
+/* open_output opens the file with the given name for the given output stream, or prepares the stream to hand what is written to the background writer if there is one
+	parameters:
+		file_pointer: a pointer to the output stream to open the file with
+		file_name: the path and name of the file to open
+		append: if true, the file will appended to, otherwise any existing data will be overwritten
+	returns: nothing
+	notes:
+		With a background writer the file is not touched until the first record is written, so an unwritable file is only reported then.
+	todo:
+*/
+void open_output (output_file* file_pointer, char* file_name, bool append) {
+	if (append) {
+		cout << term->blue << "Opening " << term->reset << file_name << " . . . ";
+	} else {
+		cout << term->blue << "Creating " << term->reset << file_name << " . . . ";
+	}
+	if (output_async()) {
+		store_filename(&(file_pointer->path), file_name);
+		file_pointer->append = append;
+		file_pointer->rdbuf(&(file_pointer->buffer));
+	} else if (file_pointer->file.open(file_name, append ? fstream::app : fstream::out) != NULL) {
+		file_pointer->rdbuf(&(file_pointer->file));
+	} else {
+		cout << term->red << "Couldn't write to " << file_name << "!" << term->reset << endl;
+		exit(EXIT_FILE_WRITE_ERROR);
+	}
+	term->done();
+}
+
+/* open_set_output opens a parameter set's file in the given mutant directory for the given output stream, or its record in the pack if there is one
+	parameters:
+		file_pointer: a pointer to the output stream to open the file with
+		dirname: the mutant's directory, with a trailing slash
+		set_num: the index of the parameter set
+		type: the file name suffix, e.g. ".cons" for set_<n>.cons
+		append: if true, the file will appended to, otherwise any existing data will be overwritten
+	returns: nothing
+	notes:
+	todo:
+*/
+void open_set_output (output_file* file_pointer, char* dirname, int set_num, const char* type, bool append) {
+	char* filename = (char*)mallocate(sizeof(char) * (strlen(dirname) + strlen("set_") + INT_STRLEN(set_num) + strlen(type) + 1));
+	sprintf(filename, "%sset_%d%s", dirname, set_num, type);
+	if (packing()) {
+		open_pack_record(file_pointer, filename, dirname, set_num, type, append);
+	} else {
+		open_output(file_pointer, filename, append);
+	}
+	mfree(filename);
+}
+
+/* hand_off_output hands what was written to the given output stream since the last hand-off to the background writer or the pack
+	parameters:
+		file_pointer: a pointer to the output stream
+	returns: nothing
+	notes:
+		This does nothing if the stream writes its file directly. The first hand-off is queued even if nothing was written so the file is still created.
+	todo:
+*/
+void hand_off_output (output_file* file_pointer) {
+	if ((file_pointer->path == NULL && file_pointer->pack_mutant == NULL) || (file_pointer->append && file_pointer->tellp() == 0)) {
+		return;
+	}
+	if (file_pointer->pack_mutant != NULL) {
+		pack_chunk(file_pointer);
+	} else {
+		submit_output(file_pointer->path, file_pointer->append, false, new string(file_pointer->buffer.str()));
+	}
+	file_pointer->buffer.str("");
+	file_pointer->append = true;
+}
+
+/* hand_off_if_full hands what was written to the given output stream to the background writer or the pack if it has grown large
+	parameters:
+		file_pointer: a pointer to the output stream
+	returns: nothing
+	notes:
+		Large files call this as they go so they never collect more than about OUTPUT_CHUNK_BYTES in memory.
+	todo:
+*/
+void hand_off_if_full (output_file* file_pointer) {
+	if ((file_pointer->path != NULL || file_pointer->pack_mutant != NULL) && file_pointer->tellp() >= OUTPUT_CHUNK_BYTES) {
+		hand_off_output(file_pointer);
+	}
+}
+
+/* close_output closes the given output stream's file, handing what is left to the background writer or the pack if it has one
+	parameters:
+		file_pointer: a pointer to the output stream
+	returns: nothing
+	notes:
+		This does nothing if the stream was never opened, so it is safe to call on every stream.
+	todo:
+*/
+void close_output (output_file* file_pointer) {
+	if (file_pointer->path != NULL || file_pointer->pack_mutant != NULL) {
+		if (file_pointer->pack_mutant != NULL) {
+			hand_off_output(file_pointer);
+		} else { // The last record, even if empty, also tells the background writer to close the file
+			submit_output(file_pointer->path, file_pointer->append, true, new string(file_pointer->buffer.str()));
+			file_pointer->buffer.str("");
+		}
+		mfree(file_pointer->path);
+		mfree(file_pointer->pack_mutant);
+		mfree(file_pointer->pack_type);
+		file_pointer->path = NULL;
+		file_pointer->pack_mutant = NULL;
+		file_pointer->pack_type = NULL;
+	} else if (file_pointer->file.is_open()) {
+		file_pointer->file.close();
+	}
+	file_pointer->rdbuf(NULL);
+}
+
 /* read_file takes an input_data struct and stores the contents of the associated file in a string
 	parameters:
 		ifd: the input_data struct to contain the file name, buffer to store the contents, size of the file, and current index
@@ -248,7 +367,7 @@ void parse_ranges_file (pair <double, double> ranges[], char* buffer) {
 		This function prints each parameter separated by a comma, one set per line.
 	todo:
 */
-void print_passed (input_params& ip, ofstream* file_passed, rates& rs) {
+void print_passed (input_params& ip, output_file* file_passed, rates& rs) {
 	if (ip.print_passed) { // Print which sets passed only if the user specified it
 		try {
 			*file_passed << rs.rates_base[0];
@@ -263,7 +382,7 @@ void print_passed (input_params& ip, ofstream* file_passed, rates& rs) {
 	}
 }
 
-/* print_concentrations prints the concentration values of every cell at every time step of the given mutant for the given run
+/* print_concentrations prints the concentration values of the selected cells at the selected time steps of the given mutant for the given run
 	parameters:
 		ip: the program's input parameters
 		sd: the current simulation's data
@@ -273,75 +392,172 @@ void print_passed (input_params& ip, ofstream* file_passed, rates& rs) {
 		set_num: the index of the parameter set whose concentration levels are being printed
 	returns: nothing
 	notes:
-		The first line of the file is the total width then a space then the height of the simulation.
-		Each line after starts with the time step then a space then space-separated concentration levels for every cell ordered by their position relative to the active start of the PSM.
-		If binary mode is set, the file will get the extension .bcons and print raw binary values, not ASCII text.
-		The concentration printed is mutant dependent, but usually mh1.
+		The concentration printed is mutant dependent, but usually mh1, unless --print-species lists mRNAs, in which case each listed mRNA is printed to its own file named set_<n>_<mRNA>.cons.
 	todo:
 */
 void print_concentrations (input_params& ip, sim_data& sd, con_levels& cl, mutant_data& md, char* filename_cons, int set_num) {
 	if (ip.print_cons) { // Print the concentrations only if the user specified it
-		int strlen_set_num = INT_STRLEN(set_num); // How many bytes the ASCII representation of set_num takes
-		char* str_set_num = (char*)mallocate(sizeof(char) * (strlen_set_num + 1));
-		sprintf(str_set_num, "%d", set_num);
-		char* extension;
-		if (ip.binary_cons_output) { // Binary files get the extension .bcons
-			extension = copy_str(".bcons");
-		} else { // ASCII files (the default option) get the extension specified by the user
-			extension = copy_str(".cons");
-		}
-		char* filename_set = (char*)mallocate(sizeof(char) * (strlen(filename_cons) + strlen("set_") + strlen_set_num + strlen(extension) + 1));
-		sprintf(filename_set, "%sset_%s%s", filename_cons, str_set_num, extension);
-		
-		cout << "    "; // Offset the open_file message to preserve horizontal spacing
-		ofstream file_cons;
-		open_file(&file_cons, filename_set, sd.section == SEC_ANT);
-		mfree(filename_set);
-		mfree(str_set_num);
-		mfree(extension);
-		
-		// If the file was just created then prepend the concentration levels with the simulation size
-		if (sd.section == SEC_POST) {
-			if (ip.binary_cons_output) {
-				file_cons.write((char*)(&sd.width_total), sizeof(int));
-				file_cons.write((char*)(&sd.height), sizeof(int));
-			} else {
-				file_cons << sd.width_total << " " << sd.height << "\n";
+		if (ip.num_print_species == 0) {
+			print_con_levels(ip, sd, cl, md.print_con, filename_cons, set_num);
+		} else {
+			for (int i = 0; i < ip.num_print_species; i++) {
+				print_con_levels(ip, sd, cl, ip.print_species[i], filename_cons, set_num);
 			}
 		}
-		
-		// Calculate which time steps to print
-		int step_offset = (sd.section == SEC_ANT) * ((sd.steps_til_growth - sd.time_start) / sd.big_gran + 1); // If the file is being appended to then offset the time steps
-		int start = sd.time_start / sd.big_gran;
-		int end = sd.time_end / sd.big_gran;
-		
-		// Print the concentration levels of every cell at every time step
+	}
+}
+
+/* print_con_levels prints the given concentration of the selected cells at the selected time steps to a concentrations file
+	parameters:
+		ip: the program's input parameters
+		sd: the current simulation's data
+		cl: the current simulation's concentration levels
+		con: the index of the concentration to print
+		filename_cons: the path and name of the file in which to store the concentration levels
+		set_num: the index of the parameter set whose concentration levels are being printed
+	returns: nothing
+	notes:
+		The first line of the file is the number of columns printed then a space then the number of rows printed (the total width and the height unless --print-columns or --print-rows select fewer).
+		Each line after starts with the time step then a space then space-separated concentration levels for every selected cell ordered by their position relative to the active start of the PSM.
+		Only the stored time steps inside --print-window and at a multiple of --print-every are printed, so the selection changes how much is written but not what the analysis sees.
+		If binary mode is set, the file will get the extension .bcons and print raw binary values, not ASCII text.
+		NumPy arrays cannot be appended to without rewriting their headers, so with --npy-output each section gets its own file, ending in _post.npy or _ant.npy, that holds a record per time step.
+	todo:
+*/
+void print_con_levels (input_params& ip, sim_data& sd, con_levels& cl, int con, char* filename_cons, int set_num) {
+	// Name the file after the mRNA if the user chose which to print
+	bool binary = ip.binary_cons_output || ip.npy_output;
+	const char* extension = ip.npy_output ? (sd.section == SEC_POST ? "_post.npy" : "_ant.npy") : (ip.binary_cons_output ? ".bcons" : ".cons"); // Binary files get the extension .bcons
+	char type[strlen("_") + strlen(mrna_names[con]) + strlen(extension) + 1];
+	if (ip.num_print_species == 0) {
+		strcpy(type, extension);
+	} else {
+		sprintf(type, "_%s%s", mrna_names[con], extension);
+	}
+	cout << "    "; // Offset the open_file message to preserve horizontal spacing
+	output_file file_cons;
+	open_set_output(&file_cons, filename_cons, set_num, type, sd.section == SEC_ANT && !ip.npy_output);
+	
+	// Find the cells to print
+	int first_row = ip.print_rows[0];
+	int last_row = ip.print_rows[1] == -1 ? sd.height - 1 : ip.print_rows[1];
+	int num_rows = last_row - first_row + 1;
+	int first_col = ip.print_columns[0];
+	int num_cols = (ip.print_columns[1] == -1 ? sd.width_total - 1 : ip.print_columns[1]) - first_col + 1;
+	
+	// Calculate which time steps to print
+	int step_offset = (sd.section == SEC_ANT) * ((sd.steps_til_growth - sd.time_start) / sd.big_gran + 1); // If the file is being appended to then offset the time steps
+	int start = sd.time_start / sd.big_gran;
+	int end = sd.time_end / sd.big_gran;
+	double window_start = ip.print_window[0];
+	double window_end = ip.print_window[1] == -1 ? INFINITY : ip.print_window[1];
+	
+	// If the file was just created then prepend the concentration levels with the simulation size (NumPy arrays always start with their header)
+	if (ip.npy_output) {
+		int num_steps = 0;
+		for (int j = start; j < end; j++) {
+			num_steps += printed_step(ip, sd, j + step_offset, window_start, window_end);
+		}
+		write_npy_header(&file_cons, num_steps, num_rows, num_cols);
+	} else if (sd.section == SEC_POST) {
 		if (ip.binary_cons_output) {
-			for (int j = start; j < end; j++) {
-				int time_step = (j + step_offset) * sd.big_gran;
-				file_cons.write((char*)(&time_step), sizeof(int));
-				for (int i = 0; i < sd.height; i++) {
-					int num_printed = 0;
-					for (int k = cl.active_start_record[j]; num_printed < sd.width_total; k = WRAP(k - 1, sd.width_total), num_printed++) {
-						float con = cl.cons[md.print_con][j][i * sd.width_total + k];	
-						file_cons.write((char*)(&con), sizeof(float));
-					}
-				}
-			}
+			file_cons.write((char*)(&num_cols), sizeof(int));
+			file_cons.write((char*)(&num_rows), sizeof(int));
 		} else {
-			for (int j = start; j < end; j++) {
-				int time_step = (j + step_offset) * sd.big_gran;
-				file_cons << time_step << " ";
-				for (int i = 0; i < sd.height; i++) {
-					int num_printed = 0;
-					for (int k = cl.active_start_record[j]; num_printed < sd.width_total; k = WRAP(k - 1, sd.width_total), num_printed++) {
-						file_cons << cl.cons[md.print_con][j][i * sd.width_total + k] << " ";
-					}
+			file_cons << num_cols << " " << num_rows << "\n";
+		}
+	}
+	
+	// Print the concentration levels of the selected cells at the selected time steps
+	for (int j = start; j < end; j++) {
+		if (!printed_step(ip, sd, j + step_offset, window_start, window_end)) {
+			continue;
+		}
+		int time_step = (j + step_offset) * sd.big_gran;
+		if (binary) {
+			file_cons.write((char*)(&time_step), sizeof(int));
+		} else {
+			file_cons << time_step << " ";
+		}
+		for (int i = first_row; i <= last_row; i++) {
+			int num_printed = 0;
+			for (int k = WRAP(cl.active_start_record[j] - first_col, sd.width_total); num_printed < num_cols; k = WRAP(k - 1, sd.width_total), num_printed++) {
+				if (binary) {
+					float level = cl.cons[con][j][i * sd.width_total + k];
+					file_cons.write((char*)(&level), sizeof(float));
+				} else {
+					file_cons << cl.cons[con][j][i * sd.width_total + k] << " ";
 				}
-				file_cons << "\n";
 			}
 		}
+		if (!binary) {
+			file_cons << "\n";
+		}
+		hand_off_if_full(&file_cons);
 	}
+	close_output(&file_cons);
+}
+
+/* printed_step returns whether or not the given stored time step is selected to be printed
+	parameters:
+		ip: the program's input parameters
+		sd: the current simulation's data
+		step: the stored time step's index, counted from the start of the posterior
+		window_start: the first minute to print
+		window_end: the last minute to print
+	returns: true if the time step is inside the window and at a multiple of --print-every, false otherwise
+	notes:
+	todo:
+*/
+bool printed_step (input_params& ip, sim_data& sd, int step, double window_start, double window_end) {
+	double minute = step * sd.big_gran * sd.step_size;
+	return step % ip.print_every == 0 && minute >= window_start && minute <= window_end;
+}
+
+/* write_npy_header writes the header of a NumPy .npy array of time-stamped grids of concentrations
+	parameters:
+		file_pointer: a pointer to the output stream of the array's file
+		num_steps: the number of time steps the array holds
+		num_rows: the number of rows of cells in each grid
+		num_cols: the number of columns of cells in each grid
+	returns: nothing
+	notes:
+		The array has one record per time step with the fields time (an int) and cons (a num_rows by num_cols grid of floats), so numpy.load(filename, mmap_mode='r')['cons'] is a [time, row, col] view of the file without parsing.
+		The header is padded so the data starts at a multiple of 64 bytes, as version 1.0 of the format asks.
+	todo:
+*/
+void write_npy_header (output_file* file_pointer, int num_steps, int num_rows, int num_cols) {
+	int endianness = 1;
+	char order = *((char*)(&endianness)) == 1 ? '<' : '>';
+	ostringstream header;
+	header << "{'descr': [('time', '" << order << "i4'), ('cons', '" << order << "f4', (" << num_rows << ", " << num_cols << "))], 'fortran_order': False, 'shape': (" << num_steps << ",), }";
+	string dict = header.str();
+	int padded = dict.size() + 1; // +1 for the newline that ends the header
+	padded += (64 - (NPY_PREAMBLE_BYTES + padded) % 64) % 64;
+	dict.append(padded - dict.size() - 1, ' ');
+	dict += '\n';
+	unsigned char length[2] = {(unsigned char)(padded & 0xff), (unsigned char)(padded >> 8)}; // The header's length is a little-endian unsigned short
+	file_pointer->write(NPY_MAGIC, sizeof(NPY_MAGIC) - 1);
+	file_pointer->put(1); // Version 1.0
+	file_pointer->put(0);
+	file_pointer->write((char*)length, 2);
+	file_pointer->write(dict.data(), dict.size());
+}
+
+/* mrna_index returns the concentration index of the mRNA with the given name
+	parameters:
+		name: the mRNA's name (mh1, mh7, mespa, mespb, mh13, or mdelta)
+	returns: the mRNA's concentration index, -1 if no mRNA has the given name
+	notes:
+	todo:
+*/
+int mrna_index (const char* name) {
+	for (int i = CMH1; i < NUM_CON_STORE; i++) {
+		if (strcmp(name, mrna_names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
 }
 
 /* print_cell columns prints the concentrations of a number of columns of cells given by the user to an output file for plotting from the cells birth
@@ -357,24 +573,22 @@ void print_concentrations (input_params& ip, sim_data& sd, con_levels& cl, mutan
 		Each line after starts with the time step then a space then space-separated concentration levels for every cell ordered by their position relative to the active start of the PSM.
 		The number of columns given is relative to the start of the PSM and the cells are traced until one of the columns enters the determined region and is overwritten.
 		The concentration printed is mutant dependent, but usually mh1.
+		With --npy-output the file is a NumPy array named set_<n>_cells.npy instead, which is only written once every row is known.
 	todo:
 */
 
 void print_cell_columns (input_params& ip, sim_data& sd, con_levels &cl, char* filename_cons, int set_num) {
 	if (ip.num_colls_print) { // Print the cells only if the user specified it
         //cerr << "But why are we here" << endl;
-		int strlen_set_num = INT_STRLEN(set_num); // How many bytes the ASCII representation of set_num takes
-		char* str_set_num = (char*)mallocate(sizeof(char) * (strlen_set_num + 1));
-		sprintf(str_set_num, "%d", set_num);
-		char* filename_set = (char*)mallocate(sizeof(char) * (strlen(filename_cons) + strlen("set_") + strlen_set_num + strlen(".cells") + 1));
-		sprintf(filename_set, "%sset_%s.cells", filename_cons, str_set_num);
-		
 		cout << "    "; // Offset the open_file message to preserve horizontal spacing
-		ofstream file_cons;
-		open_file(&file_cons, filename_set, false);
-		file_cons << sd.height << " " << ip.num_colls_print << endl;
-		mfree(filename_set);
-		mfree(str_set_num);
+		output_file file_cons;
+		open_set_output(&file_cons, filename_cons, set_num, ip.npy_output ? "_cells.npy" : ".cells", false);
+		if (!ip.npy_output) {
+			file_cons << sd.height << " " << ip.num_colls_print << endl;
+		}
+		ostringstream npy_rows; // The rows of a NumPy array, which are collected until the number of rows for its header is known
+		ostream& rows = ip.npy_output ? (ostream&)npy_rows : (ostream&)file_cons;
+		int num_rows = 0;
 
 		int time_full = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial - 1) * sd.steps_split) ; // Time after which the PSM is full of cells
 		int time = time_full;
@@ -383,7 +597,6 @@ void print_cell_columns (input_params& ip, sim_data& sd, con_levels &cl, char* f
 		int first_active_start = cl.active_start_record[time_full];
 		
 		while ((time < time_full + sd.steps_split) || cl.active_start_record[time] != first_active_start) {
-			file_cons << time - time_full << " ";
 			
 			int col = 0;
 			for (; col < ip.num_colls_print; col++) {
@@ -405,18 +618,15 @@ void print_cell_columns (input_params& ip, sim_data& sd, con_levels &cl, char* f
 				}
 			}
 			
-			for (int cell = 0; cell < sd.height * ip.num_colls_print; cell++) {
-				file_cons << time_point[cell] << " ";
-			}
-			
-			file_cons << endl;
+			print_cells_row(ip, rows, time - time_full, time_point, sd.height * ip.num_colls_print);
+			hand_off_if_full(&file_cons);
+			num_rows++;
 			time++;
 		}
 		
 		int end_col = WRAP(first_active_start + ip.num_colls_print - 1, sd.width_total);
 		while (cl.active_start_record[time] != WRAP(end_col, sd.width_total)) {
 			int col = 0;
-			file_cons << time - time_full << " ";
 			
 			for (; col < ip.num_colls_print; col++) {
 				int cur_col = WRAP(end_col - col, sd.width_total);
@@ -436,17 +646,49 @@ void print_cell_columns (input_params& ip, sim_data& sd, con_levels &cl, char* f
 				}
 			}
 			
-			for (int cell = 0; cell < sd.height * ip.num_colls_print; cell++) {
-				file_cons << time_point[cell] << " ";
-			}
-			file_cons << endl;
+			print_cells_row(ip, rows, time - time_full, time_point, sd.height * ip.num_colls_print);
+			hand_off_if_full(&file_cons);
+			num_rows++;
 			time++;
 		}
-				
-		file_cons.close();
+		
+		if (ip.npy_output) {
+			string data = npy_rows.str();
+			write_npy_header(&file_cons, num_rows, sd.height, ip.num_colls_print);
+			file_cons.write(data.data(), data.size());
+		}
+		close_output(&file_cons);
 	}		
 }
 
+/* print_cells_row prints one time step of the cells followed by print_cell_columns
+	parameters:
+		ip: the program's input parameters
+		rows: the stream to print the row to
+		time: the time step, relative to when the PSM filled with cells
+		time_point: the concentration of every followed cell, -1 for cells not alive
+		num_cells: the number of followed cells
+	returns: nothing
+	notes:
+		NumPy rows are a time int followed by the concentrations as floats, as write_npy_header describes; text rows are space-separated.
+	todo:
+*/
+void print_cells_row (input_params& ip, ostream& rows, int time, double time_point[], int num_cells) {
+	if (ip.npy_output) {
+		rows.write((char*)(&time), sizeof(int));
+		for (int cell = 0; cell < num_cells; cell++) {
+			float level = time_point[cell];
+			rows.write((char*)(&level), sizeof(float));
+		}
+	} else {
+		rows << time << " ";
+		for (int cell = 0; cell < num_cells; cell++) {
+			rows << time_point[cell] << " ";
+		}
+		rows << endl;
+	}
+}
+
 /* print_osc_features prints the oscillation features for every mutant of the given run
 	parameters:
 		ip: the program's input parameters
@@ -461,7 +703,7 @@ void print_cell_columns (input_params& ip, sim_data& sd, con_levels &cl, char* f
 	todo:
 		TODO Print anterior scores.
 */
-void print_osc_features (input_params& ip, ofstream* file_features, mutant_data mds[], int set_num, int num_passed) {
+void print_osc_features (input_params& ip, output_file* file_features, mutant_data mds[], int set_num, int num_passed) {
 	if (ip.print_features) { // Print the features only if the user specified it
 		file_features->precision(30);
 		try {
@@ -493,7 +735,7 @@ void print_osc_features (input_params& ip, ofstream* file_features, mutant_data
 		This function prints -1, 0, or 1 for each condition for each mutant, each condition separated by a comma, one set per line.
 	todo:
 */
-void print_conditions (input_params& ip, ofstream* file_conditions, mutant_data mds[], int set_num) {
+void print_conditions (input_params& ip, output_file* file_conditions, mutant_data mds[], int set_num) {
 	if (ip.print_conditions) { // Print the conditions only if the user specified it
 		try {
 			*file_conditions << set_num << ",";
@@ -529,7 +771,7 @@ void print_conditions (input_params& ip, ofstream* file_conditions, mutant_data
 		This function prints the set index then score for each mutant then the total score, all separated by commas, one set per line.
 	todo:
 */
-void print_scores (input_params& ip, ofstream* file_scores, int set_num, double scores[], double total_score) {
+void print_scores (input_params& ip, output_file* file_scores, int set_num, double scores[], double total_score) {
 	if (ip.print_scores) {
 		try {
 			*file_scores << set_num << ",";
@@ -544,16 +786,354 @@ void print_scores (input_params& ip, ofstream* file_scores, int set_num, double
 	}
 }
 
-/* close_if_open closes the given output file stream if it is open
+/* print_features_db prints what every mutant's tests read in the given set to the features database, if the user specified one
+	parameters:
+		ip: the program's input parameters
+		file_features_db: a pointer to the output file stream of the features database
+		rs: the current simulation's rates to pull the parameter set from
+		mds: the array of all mutant data
+		set_num: the index of the parameter set whose records are being printed
+	returns: nothing
+	notes:
+		Each set is printed as its index, its rates, the number of records, and then a record for each section each mutant was simulated in, in the order they are scored. See Section 2.2.5.7 of the README for the exact layout.
+		The records are cleared for the next set once printed.
+	todo:
+*/
+void print_features_db (input_params& ip, output_file* file_features_db, rates& rs, mutant_data mds[], int set_num) {
+	if (ip.print_features_db) {
+		int num_records = 0;
+		for (int j = 0; j < NUM_SECTIONS; j++) {
+			for (int i = 0; i < ip.num_active_mutants; i++) {
+				num_records += mds[i].records[j].simulated;
+			}
+		}
+		try {
+			file_features_db->write((char*)(&set_num), sizeof(int));
+			file_features_db->write((char*)(rs.rates_base), sizeof(double) * NUM_RATES);
+			file_features_db->write((char*)(&num_records), sizeof(int));
+			for (int j = 0; j < NUM_SECTIONS; j++) {
+				for (int i = 0; i < ip.num_active_mutants; i++) {
+					scoring_record& rec = mds[i].records[j];
+					if (rec.simulated) {
+						char completed = rec.completed;
+						file_features_db->write((char*)(&i), sizeof(int));
+						file_features_db->write((char*)(&j), sizeof(int));
+						file_features_db->write(&completed, sizeof(char));
+						write_features(file_features_db, rec.feat);
+						file_features_db->write((char*)(rec.conds_passed), sizeof(rec.conds_passed));
+						file_features_db->write((char*)(&rec.num_snapshots), sizeof(int));
+						for (int k = 0; k < rec.num_snapshots; k++) {
+							wave_snapshot& ws = rec.snapshots[k];
+							file_features_db->write((char*)(&ws.num_waves), sizeof(int));
+							for (int w = 0; w < MAX_WAVES; w++) {
+								file_features_db->write((char*)(&ws.waves[w].first), sizeof(int));
+								file_features_db->write((char*)(&ws.waves[w].second), sizeof(int));
+							}
+							file_features_db->write((char*)(&ws.wlength_post), sizeof(int));
+							file_features_db->write((char*)(&ws.wlength_ant), sizeof(int));
+						}
+						rec.simulated = false;
+					}
+				}
+			}
+		} catch (const ofstream::failure&) {
+			cout << term->red << "Couldn't write to " << ip.features_db_file << "!" << term->reset << endl;
+			exit(EXIT_FILE_WRITE_ERROR);
+		}
+		hand_off_output(file_features_db);
+	}
+}
+
+/* write_features writes the given oscillation features to the given binary output file stream
 	parameters:
-		file: a pointer to the output file stream to close
+		file: a pointer to the output file stream to write to
+		feat: the features to write
 	returns: nothing
 	notes:
+		The arrays are written in the order they are declared in, followed by each time point map as its size and then its (time point, value) pairs.
 	todo:
 */
-void close_if_open (ofstream* file) {
-	if (file->is_open()) {
-		file->close();
+void write_features (output_file* file, features& feat) {
+	file->write((char*)(feat.period_post), sizeof(feat.period_post));
+	file->write((char*)(feat.period_ant), sizeof(feat.period_ant));
+	file->write((char*)(feat.amplitude_post), sizeof(feat.amplitude_post));
+	file->write((char*)(feat.amplitude_ant), sizeof(feat.amplitude_ant));
+	file->write((char*)(feat.peaktotrough_mid), sizeof(feat.peaktotrough_mid));
+	file->write((char*)(feat.peaktotrough_end), sizeof(feat.peaktotrough_end));
+	file->write((char*)(feat.sync_score_post), sizeof(feat.sync_score_post));
+	file->write((char*)(feat.sync_score_ant), sizeof(feat.sync_score_ant));
+	file->write((char*)(&feat.comp_score_ant_mespa), sizeof(double));
+	file->write((char*)(&feat.comp_score_ant_mespb), sizeof(double));
+	file->write((char*)(feat.num_good_somites), sizeof(feat.num_good_somites));
+	time_series* series[] = {feat.period_post_time, feat.amplitude_post_time, feat.period_ant_time, feat.amplitude_ant_time, feat.sync_time};
+	for (int m = 0; m < 5; m++) {
+		for (int i = 0; i < NUM_INDICES; i++) {
+			int size = series[m][i].num_recorded;
+			file->write((char*)(&size), sizeof(int));
+			for (int key = 0; key < series[m][i].length; key++) {
+				if (series[m][i].recorded[key]) {
+					file->write((char*)(&key), sizeof(int));
+					file->write((char*)(&(series[m][i].values[key])), sizeof(double));
+				}
+			}
+		}
+	}
+}
+
+/* open_features_db opens the features database to rescore and matches its mutants with the active ones
+	parameters:
+		ip: the program's input parameters
+		mds: the array of all mutant data
+		file_db: the input file stream to open the database with
+		db_mutants: the array to store the index of the active mutant each of the database's mutants matches, -1 if none does
+	returns: the number of mutants in the database
+	notes:
+		Mutants are matched by their directory names, so a database can be rescored with a subset of its mutants or with mutants whose conditions changed. Active mutants missing from the database are never scored.
+		The database must have been printed by a simulation with the same feature and condition array sizes.
+	todo:
+*/
+int open_features_db (input_params& ip, mutant_data mds[], ifstream& file_db, int db_mutants[]) {
+	cout << term->blue << "Opening " << term->reset << ip.rescore_file << " . . . ";
+	file_db.open(ip.rescore_file, fstream::in | fstream::binary);
+	if (!file_db.is_open()) {
+		cout << term->red << "Couldn't open " << ip.rescore_file << "!" << term->reset << endl;
+		exit(EXIT_FILE_READ_ERROR);
+	}
+	
+	// Check that the database's layout matches this simulation's
+	char magic[sizeof(FEATURES_DB_MAGIC)];
+	int sizes[6];
+	int expected[6] = {NUM_INDICES, NUM_SECTIONS, MAX_CONDS_ANY, MAX_WAVES, MAX_WAVE_SNAPSHOTS, NUM_RATES};
+	file_db.read(magic, sizeof(magic));
+	file_db.read((char*)sizes, sizeof(sizes));
+	if (!file_db || memcmp(magic, FEATURES_DB_MAGIC, sizeof(magic)) != 0 || memcmp(sizes, expected, sizeof(sizes)) != 0) {
+		features_db_error(ip, "it is not a features database or was printed by a simulation with different array sizes");
+	}
+	
+	// Match the database's mutants with the active ones
+	int num_db_mutants = 0;
+	file_db.read((char*)(&num_db_mutants), sizeof(int));
+	if (!file_db || num_db_mutants < 1 || num_db_mutants > MAX_MUTANTS) {
+		features_db_error(ip, "its number of mutants is invalid");
+	}
+	for (int i = 0; i < num_db_mutants; i++) {
+		int length = 0;
+		file_db.read((char*)(&length), sizeof(int));
+		if (!file_db || length < 0 || length > 1024) {
+			features_db_error(ip, "a mutant's name is invalid");
+		}
+		string name(length, '\0');
+		file_db.read(&name[0], length);
+		db_mutants[i] = -1;
+		for (int j = 0; j < ip.num_active_mutants; j++) {
+			if (name == mds[j].dir_name) {
+				db_mutants[i] = j;
+			}
+		}
+	}
+	if (!file_db || db_mutants[0] != MUTANT_WILDTYPE) {
+		features_db_error(ip, "its first mutant must be the first active mutant");
+	}
+	term->done();
+	return num_db_mutants;
+}
+
+/* read_features_set reads the next parameter set's records from the features database into the mutants they match
+	parameters:
+		ip: the program's input parameters
+		file_db: the input file stream of the features database
+		mds: the array of all mutant data
+		db_mutants: the index of the active mutant each of the database's mutants matches, -1 if none does
+		num_db_mutants: the number of mutants in the database
+		set_num: the integer to store the set's index in
+		rates: the array to store the set's rates in
+	returns: true if a set was read, false if the database has no more sets
+	notes:
+		Every active mutant's records are cleared first, so mutants the set has no records for count as not simulated.
+	todo:
+*/
+bool read_features_set (input_params& ip, ifstream& file_db, mutant_data mds[], int db_mutants[], int num_db_mutants, int& set_num, double rates[]) {
+	for (int i = 0; i < ip.num_active_mutants; i++) {
+		for (int j = 0; j < NUM_SECTIONS; j++) {
+			mds[i].records[j].simulated = false;
+		}
+	}
+	
+	file_db.read((char*)(&set_num), sizeof(int));
+	if (file_db.gcount() == 0 && file_db.eof()) {
+		return false;
+	}
+	int num_records = 0;
+	file_db.read((char*)rates, sizeof(double) * NUM_RATES);
+	file_db.read((char*)(&num_records), sizeof(int));
+	if (!file_db || num_records < 0 || num_records > NUM_SECTIONS * num_db_mutants) {
+		features_db_error(ip, "a parameter set is truncated or invalid");
+	}
+	
+	scoring_record unmatched; // The records of mutants that are not active are read into this and then ignored
+	for (int r = 0; r < num_records; r++) {
+		int mutant = 0;
+		int section = 0;
+		char completed = 0;
+		file_db.read((char*)(&mutant), sizeof(int));
+		file_db.read((char*)(&section), sizeof(int));
+		file_db.read(&completed, sizeof(char));
+		if (!file_db || mutant < 0 || mutant >= num_db_mutants || section < 0 || section >= NUM_SECTIONS) {
+			features_db_error(ip, "a record is truncated or invalid");
+		}
+		scoring_record& rec = db_mutants[mutant] == -1 ? unmatched : mds[db_mutants[mutant]].records[section];
+		rec.simulated = true;
+		rec.completed = completed;
+		read_features(file_db, rec.feat);
+		file_db.read((char*)(rec.conds_passed), sizeof(rec.conds_passed));
+		file_db.read((char*)(&rec.num_snapshots), sizeof(int));
+		if (!file_db || rec.num_snapshots < 0 || rec.num_snapshots > MAX_WAVE_SNAPSHOTS) {
+			features_db_error(ip, "a record is truncated or invalid");
+		}
+		for (int k = 0; k < rec.num_snapshots; k++) {
+			wave_snapshot& ws = rec.snapshots[k];
+			file_db.read((char*)(&ws.num_waves), sizeof(int));
+			for (int w = 0; w < MAX_WAVES; w++) {
+				file_db.read((char*)(&ws.waves[w].first), sizeof(int));
+				file_db.read((char*)(&ws.waves[w].second), sizeof(int));
+			}
+			file_db.read((char*)(&ws.wlength_post), sizeof(int));
+			file_db.read((char*)(&ws.wlength_ant), sizeof(int));
+		}
+		if (!file_db) {
+			features_db_error(ip, "a record is truncated or invalid");
+		}
+	}
+	return true;
+}
+
+/* read_features reads oscillation features written by write_features from the given binary input file stream
+	parameters:
+		file: the input file stream to read from
+		feat: the features to fill
+	returns: nothing
+	notes:
+		The caller checks the stream for errors.
+	todo:
+*/
+void read_features (ifstream& file, features& feat) {
+	file.read((char*)(feat.period_post), sizeof(feat.period_post));
+	file.read((char*)(feat.period_ant), sizeof(feat.period_ant));
+	file.read((char*)(feat.amplitude_post), sizeof(feat.amplitude_post));
+	file.read((char*)(feat.amplitude_ant), sizeof(feat.amplitude_ant));
+	file.read((char*)(feat.peaktotrough_mid), sizeof(feat.peaktotrough_mid));
+	file.read((char*)(feat.peaktotrough_end), sizeof(feat.peaktotrough_end));
+	file.read((char*)(feat.sync_score_post), sizeof(feat.sync_score_post));
+	file.read((char*)(feat.sync_score_ant), sizeof(feat.sync_score_ant));
+	file.read((char*)(&feat.comp_score_ant_mespa), sizeof(double));
+	file.read((char*)(&feat.comp_score_ant_mespb), sizeof(double));
+	file.read((char*)(feat.num_good_somites), sizeof(feat.num_good_somites));
+	time_series* series[] = {feat.period_post_time, feat.amplitude_post_time, feat.period_ant_time, feat.amplitude_ant_time, feat.sync_time};
+	for (int m = 0; m < 5; m++) {
+		for (int i = 0; i < NUM_INDICES; i++) {
+			series[m][i].clear();
+			int size = 0;
+			file.read((char*)(&size), sizeof(int));
+			for (int k = 0; k < size && file; k++) {
+				int key = 0;
+				double value = 0;
+				file.read((char*)(&key), sizeof(int));
+				file.read((char*)(&value), sizeof(double));
+				if (key >= 0) {
+					series[m][i][key] = value;
+				}
+			}
+		}
+	}
+}
+
+/* features_db_error prints why the features database being rescored could not be read and then exits
+	parameters:
+		ip: the program's input parameters
+		problem: what is wrong with the database
+	returns: nothing
+	notes:
+	todo:
+*/
+void features_db_error (input_params& ip, const char* problem) {
+	cout << term->red << "Couldn't read " << ip.rescore_file << " (" << problem << ")!" << term->reset << endl;
+	exit(EXIT_FILE_READ_ERROR);
+}
+
+/* read_mutant_stats loads the mutants' failure rates and costs recorded by previous runs from the mutant stats file, if the user specified one that exists
+	parameters:
+		ip: the program's input parameters
+		mds: the array of all mutant data
+	returns: nothing
+	notes:
+		Each line holds a section, a mutant's name, and how many times that mutant was simulated in that section, how many of those runs failed, and how many time steps they simulated in total, all separated by commas. Blank lines, lines starting with #, and lines of inactive mutants are ignored.
+		A missing file is not an error since the first run with a new stats file has nothing to load.
+	todo:
+*/
+void read_mutant_stats (input_params& ip, mutant_data mds[]) {
+	if (!ip.mutant_stats) {
+		return;
+	}
+	FILE* file = fopen(ip.mutant_stats_file, "r");
+	if (file == NULL) {
+		cout << term->blue << "Starting " << term->reset << "new mutant stats in " << ip.mutant_stats_file << endl;
+		return;
+	}
+	fclose(file);
+	
+	input_data stats_data(ip.mutant_stats_file);
+	read_file(&stats_data);
+	istringstream stats(stats_data.buffer);
+	string line;
+	while (getline(stats, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		istringstream fields(line);
+		string section, name, runs, failures, steps;
+		if (!getline(fields, section, ',') || !getline(fields, name, ',') || !getline(fields, runs, ',') || !getline(fields, failures, ',') || !getline(fields, steps)) {
+			cout << term->red << "Couldn't parse the line '" << line << "' of " << ip.mutant_stats_file << "!" << term->reset << endl;
+			exit(EXIT_FILE_READ_ERROR);
+		}
+		for (int j = 0; j < NUM_SECTIONS; j++) {
+			for (int i = 0; i < ip.num_active_mutants; i++) {
+				if (section == stats_section_names[j] && name == mds[i].print_name) {
+					mds[i].runs[j] = atoi(runs.c_str());
+					mds[i].failures[j] = atoi(failures.c_str());
+					mds[i].steps_run[j] = atof(steps.c_str());
+				}
+			}
+		}
+	}
+}
+
+/* print_mutant_stats saves every mutant's failure rates and costs to the mutant stats file, if the user specified one
+	parameters:
+		ip: the program's input parameters
+		mds: the array of all mutant data
+	returns: nothing
+	notes:
+		The file is overwritten with the runs it was loaded with plus this run's, in the format read_mutant_stats reads.
+	todo:
+*/
+void print_mutant_stats (input_params& ip, mutant_data mds[]) {
+	if (ip.mutant_stats) {
+		ofstream file_stats;
+		open_file(&file_stats, ip.mutant_stats_file, false);
+		try {
+			file_stats << "# section,mutant,runs,failures,time steps" << endl;
+			for (int j = 0; j < NUM_SECTIONS; j++) {
+				for (int i = 0; i < ip.num_active_mutants; i++) {
+					if (mds[i].runs[j] > 0) {
+						file_stats << stats_section_names[j] << "," << mds[i].print_name << "," << mds[i].runs[j] << "," << mds[i].failures[j] << "," << (long long)mds[i].steps_run[j] << endl;
+					}
+				}
+			}
+		} catch (const ofstream::failure&) {
+			cout << term->red << "Couldn't write to " << ip.mutant_stats_file << "!" << term->reset << endl;
+			exit(EXIT_FILE_WRITE_ERROR);
+		}
+		file_stats.close();
 	}
 }
 
@@ -567,9 +1147,13 @@ void close_if_open (ofstream* file) {
 		The next information piped in must be an integer specifying the number of parameter sets that will be piped in.
 		Each set to be piped in should be sent as a stream of doubles, with each set boundary determined by the previously sent number of rates per set.
 		This function does not create a pipe; it must be created by an external program interfacing with this one.
+		Either pipe end may instead be a shared-memory ring (see ring.cpp), which carries the same data.
 	todo:
 */
 void read_pipe (double**& sets, input_params& ip) {
+	init_pipe_end(ip.pipe_in);
+	init_pipe_end(ip.pipe_out);
+	
 	// Read how many rates per set will be piped in
 	int num_pars = 0;
 	read_pipe_int(ip.pipe_in, &num_pars);
@@ -605,10 +1189,7 @@ void read_pipe (double**& sets, input_params& ip) {
 	todo:
 */
 void read_pipe_int (int fd, int* address) {
-	if (read(fd, address, sizeof(int)) == -1) {
-		term->failed_pipe_read();
-		exit(EXIT_PIPE_READ_ERROR);
-	}
+	read_pipe_bytes(fd, address, sizeof(int));
 }
 
 /* read_pipe_set reads a parameter set from the given pipe and stores it in the given address
@@ -621,10 +1202,7 @@ void read_pipe_int (int fd, int* address) {
 	todo:
 */
 void read_pipe_set (int fd, double pars[]) {
-	if (read(fd, pars, sizeof(double) * NUM_RATES) == -1) {
-		term->failed_pipe_read();
-		exit(EXIT_PIPE_READ_ERROR);
-	}
+	read_pipe_bytes(fd, pars, sizeof(double) * NUM_RATES);
 }
 
 /* write_pipe writes run scores to a pipe created by a program interacting with this one
@@ -647,10 +1225,7 @@ void write_pipe (double score[], input_params& ip, sim_data& sd) {
 	}
 	
 	// Close the pipe
-	if (close(ip.pipe_out) == -1) {
-		term->failed_pipe_write();
-		exit(EXIT_PIPE_WRITE_ERROR);
-	}
+	close_pipe_end(ip.pipe_out);
 }
 
 /* write_pipe_int writes the given integer to the given pipe
@@ -663,9 +1238,6 @@ void write_pipe (double score[], input_params& ip, sim_data& sd) {
 	todo:
 */
 void write_pipe_double (int fd, double value) {
-	if (write(fd, &value, sizeof(double)) == -1) {
-		term->failed_pipe_write();
-		exit(EXIT_PIPE_WRITE_ERROR);
-	}
+	write_pipe_bytes(fd, &value, sizeof(double));
 }
 
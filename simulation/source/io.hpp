@@ -31,16 +31,33 @@ bool not_EOL(char);
 void store_filename(char**, const char*);
 void create_dir(char*);
 void open_file(ofstream*, char*, bool);
+void open_output(output_file*, char*, bool);
+void open_set_output(output_file*, char*, int, const char*, bool);
+void hand_off_output(output_file*);
+void hand_off_if_full(output_file*);
+void close_output(output_file*);
 void read_file(input_data*);
 bool parse_param_line(double*, char*, int&);
 void parse_ranges_file (pair <double, double>[], char*);
-void print_passed(input_params&, ofstream*, rates&);
+void print_passed(input_params&, output_file*, rates&);
 void print_concentrations(input_params&, sim_data&, con_levels&, mutant_data&, char*, int);
+void print_con_levels(input_params&, sim_data&, con_levels&, int, char*, int);
+bool printed_step(input_params&, sim_data&, int, double, double);
+void write_npy_header(output_file*, int, int, int);
+int mrna_index(const char*);
 void print_cell_columns(input_params&, sim_data&, con_levels&, char*, int);
-void print_osc_features(input_params&, ofstream*, mutant_data[], int, int);
-void print_conditions (input_params&, ofstream*, mutant_data[], int);
-void print_scores(input_params&, ofstream*, int, double[], double);
-void close_if_open(ofstream*);
+void print_cells_row(input_params&, ostream&, int, double[], int);
+void print_osc_features(input_params&, output_file*, mutant_data[], int, int);
+void print_conditions (input_params&, output_file*, mutant_data[], int);
+void print_scores(input_params&, output_file*, int, double[], double);
+void print_features_db(input_params&, output_file*, rates&, mutant_data[], int);
+void write_features(output_file*, features&);
+int open_features_db(input_params&, mutant_data[], ifstream&, int[]);
+bool read_features_set(input_params&, ifstream&, mutant_data[], int[], int, int&, double[]);
+void read_features(ifstream&, features&);
+void features_db_error(input_params&, const char*);
+void read_mutant_stats(input_params&, mutant_data[]);
+void print_mutant_stats(input_params&, mutant_data[]);
 void read_pipe(double**&, input_params&);
 void read_pipe_int(int, int*);
 void read_pipe_set(int, double[]);
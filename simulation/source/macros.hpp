@@ -41,6 +41,8 @@ macros.hpp contains every constant and macro function used in the program.
 #define MUTANT_MESPBOVER	6
 
 #define NUM_MUTANTS 		7
+#define MAX_MUTANTS			32 // The most mutants a mutants file can define
+#define NUM_MUTANT_FIELDS	12 // The number of fields defining each mutant in a mutants file
 
 /// Named shortcuts for each concentration level of mRNA, protein, and dimer
 
@@ -86,6 +88,9 @@ macros.hpp contains every constant and macro function used in the program.
 #define MIN_CON_LEVEL	1 // The smallest index of a concetration level not including BIRTH or PARENT
 #define MAX_CON_LEVEL	21 // The largest index of a concentration level not including BIRTH or PARENT
 
+// Whether the model reads the given concentration level at delayed time steps (every mRNA, the Delta protein, and the repressing dimers); the rest are only read at the previous time step
+#define DELAYED_CON(con)	(((con) >= CMH1 && (con) <= CMDELTA) || (con) == CPDELTA || (con) == CPH1H1 || (con) == CPH7H13 || ((con) >= CPMESPAMESPA && (con) <= CPMESPBMESPB))
+
 /// Named shortcuts for each rate of mRNA, protein, and dimer
 
 // mRNA synthesis rates
@@ -254,6 +259,30 @@ macros.hpp contains every constant and macro function used in the program.
 #define MAX_CONDS_ALL	(MAX_CONDS_POST + MAX_CONDS_ANT + MAX_CONDS_WAVE)
 #define MAX_CONDS_ANY	MAX(MAX(MAX_CONDS_POST, MAX_CONDS_ANT), MAX_CONDS_WAVE)
 
+// Traveling wave measurements
+#define MAX_WAVES			3 // The most waves counted in the PSM at a time step (more count as MAX_WAVES + 1)
+#define MAX_WAVE_SNAPSHOTS	8 // The most time steps the traveling waves are measured at in an anterior simulation
+
+// Asynchronous output
+#define OUTPUT_QUEUE_SLOTS	1024 // The most output records the background writer can have queued at once
+#define OUTPUT_CHUNK_BYTES	1048576 // How much a large output file collects before it is handed to the background writer
+#define OUTPUT_OPEN_FILES	32 // The most files the background writer keeps open at once
+
+// Features database
+#define FEATURES_DB_MAGIC	"FEATDB1" // The 8 bytes (including the terminating null) every features database starts with
+
+// Pack files
+#define PACK_MAGIC	"SIMPACK" // The 8 bytes (including the terminating null) every pack file starts and ends with
+
+// Shared-memory rings
+#define RING_MAGIC		"SIMRING" // The 8 bytes (including the terminating null) every shared-memory ring starts with
+#define MAX_RINGS		2 // The number of rings a run can attach (one per pipe end)
+#define RING_WAIT_NS	100000000 // The nanoseconds a side waits on its peer before checking whether the ring was closed
+
+// NumPy arrays
+#define NPY_MAGIC	"\x93NUMPY" // The 6 bytes every .npy file starts with
+#define NPY_PREAMBLE_BYTES	10 // The bytes before an .npy file's header: the magic string, the version, and the header's length
+
 // Oscillation features
 #define PERIOD			0
 #define AMPLITUDE		1
@@ -262,6 +291,60 @@ macros.hpp contains every constant and macro function used in the program.
 #define NUM_DATA_POINTS 10 // The number of data points required for synchronization plotting
 #define INTERVAL 		60 // The length of the overlapping intervals for synchronization plotting
 
+// Posterior feature backends
+#define FEATURE_BACKEND_CRIT		0 // Periods and amplitudes from the peaks and troughs of each cell's oscillations
+#define FEATURE_BACKEND_SPECTRAL	1 // Periods and amplitudes from a bank of Goertzel filters over each cell's oscillations
+
+// Huge pages for the concentration levels
+#define HUGE_PAGES_NONE		0 // Allocated with malloc like everything else
+#define HUGE_PAGES_THP		1 // Mapped and advised to the kernel as transparent huge pages
+#define HUGE_PAGES_EXPLICIT	2 // Mapped from the kernel's reserved huge pages, falling back to transparent ones if too few are reserved
+#define HUGE_PAGE_SIZE		2097152 // The size in bytes of a huge page (smaller buffers are allocated with malloc)
+#define SPECTRAL_SAMPLE_MINUTES		0.5 // The minutes of concentration levels averaged into each sample the filters see
+#define SPECTRAL_FILTERS			48 // The number of filters, evenly spaced in frequency between the minimum and maximum periods
+#define SPECTRAL_MIN_PERIOD			15 // The shortest period in minutes the filters look for
+#define SPECTRAL_MAX_PERIOD			60 // The longest period in minutes the filters look for
+#define SPECTRAL_MIN_REL_AMP		0.01 // The smallest amplitude relative to the mean level that counts as oscillating
+
+// Scratch memory
+#define ARENA_ALIGN		16 // The alignment in bytes of every buffer borrowed from a scratch arena (a power of 2 at least the size of a pointer)
+#define TIME_SERIES_MIN_CAPACITY	16 // The fewest half hours a feature's time series allocates memory for
+
+// Limit cycle detection
+#define LIMIT_CYCLE_CON		CMH1 // The concentration whose peaks are compared to detect a stable limit cycle
+#define LIMIT_CYCLE_CYCLES	3 // The number of successive matching periods required before a cell's cycle is considered stable
+
+// Profiled phases (every phase but setup is timed per mutant)
+#define PHASE_MODEL		0
+#define PHASE_FEATURES	1
+#define PHASE_TESTS		2
+#define PHASE_PRINT		3
+#define PHASE_SETUP		4
+#define NUM_PHASES		5
+
+// Profiled event counts
+#define COUNT_TIME_STEPS	0
+#define COUNT_SPLITS		1
+#define COUNT_SPLIT_DEPTH	2 // The deepest index_with_splits recursion (a maximum rather than a sum)
+#define COUNT_FEATURES		3
+#define COUNT_OUTPUT_STALLS	4 // The number of times the simulating thread waited for room in the output queue
+#define NUM_COUNTS			5
+
+// Memory accounting subsystems (the tag every allocation is counted under)
+#define MEM_OTHER		0
+#define MEM_CON_LEVELS	1 // The concentration levels simulated and analyzed
+#define MEM_SNAPSHOTS	2 // The mutants' copies of the concentration levels and the wild type's forks
+#define MEM_FEATURES	3 // Feature analysis, including the analysis threads
+#define MEM_OUTPUT		4 // Output buffers, the output queue, and the pack
+#define NUM_MEM_TAGS	5
+#define MEM_ALL			NUM_MEM_TAGS // Indexes the counters for every subsystem together
+
+// Memory accounting windows (each keeps its own peaks since it was last marked)
+#define MEM_WINDOW_RUN		0
+#define MEM_WINDOW_SET		1
+#define MEM_WINDOW_PHASE	2
+#define NUM_MEM_WINDOWS		3
+
 // Exit statuses
 #define EXIT_SUCCESS			0
 #define EXIT_MEMORY_ERROR		1
@@ -270,6 +353,7 @@ macros.hpp contains every constant and macro function used in the program.
 #define EXIT_PIPE_READ_ERROR	4
 #define EXIT_PIPE_WRITE_ERROR	5
 #define EXIT_INPUT_ERROR		6
+#define EXIT_THREAD_ERROR		7
 
 // Macros for commonly used functions small enough to inject directly into the code
 #define ABS(x) ((x) < 0 ? -(x) : (x))
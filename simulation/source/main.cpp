@@ -24,8 +24,12 @@ Avoid putting functions in main.cpp that could be put in a more specific file.
 #include "main.hpp" // Function declarations
 
 #include "init.hpp"
+#include "io.hpp"
 #include "sim.hpp"
 #include "debug.hpp"
+#include "profile.hpp"
+#include "threads.hpp"
+#include "pack.hpp"
 
 using namespace std;
 
@@ -46,12 +50,14 @@ int main(int argc, char** argv) {
 	init_terminal();
 	accept_input_params(argc, argv, ip);
 	init_verbosity(ip);
+	init_profiler(ip);
 	
 	// Read the specified input files
 	input_data params_data(ip.params_file);
 	input_data ranges_data(ip.ranges_file);
 	input_data perturb_data(ip.perturb_file);
 	input_data gradients_data(ip.gradients_file);
+	input_data mutants_data(ip.mutants_file);
 	
 	// Ensure the program's input is semantically valid and translate it to the program's structures
 	check_input_params(ip);
@@ -59,27 +65,44 @@ int main(int argc, char** argv) {
 	read_sim_params(ip, params_data, sets, ranges_data);
 	read_perturb_params(ip, perturb_data);
 	read_gradients_params(ip, gradients_data);
+	read_mutants_params(ip, mutants_data);
+	
+	// Place the simulating thread and its large buffers before anything is allocated for the simulations
+	init_thread_affinity(ip);
+	set_huge_pages(ip.huge_pages);
 	
 	// Initialize simulation data, rates (and their perturbations and gradients), and mutant data
 	sim_data sd(ip);
 	rates* rs = new rates(sd.width_total, sd.cells_total);
 	fill_perturbations(*rs, perturb_data.buffer);
 	fill_gradients(*rs, gradients_data.buffer);
-	calc_max_delay_size(ip, sd, *rs, sets);
-	mutant_data* mds = create_mutant_data(sd, ip);
+	mutant_data* mds = create_mutant_data(sd, ip, mutants_data.buffer);
 	sd.initialize_conditions_data(mds);
+	read_mutant_stats(ip, mds);
+	init_thread_pool(ip, sd);
+	init_output_writer(ip);
 	
 	// Create the specified output files
-	ofstream* file_passed = create_passed_file(ip);
-	ofstream* file_conditions = create_conditions_file(ip, mds);
+	profile_start(PHASE_SETUP);
+	output_file* file_passed = create_passed_file(ip);
+	output_file* file_conditions = create_conditions_file(ip, mds);
 	char** filenames_dirs = create_dirs(ip, sd, mds);
-	ofstream* file_features = create_features_file(ip, mds);
-	ofstream* file_scores = create_scores_file(ip, mds);
+	init_pack(ip);
+	output_file* file_features = create_features_file(ip, mds);
+	output_file* file_scores = create_scores_file(ip, mds);
+	output_file* file_features_db = create_features_db_file(ip, mds);
+	profile_end(PHASE_SETUP);
 	
 	// Perform the actual simulations
-	simulate_all_params(ip, *rs, sd, sets, mds, file_passed, file_scores, filenames_dirs, file_features, file_conditions);
+	if (ip.rescore) {
+		rescore_all_params(ip, *rs, sd, mds, file_passed, file_scores, file_features, file_conditions);
+	} else {
+		simulate_all_params(ip, *rs, sd, sets, mds, file_passed, file_scores, filenames_dirs, file_features, file_conditions, file_features_db);
+	}
+	print_mutant_stats(ip, mds);
 	
 	// Free used memory, close files, etc.
+	free_thread_pool(sd);
 	delete_mutant_data(mds);
 	delete rs;
 	delete_dirs(ip, filenames_dirs);
@@ -87,7 +110,11 @@ int main(int argc, char** argv) {
 	delete_file(file_conditions);
 	delete_file(file_passed);
 	delete_file(file_scores);
+	delete_file(file_features_db);
+	free_pack();
+	free_output_writer();
 	delete_sets(sets, ip);
+	free_profiler();
 	#if defined(MEMTRACK)
 		print_heap_usage();
 	#endif
@@ -117,20 +144,31 @@ void usage (const char* message) {
 	cout << "-R, --ranges-file        [filename]   : the relative filename of the parameter ranges input file, default=none" << endl;
 	cout << "-u, --perturb-file       [filename]   : the relative filename of the perturbations input file, default=none" << endl;
 	cout << "-r, --gradients-file     [filename]   : the relative filename of the gradients input file, default=none" << endl;
+	cout << "    --mutants-file       [filename]   : the relative filename of the mutants input file, which replaces the coded-in mutants, default=none" << endl;
 	cout << "-o, --print-passed       [filename]   : the relative filename of the passed sets output file, default=none" << endl;
 	cout << "-t, --print-cons         [N/A]        : print concentration values to the specified output directory, default=unused" << endl;
 	cout << "-B, --binary-cons-output [N/A]        : print concentration values as binary numbers rather than ASCII, default=unused" << endl;
+	cout << "    --print-species      [names]      : a comma-separated list of the mRNAs to print concentrations of (mh1, mh7, mespa, mespb, mh13, mdelta), each to its own file, default=each mutant's usual mRNA" << endl;
+	cout << "    --print-window       [int,int]    : the first and last minute to print concentrations of, default=every minute simulated" << endl;
+	cout << "    --print-rows         [int,int]    : the first and last row of cells to print concentrations of, default=every row" << endl;
+	cout << "    --print-columns      [int,int]    : the first and last column of cells, counted from the posterior end, to print concentrations of, default=every column" << endl;
+	cout << "    --print-every        [int]        : print concentrations of only every this many stored time steps (see -b), min=1, default=1" << endl;
+	cout << "    --npy-output         [N/A]        : print concentrations and cell columns as NumPy .npy arrays (one per section) rather than text, default=unused" << endl;
 	cout << "-f, --print-osc-features [filename]   : the relative filename of the file summarizing all the oscillation features, default=none" << endl;
-	cout << "-V, --her1-induction     [int]        : the induction point for her1 overexpression" << endl;
-	cout << "-Y, --her7-induction     [int]        : the induction point for her7 overexpression" << endl;
-	cout << "-Z, --DAPT-induction     [int]        : the induction point for DAPT treatment" << endl;
-	cout << "-Q, --mespa-induction     [int]        : the induction point for mespa overexpression" << endl;
-	cout << "-K, --mespb-induction     [int]        : the induction point for mespb overexpression" << endl;
+	cout << "-V, --her1-induction     [int]        : the induction point for her1 overexpression in minutes, default=600" << endl;
+	cout << "-Y, --her7-induction     [int]        : the induction point for her7 overexpression in minutes, default=600" << endl;
+	cout << "-Z, --DAPT-induction     [int]        : the induction point for DAPT treatment in minutes, default=600" << endl;
+	cout << "-Q, --mespa-induction     [int]        : the induction point for mespa overexpression in minutes, default=600" << endl;
+	cout << "-K, --mespb-induction     [int]        : the induction point for mespb overexpression in minutes, default=600" << endl;
 	cout << "-D, --directory-path     [directory]  : the relative directory where concentrations or anterior oscillation features files will be printed, default=none" << endl;
 	cout << "-A, --anterior-feats     [N/A]        : print in depth oscillation features for the anterior cells over time, default=unused" << endl;
 	cout << "-P, --posterior-feats    [N/A]        : print in depth oscillation features for the posterior cells over time, default=unused" << endl;
 	cout << "-W, --print-conditions   [filename]   : the relative filename of the passed and failed conditions file, default=none" << endl;
 	cout << "-E, --print-scores       [filename]   : the relative filename of the mutant scores file, default=none" << endl;
+	cout << "    --features-db        [filename]   : the relative filename of the binary database to store what every mutant's tests read in, default=none" << endl;
+	cout << "    --rescore            [filename]   : rescore the sets stored in the given features database with the current conditions instead of simulating, default=none" << endl;
+	cout << "    --async-output       [int]        : the megabytes of output a background thread may have queued for writing, default=0 (output is written by the simulating thread)" << endl;
+	cout << "    --pack               [filename]   : the relative filename of a pack file to store the concentrations and oscillation features files in instead of the -D directory, default=none" << endl;
 	cout << "-L, --print-cells        [int]        : the number of columns of cells to print for plotting of single cells on top of each other, min=0, default=0" << endl;
 	cout << "-b, --big-granularity    [int]        : the granularity in time steps with which to store data, min=1, default=1" << endl;
 	cout << "-g, --small-granularity  [int]        : the granularity in time steps with which to simulate data, min=1, default=1" << endl;
@@ -147,10 +185,20 @@ void usage (const char* message) {
 	cout << "-d, --parameters-seed    [int]        : the seed to generate random parameter sets, min=1, default=generated from the time and process ID" << endl;
 	cout << "-e, --print-seeds        [filename]   : the relative filename of the seed output file, default=none" << endl;
 	cout << "-a, --max-con-threshold  [float]      : the concentration threshold at which to fail the simulation, min=1, default=infinity" << endl;
-	cout << "-C, --short-circuit      [N/A]        : stop simulating a parameter set after a mutant fails, default=unused" << endl;
-	cout << "-M, --mutants            [int]        : the number of mutants to run for each parameter set, min=1, max=" << NUM_MUTANTS << ", default=" << NUM_MUTANTS << endl;
-	cout << "-I, --pipe-in            [file desc.] : the file descriptor to pipe data from (usually passed by the sampler), default=none" << endl;
-	cout << "-O, --pipe-out           [file desc.] : the file descriptor to pipe data into (usually passed by the sampler), default=none" << endl;
+	cout << "-C, --short-circuit      [N/A]        : stop simulating a parameter set after a mutant fails, trying the wild type first and then the mutants that fail most often for the least work, default=unused" << endl;
+	cout << "    --analysis-threads   [int]        : the number of threads to analyze oscillation features with (results are identical for any number), min=1, default=1" << endl;
+	cout << "    --feature-backend    [string]     : how posterior periods and amplitudes are estimated: crit (from peaks and troughs) or spectral (from Goertzel filters, bounded cost), default=crit" << endl;
+	cout << "    --huge-pages         [string]     : back the concentration levels with huge pages: none, thp (transparent huge pages, advised with madvise), or explicit (the kernel's reserved pool, falling back to thp), default=none" << endl;
+	cout << "    --pin-threads        [N/A]        : pin the simulating thread and each analysis thread to its own CPU so the memory each first touches stays on its NUMA node, default=unused" << endl;
+	cout << "    --mutant-stats       [filename]   : the file to load the mutants' failure rates and costs from (if it exists) and save them to, used to order mutants when short circuiting, default=none" << endl;
+	cout << "    --fork-inductions    [N/A]        : resume induced mutants' posterior simulations from the wild type's state at their induction instead of simulating the shared start again (results are identical), default=unused" << endl;
+	cout << "    --limit-cycle        [float]      : stop posterior simulations once successive periods and peak heights agree within this relative tolerance (e.g. 0.002), min=0, default=0 (never)" << endl;
+	cout << "    --profile            [filename]   : time the phases of every mutant and count simulation events, reporting them as JSON to the specified file, default=none" << endl;
+	cout << "-M, --mutants            [int]        : the number of mutants to run for each parameter set (the first ones defined), min=1, max=the number of defined mutants, default=all" << endl;
+	cout << "    --select-mutants     [names]      : a comma-separated list of the directory names of the mutants to run instead of the first ones (the wild type always runs, not with -M), default=none" << endl;
+	cout << "    --sections           [names]      : a comma-separated list of the sections to score (post, ant, wave), the anterior is only simulated if ant or wave is scored, default=post,ant,wave" << endl;
+	cout << "-I, --pipe-in            [file desc.] : the file descriptor to pipe data from, a pipe end or shared-memory ring (usually passed by the sampler), default=none" << endl;
+	cout << "-O, --pipe-out           [file desc.] : the file descriptor to pipe data into, a pipe end or shared-memory ring (usually passed by the sampler), default=none" << endl;
 	cout << "-c, --no-color           [N/A]        : disable coloring the terminal output, default=unused" << endl;
 	cout << "-v, --verbose            [N/A]        : print detailed messages about the program and simulation state, default=unused" << endl;
 	cout << "-q, --quiet              [N/A]        : hide the terminal output, default=unused" << endl;
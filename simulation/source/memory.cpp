@@ -18,9 +18,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 /*
 memory.cpp contains functions related to memory management. All memory related functions should be placed in this file.
-Many features and functions are enabled only when scons-compiling with 'memtrack=1', which defines the MEMTRACK macro used for memory tracking.
+Every allocation is counted under the subsystem the allocating thread is working on, and the peaks of the counts are kept for the whole run, the current parameter set, and the current profiled phase. The counts are updated with relaxed atomic operations so they are cheap enough to always keep.
+Some features and functions are enabled only when scons-compiling with 'memtrack=1', which defines the MEMTRACK macro used to print a summary of heap usage at exit.
 */
 
+#include <sys/mman.h> // Needed for mmap, madvise, munmap
+
 #include "memory.hpp" // Function declarations
 
 #include "structs.hpp"
@@ -29,11 +32,92 @@ extern terminal* term; // Declared in init.cpp
 
 using namespace std;
 
-// Variables the memory tracker uses to keep track of heap usage
-#if defined(MEMTRACK)
-	size_t heap_current = 0;
-	size_t heap_total = 0;
-#endif
+// Variables the memory accounting uses to keep track of heap usage (updated atomically since worker threads allocate too)
+static size_t heap_current[NUM_MEM_TAGS + 1] = {0}; // The bytes in use by each subsystem and, at MEM_ALL, by all of them
+static size_t heap_peaks[NUM_MEM_WINDOWS][NUM_MEM_TAGS + 1] = {{0}}; // The most bytes in use by each subsystem and by all of them since each window was marked
+static size_t heap_total = 0; // The bytes allocated since the program started
+static __thread int memory_tag = MEM_OTHER; // The subsystem the calling thread's allocations are counted under
+static int huge_pages = HUGE_PAGES_NONE; // How allocate_pages backs the buffers it allocates
+
+static const char* memory_tag_names[NUM_MEM_TAGS] = {"other", "con_levels", "snapshots", "features", "output"};
+
+/* raise_peak raises the given peak to the given amount if it is lower
+	parameters:
+		peak: a pointer to the peak to raise
+		amount: the amount in use
+	returns: nothing
+	notes:
+		Other threads may be raising the same peak, so the comparison is retried until the peak is at least the given amount.
+	todo:
+*/
+static inline void raise_peak (size_t* peak, size_t amount) {
+	size_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+	while (amount > old && !__atomic_compare_exchange_n(peak, &old, amount, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+/* count_allocation fills in the given block's header and counts it under the calling thread's subsystem
+	parameters:
+		header: the header at the start of the block
+		size: the number of bytes requested
+		mapped: whether the block was mapped by allocate_pages
+	returns: a pointer to the memory after the header
+	notes:
+	todo:
+*/
+static void* count_allocation (memory_header* header, size_t size, bool mapped) {
+	int tag = memory_tag;
+	header->size = size;
+	header->tag = tag;
+	header->mapped = mapped;
+	size_t in_tag = __atomic_add_fetch(&(heap_current[tag]), size, __ATOMIC_RELAXED);
+	size_t in_all = __atomic_add_fetch(&(heap_current[MEM_ALL]), size, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&heap_total, size, __ATOMIC_RELAXED);
+	for (int i = 0; i < NUM_MEM_WINDOWS; i++) {
+		raise_peak(&(heap_peaks[i][tag]), in_tag);
+		raise_peak(&(heap_peaks[i][MEM_ALL]), in_all);
+	}
+	return (void*)(header + 1);
+}
+
+/* mapped_length returns the number of bytes allocate_pages maps for a block of the given size
+	parameters:
+		size: the number of bytes requested
+	returns: the size of the block and its header rounded up to a whole number of huge pages
+	notes:
+	todo:
+*/
+static size_t mapped_length (size_t size) {
+	return (sizeof(memory_header) + size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+/* map_pages maps the given number of bytes, backed by huge pages as set by set_huge_pages
+	parameters:
+		length: the number of bytes to map, a multiple of HUGE_PAGE_SIZE
+	returns: a pointer to the mapping, aligned to HUGE_PAGE_SIZE, or NULL if it could not be mapped
+	notes:
+		Explicit huge pages come from the kernel's reserved pool (see /proc/sys/vm/nr_hugepages), so when too few are reserved the mapping falls back to transparent huge pages.
+		Transparent huge pages are only used by the kernel for aligned ranges, so a huge page more than needed is mapped and the unaligned ends are unmapped.
+	todo:
+*/
+static void* map_pages (size_t length) {
+	if (huge_pages == HUGE_PAGES_EXPLICIT) {
+		void* mem = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mem != MAP_FAILED) {
+			return mem;
+		}
+	}
+	char* mem = (char*)mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		return NULL;
+	}
+	char* aligned = (char*)(((size_t)mem + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+	if (aligned > mem) {
+		munmap(mem, aligned - mem);
+	}
+	munmap(aligned + length, mem + HUGE_PAGE_SIZE - aligned);
+	madvise(aligned, length, MADV_HUGEPAGE);
+	return aligned;
+}
 
 /* mallocate allocates a block of memory with the given size
 	parameters:
@@ -41,56 +125,144 @@ using namespace std;
 	returns: a pointer to the block of memory allocated
 	notes:
 		This function is a thin wrapper for malloc that exits if the memory cannot be allocated or a nonpositive size is given.
-		If memory tracking is enabled, extra bytes are allocated with every request to store the size of the request. The memory tracker does not count these extra bytes when reporting heap usage.
+		A memory_header is allocated before every block to store the size of the request and the subsystem it is counted under. The memory accounting does not count these extra bytes when reporting heap usage.
 		Memory allocated with mallocate should be freed with mfree, not free.
+		This function may be called from several threads at once; the memory accounting updates its counters atomically.
 	todo:
 */
 void* mallocate (size_t size) {
 	if (size > 0) {
-		void* block;
-		#if defined(MEMTRACK)
-			block = malloc(sizeof(size_t) + size);
-		#else
-			block = malloc(size);
-		#endif
-		if (block == NULL) {
+		memory_header* header = (memory_header*)malloc(sizeof(memory_header) + size);
+		if (header == NULL) {
 			term->no_memory();
 			exit(EXIT_MEMORY_ERROR);
 		}
-		#if defined(MEMTRACK)
-			heap_current += size;
-			heap_total += size;
-			size_t* sizeblock = (size_t*)block;
-			*sizeblock = size;
-			return (void*)(sizeblock + 1);
-		#else
-			return block;
-		#endif
+		return count_allocation(header, size, false);
 	} else {
 		cout << term->red << "The specified amount of memory to allocate (" << size << " B) must be a positive integer!" << term->reset << endl;
 		exit(EXIT_MEMORY_ERROR);
 	}
 }
 
+/* allocate_pages allocates a large buffer, backed by huge pages if the user asked for them
+	parameters:
+		size: the number of bytes to allocate
+	returns: a pointer to the block of memory allocated
+	notes:
+		Buffers smaller than a huge page and every buffer when huge pages were not requested are allocated with mallocate.
+		The mapped memory is zeroed by the kernel but not touched, so each page is placed on the NUMA node of the thread that first writes to it.
+		Memory allocated with allocate_pages should be freed with mfree like any other.
+	todo:
+*/
+void* allocate_pages (size_t size) {
+	if (huge_pages == HUGE_PAGES_NONE || size < HUGE_PAGE_SIZE) {
+		return mallocate(size);
+	}
+	memory_header* header = (memory_header*)map_pages(mapped_length(size));
+	if (header == NULL) {
+		term->no_memory();
+		exit(EXIT_MEMORY_ERROR);
+	}
+	return count_allocation(header, size, true);
+}
+
+/* set_huge_pages sets how allocate_pages backs the buffers it allocates
+	parameters:
+		mode: HUGE_PAGES_NONE, HUGE_PAGES_THP, or HUGE_PAGES_EXPLICIT
+	returns: nothing
+	notes:
+		Buffers already allocated keep the pages they have.
+	todo:
+*/
+void set_huge_pages (int mode) {
+	huge_pages = mode;
+}
+
 /* mfree frees the given block of memory
 	parameters:
 		mem: a pointer to the block of memory to free
 	returns: nothing
 	notes:
-		This function is a thin wrapper for free that ensures the extra bytes allocated when memory tracking is on are also freed.
-		Always use this function to free memory allocated with mallocate since free will not work properly when memory tracking is on.
+		This function is a thin wrapper for free that ensures the memory_header allocated before the block is also freed.
+		Always use this function to free memory allocated with mallocate since free will not work properly on it.
+		The block is uncounted from the subsystem it was allocated under, whichever the calling thread is working on.
+		Blocks mapped by allocate_pages are unmapped.
 	todo:
 */
 void mfree (void* mem) {
-	#if defined(MEMTRACK)
-		if (mem != NULL) {
-			size_t* memblock = (size_t*)mem - 1;
-			heap_current -= *memblock;
-			free(memblock);
+	if (mem != NULL) {
+		memory_header* header = (memory_header*)mem - 1;
+		__atomic_fetch_sub(&(heap_current[header->tag]), header->size, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&(heap_current[MEM_ALL]), header->size, __ATOMIC_RELAXED);
+		if (header->mapped) {
+			munmap(header, mapped_length(header->size));
+		} else {
+			free(header);
 		}
-	#else
-		free(mem);
-	#endif
+	}
+}
+
+/* set_memory_tag sets the subsystem the calling thread's allocations are counted under
+	parameters:
+		tag: the subsystem to count allocations under (see MEM_OTHER, MEM_CON_LEVELS, etc.)
+	returns: the subsystem allocations were counted under before
+	notes:
+		Prefer memory_scope, which restores the previous subsystem when it goes out of scope.
+	todo:
+*/
+int set_memory_tag (int tag) {
+	int previous = memory_tag;
+	memory_tag = tag;
+	return previous;
+}
+
+/* mark_memory_window starts the given window over, lowering its peaks to the amounts currently in use
+	parameters:
+		window: the window to mark (see MEM_WINDOW_RUN, MEM_WINDOW_SET, etc.)
+	returns: nothing
+	notes:
+		Allocations made by other threads while the window is being marked may raise its peaks before or after they are lowered, which only matters when peaks are read to the byte.
+	todo:
+*/
+void mark_memory_window (int window) {
+	for (int i = 0; i <= MEM_ALL; i++) {
+		__atomic_store_n(&(heap_peaks[window][i]), __atomic_load_n(&(heap_current[i]), __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	}
+}
+
+/* memory_in_use returns the number of bytes the given subsystem is using
+	parameters:
+		tag: the subsystem, or MEM_ALL for every subsystem
+	returns: the number of bytes in use
+	notes:
+	todo:
+*/
+size_t memory_in_use (int tag) {
+	return __atomic_load_n(&(heap_current[tag]), __ATOMIC_RELAXED);
+}
+
+/* memory_peak returns the most bytes the given subsystem has used since the given window was marked
+	parameters:
+		window: the window (see MEM_WINDOW_RUN, MEM_WINDOW_SET, etc.)
+		tag: the subsystem, or MEM_ALL for every subsystem
+	returns: the peak number of bytes in use
+	notes:
+		Each subsystem's peak is its own, so the peaks of the subsystems may have been reached at different times and can add up to more than the peak of all of them.
+	todo:
+*/
+size_t memory_peak (int window, int tag) {
+	return __atomic_load_n(&(heap_peaks[window][tag]), __ATOMIC_RELAXED);
+}
+
+/* memory_tag_name returns the name of the given subsystem used in reports
+	parameters:
+		tag: the subsystem
+	returns: the name
+	notes:
+	todo:
+*/
+const char* memory_tag_name (int tag) {
+	return memory_tag_names[tag];
 }
 
 /* new overloads the usual new with mallocate instead of malloc
@@ -142,6 +314,31 @@ void operator delete[] (void* mem) {
 	mfree(mem);
 }
 
+/* delete overloads the usual sized delete with mfree instead of free
+	parameters:
+		mem: a pointer to the block of memory to free
+		size: the size of the object being deleted (unused since the memory_header stores it)
+	returns: nothing
+	notes:
+		Compilers call the sized versions of delete when they know the object's size, so these must be overloaded too or the memory_header would not be freed with the block.
+	todo:
+*/
+void operator delete (void* mem, size_t size) {
+	mfree(mem);
+}
+
+/* delete[] overloads the usual sized delete[] with mfree instead of free
+	parameters:
+		mem: a pointer to the block of memory to free
+		size: the size of the array being deleted (unused since the memory_header stores it)
+	returns: nothing
+	notes:
+	todo:
+*/
+void operator delete[] (void* mem, size_t size) {
+	mfree(mem);
+}
+
 #if defined(MEMTRACK)
 
 /* print_mem_amount prints the given number of bytes in a human-friendly format
@@ -153,8 +350,8 @@ void operator delete[] (void* mem) {
 */
 static void print_mem_amount (size_t mem) {
 	static size_t kB = 1024;
-	static size_t MB = square(1024);
-	static size_t GB = cube(1024);
+	static size_t MB = SQUARE(1024);
+	static size_t GB = CUBE(1024);
 	double dmem = mem;
 	
 	if (mem > GB) {
@@ -169,21 +366,27 @@ static void print_mem_amount (size_t mem) {
 	cout << endl;
 }
 
-/* print_heap_usage prints the current and total heap usage calculated with the memory tracker
+/* print_heap_usage prints the current, peak, and total heap usage calculated with the memory accounting
 	parameters:
 	returns: nothing
 	notes:
 		Current heap usage indicates how much unfreed memory is on the heap.
+		Peak heap usage indicates the most memory that was on the heap at once, which is what a job's memory request should cover.
 		Total heap usage indicates how much memory has been allocated since the program's inception.
 		Do not call this function after free_terminal or reset_cout since it uses terminal colors allocated by init_terminal and quiet mode does not work after reset_cout.
 	todo:
 */
 void print_heap_usage () {
 	cout << term->blue << "Current heap usage:\t" << term->reset;
-	print_mem_amount(heap_current);
+	print_mem_amount(memory_in_use(MEM_ALL));
+	cout << term->blue << "Peak heap usage:\t" << term->reset;
+	print_mem_amount(memory_peak(MEM_WINDOW_RUN, MEM_ALL));
+	for (int i = 0; i < NUM_MEM_TAGS; i++) {
+		cout << term->blue << "  Peak " << memory_tag_names[i] << ":\t" << term->reset;
+		print_mem_amount(memory_peak(MEM_WINDOW_RUN, i));
+	}
 	cout << term->blue << "Total heap usage:\t" << term->reset;
 	print_mem_amount(heap_total);
 }
 
 #endif
-
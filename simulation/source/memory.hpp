@@ -29,6 +29,13 @@ using namespace std;
 
 void* mallocate(size_t);
 void mfree(void*);
+void* allocate_pages(size_t);
+void set_huge_pages(int);
+int set_memory_tag(int);
+void mark_memory_window(int);
+size_t memory_in_use(int);
+size_t memory_peak(int, int);
+const char* memory_tag_name(int);
 #if defined(MEMTRACK)
 	void print_heap_usage();
 #endif
@@ -0,0 +1,234 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+pack.cpp contains the functions that write the pack file (see --pack) and read it back. All pack related functions should be placed in this file.
+A pack holds, in one file, the concentrations and oscillation features files the simulation would otherwise print to a directory per mutant, so a run creates one file instead of one per set, mutant, and species. The files' contents are unchanged; each is stored as a record keyed by its set, mutant directory name, and file name suffix.
+*/
+
+#include "pack.hpp" // Function declarations
+
+#include "io.hpp"
+
+using namespace std;
+
+extern terminal* term; // Declared in init.cpp
+
+static pack_writer* pack = NULL; // The pack being written, NULL if output files are printed to directories
+
+static bool read_pack_string(ifstream&, string&);
+
+/* init_pack creates the pack file if the user specified one
+	parameters:
+		ip: the program's input parameters
+	returns: nothing
+	notes:
+	todo:
+*/
+void init_pack (input_params& ip) {
+	if (ip.pack_file == NULL) {
+		return;
+	}
+	memory_scope scope(MEM_OUTPUT);
+	pack = new pack_writer();
+	open_output(&(pack->file), ip.pack_file, false);
+	pack->file.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+	pack->offset = sizeof(PACK_MAGIC);
+}
+
+/* free_pack writes the pack's index and closes it
+	parameters:
+	returns: nothing
+	notes:
+		The index is written last, so a pack whose run did not finish has its chunks but cannot be read.
+	todo:
+*/
+void free_pack () {
+	if (pack == NULL) {
+		return;
+	}
+	string index = pack->index.str();
+	pack->file.write((char*)(&(pack->num_entries)), sizeof(int));
+	pack->file.write(index.data(), index.size());
+	pack->file.write((char*)(&(pack->offset)), sizeof(long long));
+	pack->file.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+	close_output(&(pack->file));
+	delete pack;
+	pack = NULL;
+}
+
+/* packing returns whether or not output files are stored in the pack
+	parameters:
+	returns: true if there is a pack, false otherwise
+	notes:
+	todo:
+*/
+bool packing () {
+	return pack != NULL;
+}
+
+/* open_pack_record prepares the given output stream to write a record to the pack
+	parameters:
+		file_pointer: a pointer to the output stream
+		file_name: the name the record would have as a file, which is only printed
+		dirname: the mutant's directory name, with a trailing slash
+		set_num: the index of the parameter set the record belongs to
+		type: the record's file name suffix (after "set_<n>")
+		append: if true, the record continues one written earlier, otherwise it starts a new one
+	returns: nothing
+	notes:
+	todo:
+*/
+void open_pack_record (output_file* file_pointer, char* file_name, char* dirname, int set_num, const char* type, bool append) {
+	cout << term->blue << "Packing " << term->reset << file_name << " . . . ";
+	int length = strlen(dirname);
+	file_pointer->pack_mutant = copy_str(dirname);
+	if (length > 0 && dirname[length - 1] == '/') {
+		file_pointer->pack_mutant[length - 1] = '\0';
+	}
+	file_pointer->pack_type = copy_str(type);
+	file_pointer->pack_set = set_num;
+	file_pointer->append = append;
+	file_pointer->rdbuf(&(file_pointer->buffer));
+	term->done();
+}
+
+/* pack_chunk appends what was written to the given output stream since its last hand-off to the pack as a chunk of its record
+	parameters:
+		file_pointer: a pointer to the output stream
+	returns: nothing
+	notes:
+		The pack file is itself an output stream, so with a background writer the chunks are written by it.
+	todo:
+*/
+void pack_chunk (output_file* file_pointer) {
+	string data = file_pointer->buffer.str();
+	long long size = data.size();
+	int mutant_length = strlen(file_pointer->pack_mutant);
+	int type_length = strlen(file_pointer->pack_type);
+	pack->file.write(data.data(), size);
+	pack->index.write((char*)(&(file_pointer->pack_set)), sizeof(int));
+	pack->index.write((char*)(&mutant_length), sizeof(int));
+	pack->index.write(file_pointer->pack_mutant, mutant_length);
+	pack->index.write((char*)(&type_length), sizeof(int));
+	pack->index.write(file_pointer->pack_type, type_length);
+	pack->index.write((char*)(&(pack->offset)), sizeof(long long));
+	pack->index.write((char*)(&size), sizeof(long long));
+	pack->offset += size;
+	pack->num_entries++;
+	hand_off_if_full(&(pack->file));
+}
+
+/* open_pack opens the given pack file and reads its index
+	parameters:
+		reader: the pack reader to open the file with
+		file_name: the path and name of the pack file
+	returns: true if the pack was opened, false if it could not be read or is not a complete pack
+	notes:
+	todo:
+*/
+bool open_pack (pack_reader& reader, const char* file_name) {
+	reader.file.open(file_name, fstream::in | fstream::binary);
+	char magic[sizeof(PACK_MAGIC)];
+	reader.file.read(magic, sizeof(magic));
+	if (!reader.file || memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0) {
+		return false;
+	}
+	
+	// Find the index from the footer
+	long long index_offset = 0;
+	reader.file.seekg(-(long long)(sizeof(long long) + sizeof(PACK_MAGIC)), ios::end);
+	reader.file.read((char*)(&index_offset), sizeof(long long));
+	reader.file.read(magic, sizeof(magic));
+	if (!reader.file || memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0) {
+		return false;
+	}
+	
+	// Read the index
+	reader.file.seekg(index_offset);
+	reader.file.read((char*)(&(reader.num_entries)), sizeof(int));
+	if (!reader.file || reader.num_entries < 0) {
+		return false;
+	}
+	delete[] reader.entries;
+	reader.entries = new pack_entry[reader.num_entries + 1]; // +1 so an empty pack still allocates
+	for (int i = 0; i < reader.num_entries; i++) {
+		pack_entry& entry = reader.entries[i];
+		reader.file.read((char*)(&(entry.set)), sizeof(int));
+		if (!read_pack_string(reader.file, entry.mutant) || !read_pack_string(reader.file, entry.type)) {
+			return false;
+		}
+		reader.file.read((char*)(&(entry.offset)), sizeof(long long));
+		reader.file.read((char*)(&(entry.size)), sizeof(long long));
+		if (!reader.file || entry.offset < (long long)sizeof(PACK_MAGIC) || entry.size < 0 || entry.offset + entry.size > index_offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* read_pack_record reads the record with the given key from the given pack
+	parameters:
+		reader: the pack reader with the pack open
+		set_num: the index of the parameter set the record belongs to
+		mutant: the mutant directory name the record belongs to
+		type: the record's file name suffix (after "set_<n>"), e.g. ".cons" or "_period_mh1_post.feats"
+		data: the string to store the record's contents in
+	returns: true if the record was found and read, false otherwise
+	notes:
+		The record is every chunk with the given key, concatenated in the order they were appended.
+	todo:
+*/
+bool read_pack_record (pack_reader& reader, int set_num, const char* mutant, const char* type, string& data) {
+	bool found = false;
+	data.clear();
+	for (int i = 0; i < reader.num_entries; i++) {
+		pack_entry& entry = reader.entries[i];
+		if (entry.set == set_num && entry.mutant == mutant && entry.type == type) {
+			size_t start = data.size();
+			data.resize(start + entry.size);
+			reader.file.seekg(entry.offset);
+			reader.file.read(&data[start], entry.size);
+			if (!reader.file) {
+				return false;
+			}
+			found = true;
+		}
+	}
+	return found;
+}
+
+/* read_pack_string reads a length-prefixed string from the given pack's index
+	parameters:
+		file: the input file stream of the pack
+		str: the string to store what was read in
+	returns: true if the string was read, false otherwise
+	notes:
+	todo:
+*/
+static bool read_pack_string (ifstream& file, string& str) {
+	int length = 0;
+	file.read((char*)(&length), sizeof(int));
+	if (!file || length < 0 || length > 1024) {
+		return false;
+	}
+	str.assign(length, '\0');
+	file.read(&str[0], length);
+	return (bool)file;
+}
+
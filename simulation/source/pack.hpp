@@ -0,0 +1,39 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+pack.hpp contains function declarations for pack.cpp.
+*/
+
+#ifndef PACK_HPP
+#define PACK_HPP
+
+#include "structs.hpp"
+
+using namespace std;
+
+void init_pack(input_params&);
+void free_pack();
+bool packing();
+void open_pack_record(output_file*, char*, char*, int, const char*, bool);
+void pack_chunk(output_file*);
+bool open_pack(pack_reader&, const char*);
+bool read_pack_record(pack_reader&, int, const char*, const char*, string&);
+
+#endif
+
@@ -0,0 +1,246 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+profile.cpp contains functions for timing the phases of a run and reporting them along with memory peaks and event counts. All profiling related functions should be placed in this file.
+Profiling is enabled with --profile, which names the file the report is written to. The report holds one JSON object per line: one for each parameter set (with an entry for every mutant simulated in every section) and a final one for the whole run.
+Memory peaks are in bytes and come from the memory accounting in memory.cpp.
+*/
+
+#include <cstdio> // Needed for sprintf
+#include <ctime> // Needed for clock_gettime
+
+#include "profile.hpp" // Function declarations
+
+#include "io.hpp"
+
+using namespace std;
+
+extern terminal* term; // Declared in init.cpp
+
+profiler* prof = NULL; // The global profiler struct
+
+static const char* phase_names[NUM_PHASES] = {"model", "features", "tests", "print", "setup"};
+static const char* count_names[NUM_COUNTS] = {"time_steps", "splits", "max_split_depth", "features", "output_stalls"};
+static const char* section_names[NUM_SECTIONS] = {"posterior", "anterior", "wave"};
+
+static void report_memory(ostream&, int, size_t[], int);
+static void write_json_string(ostream&, const char*);
+
+/* init_profiler creates and initializes the global profiler struct, opening the report file if profiling was requested
+	parameters:
+		ip: the program's input parameters
+	returns: nothing
+	notes:
+		The profiler is always created so the counting macros can test whether it is enabled.
+	todo:
+*/
+void init_profiler (input_params& ip) {
+	prof = new profiler();
+	if (ip.profile) {
+		prof->enabled = true;
+		prof->file = new ofstream();
+		open_file(prof->file, ip.profile_file, false);
+		prof->run_started = profile_clock();
+	}
+}
+
+/* free_profiler writes the report for the whole run (if profiling) and frees the global profiler struct
+	parameters:
+	returns: nothing
+	notes:
+	todo:
+*/
+void free_profiler () {
+	if (prof->enabled) {
+		*(prof->file) << "{\"run\": {\"time\": " << profile_clock() - prof->run_started << ", \"phases\": {";
+		for (int i = 0; i < NUM_PHASES; i++) {
+			*(prof->file) << (i > 0 ? ", " : "") << "\"" << phase_names[i] << "\": " << prof->run_times[i];
+		}
+		*(prof->file) << "}, \"memory\": ";
+		report_memory(*(prof->file), MEM_WINDOW_RUN, prof->run_peaks, NUM_PHASES);
+		*(prof->file) << "}}" << endl;
+		prof->file->close();
+		delete prof->file;
+	}
+	delete prof;
+}
+
+/* profile_clock returns the current time from a monotonic clock
+	parameters:
+	returns: the time in seconds
+	notes:
+	todo:
+*/
+double profile_clock () {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* profile_start starts timing the given phase
+	parameters:
+		phase: the phase to time
+	returns: nothing
+	notes:
+	todo:
+*/
+void profile_start (int phase) {
+	if (prof->enabled) {
+		mark_memory_window(MEM_WINDOW_PHASE);
+		prof->phase_started[phase] = profile_clock();
+	}
+}
+
+/* profile_end stops timing the given phase and adds the time spent and the memory peak to the current mutant's (unless it is setup) and the run's totals
+	parameters:
+		phase: the phase to stop timing
+	returns: nothing
+	notes:
+	todo:
+*/
+void profile_end (int phase) {
+	if (prof->enabled) {
+		double elapsed = profile_clock() - prof->phase_started[phase];
+		size_t peak = memory_peak(MEM_WINDOW_PHASE, MEM_ALL);
+		if (phase != PHASE_SETUP) {
+			prof->phase_times[phase] += elapsed;
+			prof->phase_peaks[phase] = MAX(prof->phase_peaks[phase], peak);
+		}
+		prof->run_times[phase] += elapsed;
+		prof->run_peaks[phase] = MAX(prof->run_peaks[phase], peak);
+	}
+}
+
+/* profile_mutant adds the times, memory peaks, and counts of the mutant that just finished to the current set's report and resets them for the next mutant
+	parameters:
+		md: the mutant that was simulated
+		section: the section that was simulated
+	returns: nothing
+	notes:
+	todo:
+*/
+void profile_mutant (mutant_data& md, int section) {
+	if (prof->enabled) {
+		ostringstream report;
+		report.precision(9);
+		report << (prof->mutants.empty() ? "" : ", ") << "{\"mutant\": ";
+		write_json_string(report, md.print_name); // Escaped so no name can make the report invalid JSON
+		report << ", \"section\": \"" << section_names[section] << "\", \"phases\": {";
+		for (int i = 0; i < PHASE_SETUP; i++) {
+			report << (i > 0 ? ", " : "") << "\"" << phase_names[i] << "\": " << prof->phase_times[i];
+			prof->set_times[i] += prof->phase_times[i];
+			prof->phase_times[i] = 0;
+		}
+		report << "}, \"memory_phases\": {";
+		for (int i = 0; i < PHASE_SETUP; i++) {
+			report << (i > 0 ? ", " : "") << "\"" << phase_names[i] << "\": " << prof->phase_peaks[i];
+			prof->set_peaks[i] = MAX(prof->set_peaks[i], prof->phase_peaks[i]);
+			prof->phase_peaks[i] = 0;
+		}
+		report << "}, \"counts\": {";
+		for (int i = 0; i < NUM_COUNTS; i++) {
+			report << (i > 0 ? ", " : "") << "\"" << count_names[i] << "\": " << prof->counts[i];
+			if (i == COUNT_SPLIT_DEPTH) {
+				prof->set_counts[i] = MAX(prof->set_counts[i], prof->counts[i]);
+			} else {
+				prof->set_counts[i] += prof->counts[i];
+			}
+			prof->counts[i] = 0;
+		}
+		report << "}}";
+		prof->mutants += report.str();
+	}
+}
+
+/* profile_set writes the report for the given set and resets it for the next set
+	parameters:
+		set_num: the index of the parameter set that was simulated
+	returns: nothing
+	notes:
+	todo:
+*/
+void profile_set (int set_num) {
+	if (prof->enabled) {
+		ofstream& file = *(prof->file);
+		file.precision(9);
+		file << "{\"set\": " << set_num << ", \"phases\": {";
+		for (int i = 0; i < PHASE_SETUP; i++) {
+			file << (i > 0 ? ", " : "") << "\"" << phase_names[i] << "\": " << prof->set_times[i];
+			prof->set_times[i] = 0;
+		}
+		file << "}, \"memory\": ";
+		report_memory(file, MEM_WINDOW_SET, prof->set_peaks, PHASE_SETUP);
+		memset(prof->set_peaks, 0, sizeof(prof->set_peaks));
+		file << ", \"counts\": {";
+		for (int i = 0; i < NUM_COUNTS; i++) {
+			file << (i > 0 ? ", " : "") << "\"" << count_names[i] << "\": " << prof->set_counts[i];
+			prof->set_counts[i] = 0;
+		}
+		file << "}, \"mutants\": [" << prof->mutants << "]}" << endl;
+		prof->mutants.clear();
+	}
+}
+
+/* report_memory writes the memory peaks of the given window and phases as a JSON object
+	parameters:
+		report: the stream to write to
+		window: the memory accounting window to report the peaks of
+		phase_peaks: the peaks of the phases
+		num_phases: the number of phases to report
+	returns: nothing
+	notes:
+		Each subsystem's peak is its own, so the subsystems' peaks can add up to more than the overall peak.
+	todo:
+*/
+static void report_memory (ostream& report, int window, size_t phase_peaks[], int num_phases) {
+	report << "{\"peak\": " << memory_peak(window, MEM_ALL) << ", \"subsystems\": {";
+	for (int i = 0; i < NUM_MEM_TAGS; i++) {
+		report << (i > 0 ? ", " : "") << "\"" << memory_tag_name(i) << "\": " << memory_peak(window, i);
+	}
+	report << "}, \"phases\": {";
+	for (int i = 0; i < num_phases; i++) {
+		report << (i > 0 ? ", " : "") << "\"" << phase_names[i] << "\": " << phase_peaks[i];
+	}
+	report << "}}";
+}
+
+/* write_json_string writes the given string as a quoted JSON string, escaping what JSON requires
+	parameters:
+		report: the stream to write to
+		str: the string to write
+	returns: nothing
+	notes:
+		Quotes, backslashes, and control characters are escaped; every other byte is written as is.
+	todo:
+*/
+static void write_json_string (ostream& report, const char* str) {
+	report << "\"";
+	for (const char* c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			report << '\\' << *c;
+		} else if ((unsigned char)*c < 0x20) {
+			char escaped[7];
+			sprintf(escaped, "\\u%04x", (unsigned char)*c);
+			report << escaped;
+		} else {
+			report << *c;
+		}
+	}
+	report << "\"";
+}
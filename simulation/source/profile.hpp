@@ -0,0 +1,46 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+profile.hpp contains function declarations for profile.cpp as well as the macros used to count events.
+*/
+
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include "structs.hpp"
+
+using namespace std;
+
+extern profiler* prof; // Declared in profile.cpp
+
+// Macros for counting events, cheap enough to leave in hot loops since they only test a flag when profiling is off
+// Each expands to a single statement so it can be the body of an unbraced if or else
+#define PROFILE_COUNT(count, n) do { if (prof->enabled) { prof->counts[(count)] += (n); } } while (0)
+#define PROFILE_MAX(count, n) do { if (prof->enabled) { long long profile_n = (n); if (profile_n > prof->counts[(count)]) { prof->counts[(count)] = profile_n; } } } while (0)
+
+void init_profiler(input_params&);
+void free_profiler();
+double profile_clock();
+void profile_start(int);
+void profile_end(int);
+void profile_mutant(mutant_data&, int);
+void profile_set(int);
+
+#endif
+
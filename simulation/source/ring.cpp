@@ -0,0 +1,293 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ring.cpp contains the functions that move piped data through either a pipe or a shared-memory ring. All shared-memory ring related functions should be placed in this file.
+A sampler can pass the file descriptor of a memfd holding a ring (see ring_header in structs.hpp) wherever it would pass a pipe end. The data sent is framed exactly as it is through a pipe, but each side copies it straight into or out of the shared mapping and only makes a system call to wait for the other, rather than one per value.
+*/
+
+#include <cerrno> // Needed for errno, EINTR
+#include <linux/futex.h> // Needed for FUTEX_WAIT, FUTEX_WAKE
+#include <sys/mman.h> // Needed for mmap, munmap
+#include <sys/stat.h> // Needed for fstat
+#include <sys/syscall.h> // Needed for SYS_futex
+#include <time.h> // Needed for timespec
+#include <unistd.h> // Needed for read, write, close, syscall
+
+#include "ring.hpp" // Function declarations
+
+using namespace std;
+
+extern terminal* term; // Declared in init.cpp
+
+static ring rings[MAX_RINGS]; // The rings attached to pipe ends
+static int num_rings = 0; // The number of attached rings
+
+static ring* find_ring(int);
+static void read_ring(ring*, char*, size_t);
+static void write_ring(ring*, const char*, size_t);
+static void wait_on(unsigned int*, unsigned int);
+static void wake(unsigned int*);
+
+/* init_pipe_end attaches the shared-memory ring the given file descriptor holds, if it holds one rather than a pipe end
+	parameters:
+		fd: the file descriptor passed via -I or --pipe-in or -O or --pipe-out
+	returns: nothing
+	notes:
+		Pipe ends are left as they are. A regular file (as memfds are) must hold a ring or the program exits with an error.
+		Both pipe ends may be the same ring, in which case it is attached once.
+	todo:
+*/
+void init_pipe_end (int fd) {
+	struct stat info;
+	if (fstat(fd, &info) == -1) {
+		term->failed_pipe_read();
+		exit(EXIT_PIPE_READ_ERROR);
+	}
+	if (!S_ISREG(info.st_mode) || find_ring(fd) != NULL) {
+		return;
+	}
+	
+	// Map the whole memfd and check that it holds a ring
+	size_t size = info.st_size;
+	void* mapped = (size_t)info.st_size >= sizeof(ring_header) ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	ring_header* header = (ring_header*)mapped;
+	if (mapped == MAP_FAILED || strcmp(header->magic, RING_MAGIC) != 0 || header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0 || size < sizeof(ring_header) + header->capacity) {
+		cout << term->red << "File descriptor " << fd << " is neither a pipe end nor a shared-memory ring!" << term->reset << endl;
+		exit(EXIT_PIPE_READ_ERROR);
+	}
+	ring& r = rings[num_rings++];
+	r.fd = fd;
+	r.header = header;
+	r.data = (char*)mapped + sizeof(ring_header);
+	r.size = size;
+}
+
+/* read_pipe_bytes reads the given number of bytes from the given pipe end or ring
+	parameters:
+		fd: the file descriptor identifying the pipe end or ring
+		buffer: the address to store the bytes read
+		bytes: the number of bytes to read
+	returns: nothing
+	notes:
+		This function blocks until every byte has arrived, exiting with an error if the pipe or ring is closed first.
+	todo:
+*/
+void read_pipe_bytes (int fd, void* buffer, size_t bytes) {
+	ring* r = find_ring(fd);
+	if (r != NULL) {
+		read_ring(r, (char*)buffer, bytes);
+		return;
+	}
+	char* next = (char*)buffer;
+	while (bytes > 0) {
+		ssize_t bytes_read = read(fd, next, bytes);
+		if (bytes_read == -1 && errno == EINTR) {
+			continue;
+		}
+		if (bytes_read <= 0) {
+			term->failed_pipe_read();
+			exit(EXIT_PIPE_READ_ERROR);
+		}
+		next += bytes_read;
+		bytes -= bytes_read;
+	}
+}
+
+/* write_pipe_bytes writes the given bytes to the given pipe end or ring
+	parameters:
+		fd: the file descriptor identifying the pipe end or ring
+		buffer: the bytes to write
+		bytes: the number of bytes to write
+	returns: nothing
+	notes:
+		This function blocks while the pipe or ring is full.
+	todo:
+*/
+void write_pipe_bytes (int fd, const void* buffer, size_t bytes) {
+	ring* r = find_ring(fd);
+	if (r != NULL) {
+		write_ring(r, (const char*)buffer, bytes);
+		return;
+	}
+	const char* next = (const char*)buffer;
+	while (bytes > 0) {
+		ssize_t bytes_written = write(fd, next, bytes);
+		if (bytes_written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			term->failed_pipe_write();
+			exit(EXIT_PIPE_WRITE_ERROR);
+		}
+		next += bytes_written;
+		bytes -= bytes_written;
+	}
+}
+
+/* close_pipe_end closes the given pipe end or marks the given ring closed and unmaps it
+	parameters:
+		fd: the file descriptor identifying the pipe end or ring
+	returns: nothing
+	notes:
+		A closed ring's reader still receives everything written before it was closed, just as with a pipe.
+	todo:
+*/
+void close_pipe_end (int fd) {
+	ring* r = find_ring(fd);
+	if (r != NULL) {
+		__atomic_store_n(&(r->header->closed), 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&(r->header->reader_waiting), __ATOMIC_SEQ_CST)) {
+			wake(&(r->header->head));
+		}
+		munmap(r->header, r->size);
+		*r = rings[--num_rings];
+	}
+	if (close(fd) == -1) {
+		term->failed_pipe_write();
+		exit(EXIT_PIPE_WRITE_ERROR);
+	}
+}
+
+/* find_ring returns the ring attached to the given file descriptor
+	parameters:
+		fd: the file descriptor to look up
+	returns: the attached ring, NULL if the file descriptor is not a ring
+	notes:
+	todo:
+*/
+static ring* find_ring (int fd) {
+	for (int i = 0; i < num_rings; i++) {
+		if (rings[i].fd == fd) {
+			return &(rings[i]);
+		}
+	}
+	return NULL;
+}
+
+/* read_ring copies the given number of bytes out of the given ring, waiting for the writer whenever the ring is empty
+	parameters:
+		r: the ring to read from
+		buffer: the address to store the bytes read
+		bytes: the number of bytes to read
+	returns: nothing
+	notes:
+		The reader announces it is waiting before checking the head a final time, and the writer checks for a waiting reader after moving the head, so one of them always sees the other.
+	todo:
+*/
+static void read_ring (ring* r, char* buffer, size_t bytes) {
+	ring_header* header = r->header;
+	unsigned int mask = header->capacity - 1;
+	unsigned int tail = header->tail; // Only the reader moves the tail
+	while (bytes > 0) {
+		unsigned int head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+		if (head == tail) {
+			if (__atomic_load_n(&(header->closed), __ATOMIC_ACQUIRE) && __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE) == tail) {
+				term->failed_pipe_read();
+				exit(EXIT_PIPE_READ_ERROR);
+			}
+			__atomic_store_n(&(header->reader_waiting), 1, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&(header->head), __ATOMIC_SEQ_CST) == tail) {
+				wait_on(&(header->head), tail);
+			}
+			__atomic_store_n(&(header->reader_waiting), 0, __ATOMIC_RELAXED);
+			continue;
+		}
+		
+		// Copy what has arrived, in two parts if it wraps around the end of the data
+		size_t chunk = min((size_t)(head - tail), bytes);
+		size_t offset = tail & mask;
+		size_t first = min(chunk, header->capacity - offset);
+		memcpy(buffer, r->data + offset, first);
+		memcpy(buffer + first, r->data, chunk - first);
+		buffer += chunk;
+		bytes -= chunk;
+		tail += chunk;
+		__atomic_store_n(&(header->tail), tail, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&(header->writer_waiting), __ATOMIC_SEQ_CST)) {
+			wake(&(header->tail));
+		}
+	}
+}
+
+/* write_ring copies the given bytes into the given ring, waiting for the reader whenever the ring is full
+	parameters:
+		r: the ring to write to
+		buffer: the bytes to write
+		bytes: the number of bytes to write
+	returns: nothing
+	notes:
+	todo:
+*/
+static void write_ring (ring* r, const char* buffer, size_t bytes) {
+	ring_header* header = r->header;
+	unsigned int mask = header->capacity - 1;
+	unsigned int head = header->head; // Only the writer moves the head
+	while (bytes > 0) {
+		unsigned int tail = __atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE);
+		size_t space = header->capacity - (head - tail);
+		if (space == 0) {
+			__atomic_store_n(&(header->writer_waiting), 1, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&(header->tail), __ATOMIC_SEQ_CST) == tail) {
+				wait_on(&(header->tail), tail);
+			}
+			__atomic_store_n(&(header->writer_waiting), 0, __ATOMIC_RELAXED);
+			continue;
+		}
+		
+		// Copy what fits, in two parts if it wraps around the end of the data
+		size_t chunk = min(space, bytes);
+		size_t offset = head & mask;
+		size_t first = min(chunk, header->capacity - offset);
+		memcpy(r->data + offset, buffer, first);
+		memcpy(r->data, buffer + first, chunk - first);
+		buffer += chunk;
+		bytes -= chunk;
+		head += chunk;
+		__atomic_store_n(&(header->head), head, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&(header->reader_waiting), __ATOMIC_SEQ_CST)) {
+			wake(&(header->head));
+		}
+	}
+}
+
+/* wait_on waits until the given futex word no longer holds the given value or the wait times out
+	parameters:
+		word: the futex word to wait on (a ring's head or tail)
+		value: the value the word held when the caller last checked it
+	returns: nothing
+	notes:
+		The wait times out after RING_WAIT_NS so a reader notices a ring closed without any more data arriving.
+	todo:
+*/
+static void wait_on (unsigned int* word, unsigned int value) {
+	struct timespec timeout = {0, RING_WAIT_NS};
+	syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+/* wake wakes the other side of a ring waiting on the given futex word
+	parameters:
+		word: the futex word (a ring's head or tail)
+	returns: nothing
+	notes:
+	todo:
+*/
+static void wake (unsigned int* word) {
+	syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
@@ -16,12 +16,16 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new> // Needed for placement new
+
 #include "sim.hpp" // Function declarations
 
 #include "debug.hpp"
 #include "feats.hpp"
 #include "init.hpp"
 #include "io.hpp"
+#include "profile.hpp"
+#include "threads.hpp"
 
 using namespace std;
 
@@ -39,25 +43,25 @@ extern terminal* term; // Declared in init.cpp
 		dirnames_cons: the array of mutant directory paths
 		file_features: a pointer to the output file stream of the features file
 		file_conditions: a pointer to the output file stream of the conditions file
+		file_features_db: a pointer to the output file stream of the features database
 	returns: nothing
 	notes:
 	todo:
 		TODO consolidate ofstream parameters.
 */
-void simulate_all_params (input_params& ip, rates& rs, sim_data& sd, double** sets, mutant_data mds[], ofstream* file_passed, ofstream* file_scores, char** dirnames_cons, ofstream* file_features, ofstream* file_conditions) {
+void simulate_all_params (input_params& ip, rates& rs, sim_data& sd, double** sets, mutant_data mds[], output_file* file_passed, output_file* file_scores, char** dirnames_cons, output_file* file_features, output_file* file_conditions, output_file* file_features_db) {
 	// Initialize score data
 	int sets_passed = 0;
 	double score[ip.num_sets];
 	
-	// Initialize the concentration levels structs
-	int max_cl_size = MAX(sd.steps_til_growth, sd.max_delay_size + sd.steps_total - sd.steps_til_growth) / sd.big_gran + 1;
-	con_levels cl(NUM_CON_STORE, max_cl_size, sd.cells_total, sd.active_start); // Concentration levels for analysis and storage
-	con_levels baby_cl(NUM_CON_LEVELS, sd.max_delay_size, sd.cells_total, sd.active_start); // Concentration levels for simulating (time in this cl is treated cyclically)
+	// Declare the concentration levels structs (they are sized for each set's delays by simulate_param_set)
+	con_levels cl; // Concentration levels for analysis and storage
+	con_levels baby_cl; // Concentration levels for simulating (time in this cl is treated cyclically)
 	
 	// Simulate every parameter set
 	for (int i = 0; i < ip.num_sets; i++) {
 		memcpy(rs.rates_base, sets[i], sizeof(double) * NUM_RATES); // Copy the set's rates to the current simulation's rates
-		score[i] = simulate_param_set(i, ip, sd, rs, cl, baby_cl, mds, file_passed, file_scores, dirnames_cons, file_features, file_conditions);
+		score[i] = simulate_param_set(i, ip, sd, rs, cl, baby_cl, mds, file_passed, file_scores, dirnames_cons, file_features, file_conditions, file_features_db);
 		sets_passed += determine_set_passed(sd, i, score[i]); // Calculate the maximum score and whether the set passed
 	}
 	
@@ -69,6 +73,38 @@ void simulate_all_params (input_params& ip, rates& rs, sim_data& sd, double** se
 	cout << endl << term->blue << "Done: " << term->reset << sets_passed << "/" << ip.num_sets << " parameter sets passed all conditions" << endl;
 }
 
+/* rescore_all_params reruns every mutant's tests on the parameter sets stored in the features database instead of simulating them
+	parameters:
+		ip: the program's input parameters
+		rs: the current simulation's rates
+		sd: the current simulation's data
+		mds: the array of all mutant data
+		file_passed: a pointer to the output file stream of the passed file
+		file_scores: a pointer to the output file stream of the scores file
+		file_features: a pointer to the output file stream of the features file
+		file_conditions: a pointer to the output file stream of the conditions file
+	returns: nothing
+	notes:
+		Every set in the database is rescored, in the order it was simulated, and its results are printed to the same output files a simulation prints them to.
+	todo:
+*/
+void rescore_all_params (input_params& ip, rates& rs, sim_data& sd, mutant_data mds[], output_file* file_passed, output_file* file_scores, output_file* file_features, output_file* file_conditions) {
+	ifstream file_db;
+	int db_mutants[MAX_MUTANTS]; // The index of the active mutant each of the database's mutants matches
+	int num_db_mutants = open_features_db(ip, mds, file_db, db_mutants);
+	int num_sets = 0;
+	int sets_passed = 0;
+	int set_num;
+	while (read_features_set(ip, file_db, mds, db_mutants, num_db_mutants, set_num, rs.rates_base)) {
+		double score = rescore_param_set(set_num, ip, sd, rs, mds, file_passed, file_scores, file_features, file_conditions);
+		sets_passed += determine_set_passed(sd, set_num, score);
+		num_sets++;
+	}
+	file_db.close();
+	
+	cout << endl << term->blue << "Done: " << term->reset << sets_passed << "/" << num_sets << " parameter sets passed all conditions" << endl;
+}
+
 /* simulate_param_set simulates the given parameter set with every specified mutant
 	parameters:
 		sd: the current simulation's data
@@ -104,20 +140,25 @@ bool determine_set_passed (sim_data& sd, int set_num, double score) {
 		dirnames_cons: the array of mutant directory paths
 		file_features: a pointer to the output file stream of the features file
 		file_conditions: a pointer to the output file stream of the conditions file
+		file_features_db: a pointer to the output file stream of the features database
 	returns: the cumulative score of every mutant
 	notes:
 	todo:
 */
-double simulate_param_set (int set_num, input_params& ip, sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant_data mds[], ofstream* file_passed, ofstream* file_scores, char** dirnames_cons, ofstream* file_features, ofstream* file_conditions) {
+double simulate_param_set (int set_num, input_params& ip, sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant_data mds[], output_file* file_passed, output_file* file_scores, char** dirnames_cons, output_file* file_features, output_file* file_conditions, output_file* file_features_db) {
 	// Prepare for the simulations
 	cout << term->blue << "Simulating set " << term->reset << set_num << " . . ." << endl;
+	mark_memory_window(MEM_WINDOW_SET); // Start the set's memory peaks over
 	int num_passed = 0;
-	double scores[NUM_SECTIONS * NUM_MUTANTS] = {0};
+	double scores[NUM_SECTIONS * MAX_MUTANTS] = {0};
 	if (!ip.reset_seed) { // Reset the seed for each set if specified by the user
 		init_seeds(ip, set_num, set_num > 0, true);
 	}
-	cl.reset(); // Reset the concentration levels for each set
-	(*mds).feat.reset();
+	size_con_levels(ip, sd, rs, cl, baby_cl, mds); // Size (and reset) the concentration levels for this set's delays
+	sd.set_scratch.reset(); // Take back everything the previous set borrowed
+	for (int i = 0; i < ip.num_active_mutants; i++) { // Clear every mutant's features, including the time series its analysis adds to
+		mds[i].feat.reset();
+	}
 	
 	// Simulate every mutant in the posterior before moving on to the anterior
 	int end_section = SEC_ANT * !(sd.no_growth);
@@ -126,6 +167,75 @@ double simulate_param_set (int set_num, input_params& ip, sim_data& sd, rates& r
 		num_passed += simulate_section(set_num, ip, sd, rs, cl, baby_cl, mds, dirnames_cons, scores);
 	}
 	
+	set_memory_tag(MEM_OUTPUT);
+	double total_score = print_set_results(set_num, ip, sd, rs, mds, scores, num_passed, file_passed, file_scores, file_features, file_conditions);
+	print_features_db(ip, file_features_db, rs, mds, set_num);
+	set_memory_tag(MEM_OTHER);
+	profile_set(set_num);
+	
+	return total_score;
+}
+
+/* rescore_param_set reruns every mutant's tests on the records read from the features database for the given parameter set
+	parameters:
+		set_num: the index of the parameter set to rescore
+		ip: the program's input parameters
+		sd: the current simulation's data
+		rs: the current simulation's rates, holding the set's rates
+		mds: the array of all mutant data, holding the set's records
+		file_passed: a pointer to the output file stream of the passed file
+		file_scores: a pointer to the output file stream of the scores file
+		file_features: a pointer to the output file stream of the features file
+		file_conditions: a pointer to the output file stream of the conditions file
+	returns: the cumulative score of every mutant
+	notes:
+		The mutants are scored in the order simulate_section scores them when not short circuiting, so the wild type's record from each section is loaded before the other mutants are tested against it. Mutants without a record in a section score 0 for it, as they do when short circuiting skips them.
+	todo:
+*/
+double rescore_param_set (int set_num, input_params& ip, sim_data& sd, rates& rs, mutant_data mds[], output_file* file_passed, output_file* file_scores, output_file* file_features, output_file* file_conditions) {
+	cout << term->blue << "Rescoring set " << term->reset << set_num << " . . ." << endl;
+	int num_passed = 0;
+	double scores[NUM_SECTIONS * MAX_MUTANTS] = {0};
+	int end_section = SEC_ANT * !(sd.no_growth);
+	for (int j = SEC_POST; j <= end_section; j++) {
+		sd.section = j;
+		reset_mutant_scores(ip, mds);
+		for (int i = 0; i < ip.num_active_mutants; i++) {
+			scoring_record& rec = mds[i].records[j];
+			if (!rec.simulated) {
+				continue;
+			}
+			mds[i].feat = rec.feat;
+			memcpy(mds[i].conds_passed, rec.conds_passed, sizeof(rec.conds_passed));
+			if (rec.completed) {
+				mds[i].secs_passed[j] = true;
+				scores[j * ip.num_active_mutants + i] = score_mutant(sd, mds[i], mds[MUTANT_WILDTYPE].feat, rec.snapshots, rec.num_snapshots);
+			}
+			num_passed += scores[j * ip.num_active_mutants + i] == mds[i].max_cond_scores[j];
+		}
+	}
+	
+	return print_set_results(set_num, ip, sd, rs, mds, scores, num_passed, file_passed, file_scores, file_features, file_conditions);
+}
+
+/* print_set_results totals the given set's scores and prints its results to every output file the user specified
+	parameters:
+		set_num: the index of the parameter set
+		ip: the program's input parameters
+		sd: the current simulation's data
+		rs: the current simulation's rates
+		mds: the array of all mutant data
+		scores: the score of each mutant in each section
+		num_passed: the number of mutant runs that passed
+		file_passed: a pointer to the output file stream of the passed file
+		file_scores: a pointer to the output file stream of the scores file
+		file_features: a pointer to the output file stream of the features file
+		file_conditions: a pointer to the output file stream of the conditions file
+	returns: the cumulative score of every mutant
+	notes:
+	todo:
+*/
+double print_set_results (int set_num, input_params& ip, sim_data& sd, rates& rs, mutant_data mds[], double scores[], int num_passed, output_file* file_passed, output_file* file_scores, output_file* file_features, output_file* file_conditions) {
 	// Calculate the total score
 	double total_score = 0;
 	for (int i = 0; i < NUM_SECTIONS * ip.num_active_mutants; i++) {
@@ -140,9 +250,40 @@ double simulate_param_set (int set_num, input_params& ip, sim_data& sd, rates& r
 	print_conditions(ip, file_conditions, mds, set_num);
 	print_scores(ip, file_scores, set_num, scores, total_score);
 	
+	// Give the set's results to the background writer, if there is one
+	hand_off_output(file_passed);
+	hand_off_output(file_features);
+	hand_off_output(file_conditions);
+	hand_off_output(file_scores);
+	
 	return total_score;
 }
 
+/* size_con_levels sizes every concentration levels struct for the current parameter set's maximum delay
+	parameters:
+		ip: the program's input parameters
+		sd: the current simulation's data
+		rs: the current simulation's rates
+		cl: the concentration levels used for analysis and storage
+		baby_cl: the concentration levels used for simulating
+		mds: the array of all mutant data
+	returns: nothing
+	notes:
+		The structs keep their memory when it is big enough, so after a set with long delays the following sets only reset the part they use.
+	todo:
+*/
+void size_con_levels (input_params& ip, sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant_data mds[]) {
+	calc_max_delay_size(sd, rs, rs.rates_base);
+	int max_cl_size = MAX(sd.steps_til_growth, sd.max_delay_size + sd.steps_total - sd.steps_til_growth) / sd.big_gran + 1;
+	memory_scope scope(MEM_CON_LEVELS);
+	cl.initialize(NUM_CON_STORE, max_cl_size, sd.cells_total, sd.active_start);
+	baby_cl.initialize(NUM_CON_LEVELS, sd.max_delay_size, sd.cells_total, sd.active_start);
+	set_memory_tag(MEM_SNAPSHOTS);
+	for (int i = 0; i < ip.num_active_mutants; i++) {
+		mds[i].snapshot.initialize(sd.max_delay_size, sd.cells_total);
+	}
+}
+
 /* simulate_section simulates the given section with every specified mutant
 	parameters:
 		set_num: the index of the parameter set to simulate
@@ -164,18 +305,25 @@ int simulate_section (int set_num, input_params& ip, sim_data& sd, rates& rs, co
 	double temp_rates[2]; // Array of knockout rates so knockouts can be quickly applied and reverted
 	determine_start_end(sd);
 	reset_mutant_scores(ip, mds);
+	int order[ip.num_active_mutants]; // The indices of the mutants in the order to simulate them
+	order_mutants(ip, sd, mds, order);
+	plan_forks(sd, mds);
 	
 	// Simulate each mutant
-	for (int i = 0; i < ip.num_active_mutants; i++) {
+	for (int k = 0; k < ip.num_active_mutants; k++) {
+		int i = order[k];
 		mutant_sim_message(mds[i], i);
 		store_original_rates(rs, mds[i], temp_rates); // will be used to revert original rates after current mutant
 		knockout (rs, mds[i], 0);
 		double current_score = simulate_mutant(set_num, ip, sd, rs, cl, baby_cl, mds[i], mds[MUTANT_WILDTYPE].feat, dirnames_cons[i], temp_rates);
+		profile_mutant(mds[i], sd.section);
 		scores[sd.section * ip.num_active_mutants + i] = current_score;
 		baby_cl.reset();
 		revert_knockout(rs, mds[i], temp_rates); // this should still happen at the end
 		
-		if (current_score == mds[i].max_cond_scores[sd.section]) { // If the mutant passed, increment the passed counter
+		bool passed = current_score == mds[i].max_cond_scores[sd.section];
+		record_mutant_run(sd, mds[i], passed);
+		if (passed) { // If the mutant passed, increment the passed counter
 			++num_passed;
 		} else if (ip.short_circuit) { // Exit both loops if the mutant failed and short circuiting is active
 			return num_passed;
@@ -185,6 +333,200 @@ int simulate_section (int set_num, input_params& ip, sim_data& sd, rates& rs, co
 	return num_passed;
 }
 
+/* order_mutants decides in which order to simulate the mutants in the current section
+	parameters:
+		ip: the program's input parameters
+		sd: the current simulation's data
+		mds: the array of all mutant data
+		order: the array to store the mutants' indices in, in the order to simulate them
+	returns: nothing
+	notes:
+		Without short circuiting every mutant is simulated, so the mutants keep their fixed order.
+		With short circuiting the wild type still goes first since every other mutant is tested against its features. The rest are sorted by their expected cost per failure, the mean number of time steps their runs in this section simulated divided by the fraction of those runs that failed, so the mutants most likely to end the set for the least work go first.
+		The failure fraction is smoothed to (failures + 1) / (runs + 2) and mutants without runs cost the whole section, so untried mutants count as failing half the time. Ties keep the fixed order, so the order only depends on the recorded runs.
+	todo:
+*/
+void order_mutants (input_params& ip, sim_data& sd, mutant_data mds[], int order[]) {
+	double cost[ip.num_active_mutants]; // The expected cost per failure of each mutant
+	for (int i = 0; i < ip.num_active_mutants; i++) {
+		order[i] = i;
+		int runs = mds[i].runs[sd.section];
+		double steps = runs > 0 ? mds[i].steps_run[sd.section] / runs : sd.time_end - sd.time_start;
+		cost[i] = steps * (runs + 2) / (mds[i].failures[sd.section] + 1);
+	}
+	if (!ip.short_circuit) {
+		return;
+	}
+	
+	// Insertion sort every mutant but the wild type (there are only a handful of mutants)
+	for (int k = MUTANT_WILDTYPE + 2; k < ip.num_active_mutants; k++) {
+		int i = order[k];
+		int l = k;
+		for (; l > MUTANT_WILDTYPE + 1 && (cost[order[l - 1]] > cost[i] || (cost[order[l - 1]] == cost[i] && order[l - 1] > i)); l--) {
+			order[l] = order[l - 1];
+		}
+		order[l] = i;
+	}
+}
+
+/* record_mutant_run adds the run that just finished to the given mutant's failure rate and cost in the current section
+	parameters:
+		sd: the current simulation's data
+		md: the mutant that was simulated
+		passed: whether or not the mutant passed the section's conditions
+	returns: nothing
+	notes:
+	todo:
+*/
+void record_mutant_run (sim_data& sd, mutant_data& md, bool passed) {
+	md.runs[sd.section]++;
+	md.failures[sd.section] += !passed;
+	md.steps_run[sd.section] += sd.steps_simulated;
+}
+
+/* plan_forks decides at which time steps to keep the wild type's state so induced mutants can resume from it in the current section
+	parameters:
+		sd: the current simulation's data
+		mds: the array of all mutant data
+	returns: nothing
+	notes:
+		Mutants inducing at the same time step share a fork. The forks are sized (and reset) here so taking one during the wild type's simulation only copies.
+	todo:
+*/
+void plan_forks (sim_data& sd, mutant_data mds[]) {
+	induction_forks& forks = sd.forks;
+	forks.num_forks = 0;
+	forks.num_taken = 0;
+	forks.rows_copied = 0;
+	if (!sd.fork_inductions || sd.section != SEC_POST) {
+		return;
+	}
+	
+	// Insert each distinct fork time in increasing order (there are only a handful of mutants)
+	for (int i = 0; i < sd.num_active_mutants; i++) {
+		int time = fork_time(sd, mds[i]);
+		if (time == 0) {
+			continue;
+		}
+		int f = 0;
+		for (; f < forks.num_forks && forks.times[f] < time; f++) {}
+		if (f < forks.num_forks && forks.times[f] == time) {
+			continue;
+		}
+		for (int g = forks.num_forks; g > f; g--) {
+			forks.times[g] = forks.times[g - 1];
+		}
+		forks.times[f] = time;
+		forks.num_forks++;
+	}
+	
+	memory_scope scope(MEM_SNAPSHOTS);
+	for (int f = 0; f < forks.num_forks; f++) {
+		forks.baby_cls[f].initialize(NUM_CON_LEVELS, sd.max_delay_size, sd.cells_total, sd.active_start);
+	}
+	if (forks.num_forks > 0) {
+		forks.cl.initialize(NUM_CON_STORE, (forks.times[forks.num_forks - 1] - 1) / sd.big_gran + 1, sd.cells_total, sd.active_start);
+	}
+}
+
+/* fork_time calculates the time step at which the given mutant can resume from the wild type's state in the current section
+	parameters:
+		sd: the current simulation's data
+		md: the mutant to fork
+	returns: the first time step the mutant simulates differently from the wild type, or 0 if the mutant cannot be forked
+	notes:
+		Mutants with knockouts applied before their induction differ from the wild type from the start. A mutant never induced in this section matches the wild type until the end, so it forks at the last time step.
+		With a limit cycle tolerance the wild type and the mutant must start monitoring at the fork or later, otherwise the peaks the fork skips would change when the mutant stops early.
+	todo:
+*/
+int fork_time (sim_data& sd, mutant_data& md) {
+	if (md.index == MUTANT_WILDTYPE || (md.num_knockouts > 0 && !md.induced_knockouts)) {
+		return 0;
+	}
+	int time = MIN(MAX(sd.time_start, anterior_time(sd, md.induction) + 1), sd.time_end - 1); // model induces at the first time step past anterior_time
+	if (time <= sd.time_start || (sd.limit_cycle_tol > 0 && monitor_start(sd, md) < time)) {
+		return 0;
+	}
+	return time;
+}
+
+/* take_fork keeps the wild type's state before the given time step, which is the next fork's time
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		baby_cl: the concentration levels used for simulating
+		time: the time step about to be simulated
+	returns: nothing
+	notes:
+		Only the analysis time steps written since the previous fork are copied.
+	todo:
+*/
+void take_fork (sim_data& sd, con_levels& cl, con_levels& baby_cl, int time) {
+	induction_forks& forks = sd.forks;
+	copy_time_steps(baby_cl, forks.baby_cls[forks.num_taken], 0, sd.max_delay_size);
+	int rows = (time - 1) / sd.big_gran + 1;
+	copy_time_steps(cl, forks.cl, forks.rows_copied, rows);
+	forks.rows_copied = rows;
+	forks.num_taken++;
+}
+
+/* find_fork finds the fork the given mutant can resume from in the current section
+	parameters:
+		sd: the current simulation's data
+		md: the mutant about to be simulated
+	returns: the index of the fork, or -1 if the mutant has to be simulated from the start
+	notes:
+	todo:
+*/
+int find_fork (sim_data& sd, mutant_data& md) {
+	int time = fork_time(sd, md);
+	for (int f = 0; time != 0 && f < sd.forks.num_taken; f++) {
+		if (sd.forks.times[f] == time) {
+			return f;
+		}
+	}
+	return -1;
+}
+
+/* resume_fork copies the wild type's state kept by the given fork so a mutant can continue from it
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		baby_cl: the concentration levels used for simulating
+		fork: the index of the fork
+	returns: the time step to continue simulating at
+	notes:
+	todo:
+*/
+int resume_fork (sim_data& sd, con_levels& cl, con_levels& baby_cl, int fork) {
+	induction_forks& forks = sd.forks;
+	copy_time_steps(forks.baby_cls[fork], baby_cl, 0, sd.max_delay_size);
+	copy_time_steps(forks.cl, cl, 0, (forks.times[fork] - 1) / sd.big_gran + 1);
+	return forks.times[fork];
+}
+
+/* copy_time_steps copies the given range of time steps from one concentration levels struct to another
+	parameters:
+		from: the concentration levels to copy from
+		to: the concentration levels to copy to (with the same number of concentration levels and cells)
+		first: the first time step to copy
+		end: the time step after the last one to copy
+	returns: nothing
+	notes:
+	todo:
+*/
+void copy_time_steps (con_levels& from, con_levels& to, int first, int end) {
+	for (int i = 0; i < to.num_con_levels; i++) {
+		for (int j = first; j < end; j++) {
+			memcpy(to.cons[i][j], from.cons[i][j], sizeof(double) * to.cells);
+		}
+	}
+	for (int j = first; j < end; j++) {
+		to.active_start_record[j] = from.active_start_record[j];
+		to.active_end_record[j] = from.active_end_record[j];
+	}
+}
+
 /* determine_start_end determines the start and end points for the current simulation based on the current section
 	parameters:
 		sd: the current simulation's data
@@ -270,13 +612,13 @@ inline void store_original_rates (rates& rs, mutant_data& md, double orig_rates[
 	notes:
 	todo:
 
-	151221: For DAPT Mutant, knockout after induction
+	151221: For DAPT Mutant, knockout after induction (now any mutant with induced_knockouts)
 */
 inline void knockout (rates& rs, mutant_data& md, bool induction) {
 	for (int i = 0; i < md.num_knockouts; i++) {
-		if (!(md.index==MUTANT_DAPT && induction == 0)){               
+		if (induction || !md.induced_knockouts) {
 			rs.rates_base[md.knockouts[i]] = 0;
-		} 
+		}
 	}
 }
 
@@ -329,10 +671,23 @@ double simulate_mutant (int set_num, input_params& ip, sim_data& sd, rates& rs,
 		copy_mutant_to_cl(sd, baby_cl, md);
 	}
 	
+	// Resume from the wild type's state at the mutant's induction if it was kept
+	int time_first = sd.time_start;
+	int fork = find_fork(sd, md);
+	if (fork != -1) {
+		time_first = resume_fork(sd, cl, baby_cl, fork);
+		term->verbose() << term->blue << "    Forked " << term->reset << "from the wild type at time step " << time_first << endl;
+	}
+	
 	// Simulate the mutant
-	bool passed = model(sd, rs, cl, baby_cl, md, temp_rates);
+	profile_start(PHASE_MODEL);
+	bool passed = model(sd, rs, cl, baby_cl, md, temp_rates, time_first);
+	profile_end(PHASE_MODEL);
 	
 	// Analyze the simulation's oscillation features
+	profile_start(PHASE_FEATURES);
+	set_memory_tag(MEM_FEATURES);
+	reset_scratch(sd); // Take back the previous mutant's analysis buffers, keeping their memory
 	term->verbose() << term->blue << "    Analyzing " << term->reset << "oscillation features . . . ";
 	double score = 0;
 	if (sd.section == SEC_POST) { // Posterior analysis
@@ -350,33 +705,43 @@ double simulate_mutant (int set_num, input_params& ip, sim_data& sd, rates& rs,
 		}
 	}
 	
+	profile_end(PHASE_FEATURES);
+	
 	// Copy and print the appropriate data
+	profile_start(PHASE_PRINT);
+	set_memory_tag(MEM_OUTPUT);
 	print_concentrations(ip, sd, cl, md, dirname_cons, set_num);
 	if (sd.section == SEC_ANT) { // Print concentrations of columns of cells from posterior to anterior to a file if the user specified it
 		print_cell_columns(ip, sd, cl, dirname_cons, set_num);
 	}
+	set_memory_tag(MEM_OTHER);
+	profile_end(PHASE_PRINT);
 	if (!sd.no_growth && sd.section == SEC_POST && !ip.short_circuit) { // Copy the concentration levels to the mutant data (if not short circuiting)
 		copy_cl_to_mutant(sd, baby_cl, md);
 	}
 	
+	// Measure the traveling waves and keep what the tests read for the features database (if the user specified it)
+	wave_snapshot snapshots[MAX_WAVE_SNAPSHOTS];
+	int num_snapshots = 0;
+	if (passed && sd.section == SEC_ANT && md.index == MUTANT_WILDTYPE && (sd.score_sections[SEC_WAVE] || ip.print_features_db)) {
+		profile_start(PHASE_TESTS);
+		num_snapshots = measure_wave_snapshots(sd, cl, snapshots);
+		profile_end(PHASE_TESTS);
+	}
+	if (ip.print_features_db) {
+		keep_scoring_record(sd, md, passed, snapshots, num_snapshots);
+	}
+	
 	// Print how the mutant performed and finish book-keeping
 	term->verbose() << "  " << term->blue << "Done: " << term->reset << md.print_name << " scored ";
 	if (passed) {
 		md.secs_passed[sd.section] = true; // Mark that this mutant has passed this simulation
-		score += md.tests[sd.section](md, wtfeat);
+		profile_start(PHASE_TESTS);
+		score = score_mutant(sd, md, wtfeat, snapshots, num_snapshots);
+		profile_end(PHASE_TESTS);
 		double max_score = md.max_cond_scores[sd.section];
-		if (sd.section == SEC_ANT && (md.index == MUTANT_WILDTYPE)) { // The max score has to be adjusted for mutants which have a wave section
+		if (scores_waves(sd, md)) { // The max score has to be adjusted for mutants which have a wave section
 			max_score += md.max_cond_scores[SEC_WAVE];
-			int time_full = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial - 1) * sd.steps_split);
-			int wave_score=0;
-			for (int time = time_full; time < sd.time_end; time += (sd.time_end - 1 - time_full) / 4) {
-				if (md.index == MUTANT_WILDTYPE){
-					wave_score = wave_testing(sd, cl, md, time, CMH1, sd.active_start);
-				} else {
-					wave_score = wave_testing_her1(sd, cl, md, time, sd.active_start);  // unused 151221
-				}
-			}
-			score += wave_score;
 		}
 		if (score == max_score) {
 			// Copy the concentration levels to the mutant data if this is a posterior simulation (if short circuiting)
@@ -395,6 +760,90 @@ double simulate_mutant (int set_num, input_params& ip, sim_data& sd, rates& rs,
 	return score;
 }
 
+/* score_mutant runs the given mutant's tests for the current section
+	parameters:
+		sd: the current simulation's data
+		md: the mutant to score
+		wtfeat: the oscillation features the wild type produced
+		snapshots: the traveling waves measured at each time step the wave tests check
+		num_snapshots: the number of traveling wave snapshots
+	returns: the score of the mutant
+	notes:
+		The tests read nothing but the mutant's features and conditions, the wild type's features, and the wave snapshots, so rescoring a features database calls this with what the database kept.
+		Only the last snapshot's wave score counts, but every snapshot narrows the wave conditions.
+	todo:
+*/
+double score_mutant (sim_data& sd, mutant_data& md, features& wtfeat, wave_snapshot snapshots[], int num_snapshots) {
+	double score = 0;
+	if (sd.score_sections[sd.section]) {
+		score += md.tests[sd.section](md, wtfeat);
+	}
+	if (scores_waves(sd, md)) {
+		int wave_score = 0;
+		for (int i = 0; i < num_snapshots; i++) {
+			wave_score = test_waves(md, snapshots[i]);
+		}
+		score += wave_score;
+	}
+	return score;
+}
+
+/* scores_waves returns whether or not the given mutant's traveling waves are scored in the current section
+	parameters:
+		sd: the current simulation's data
+		md: the mutant being scored
+	returns: true if the wave tests run, false otherwise
+	notes:
+		Only the wild type has wave conditions, which are tested with its anterior conditions.
+	todo:
+*/
+inline bool scores_waves (sim_data& sd, mutant_data& md) {
+	return sd.section == SEC_ANT && md.index == MUTANT_WILDTYPE && sd.score_sections[SEC_WAVE];
+}
+
+/* measure_wave_snapshots measures the her1 mRNA traveling waves at evenly spaced time steps after the PSM fills with cells
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		snapshots: the array to store the waves at each time step in
+	returns: the number of snapshots measured
+	notes:
+		The time steps are a quarter of the remaining simulation apart, which makes 5 snapshots unless the anterior simulation is only a few time steps long. At most MAX_WAVE_SNAPSHOTS are measured.
+	todo:
+*/
+int measure_wave_snapshots (sim_data& sd, con_levels& cl, wave_snapshot snapshots[]) {
+	int time_full = anterior_time(sd, sd.steps_til_growth + (sd.width_total - sd.width_initial - 1) * sd.steps_split);
+	int num_snapshots = 0;
+	for (int time = time_full; time < sd.time_end && num_snapshots < MAX_WAVE_SNAPSHOTS; time += (sd.time_end - 1 - time_full) / 4) {
+		measure_waves(sd, cl, time, CMH1, sd.active_start, snapshots[num_snapshots++]);
+	}
+	return num_snapshots;
+}
+
+/* keep_scoring_record keeps what the given mutant's tests read in the current section so the features database can store it
+	parameters:
+		sd: the current simulation's data
+		md: the mutant that was simulated
+		completed: whether or not the simulation completed
+		snapshots: the traveling waves measured for the wave tests
+		num_snapshots: the number of traveling wave snapshots
+	returns: nothing
+	notes:
+		This must be called before the tests run since the record holds the conditions as the analysis left them.
+	todo:
+*/
+void keep_scoring_record (sim_data& sd, mutant_data& md, bool completed, wave_snapshot snapshots[], int num_snapshots) {
+	scoring_record& rec = md.records[sd.section];
+	rec.simulated = true;
+	rec.completed = completed;
+	rec.feat = md.feat;
+	memcpy(rec.conds_passed, md.conds_passed, sizeof(md.conds_passed));
+	rec.num_snapshots = num_snapshots;
+	for (int i = 0; i < num_snapshots; i++) {
+		rec.snapshots[i] = snapshots[i];
+	}
+}
+
 /* model performs the biological functions of a simulation
 	parameters:
 		sd: the current simulation's data
@@ -402,11 +851,12 @@ double simulate_mutant (int set_num, input_params& ip, sim_data& sd, rates& rs,
 		cl: the concentration levels used for analysis and storage
 		baby_cl: the concentration levels used for simulating
 		md: the mutant to simulate
+		time_first: the time step to start simulating at (later than the start time if the mutant resumed from a fork)
 	returns: the score of the mutant
 	notes:
 	todo:
 */
-bool model (sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant_data& md, double temp_rates[2]) {
+bool model (sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant_data& md, double temp_rates[2], int time_first) {
 	int steps_elapsed = sd.steps_split; // Used to determine when to split a column of cells
 	update_rates(rs, sd.active_start); // Update the active rates based on the base rates, perturbations, and gradients
 	
@@ -415,7 +865,16 @@ bool model (sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant
 	int baby_j; // Cyclical time used by baby_cl
 	bool past_induction = false; // Whether we've passed the point of induction of knockouts or overexpression
 	bool past_recovery = false; // Whether we've recovered from the knockouts or overexpression
-	for (j = sd.time_start, baby_j = 0; j < sd.time_end; j++, baby_j = WRAP(baby_j + 1, sd.max_delay_size)) {
+	cycle_monitor* monitor = NULL; // Detects a stable limit cycle so posterior simulations can stop early
+	if (sd.section == SEC_POST && sd.limit_cycle_tol > 0) {
+		monitor = new (sd.set_scratch.borrow(sizeof(cycle_monitor))) cycle_monitor(sd, sd.limit_cycle_tol, monitor_start(sd, md));
+	}
+	int time_stop = sd.time_end - 1; // The last time step to simulate, moved up once a stable limit cycle is found
+	for (j = time_first, baby_j = (time_first - sd.time_start) % sd.max_delay_size; j < sd.time_end; j++, baby_j = WRAP(baby_j + 1, sd.max_delay_size)) {
+		// Keep the wild type's state where induced mutants will fork from it
+		if (md.index == MUTANT_WILDTYPE && sd.forks.num_taken < sd.forks.num_forks && j == sd.forks.times[sd.forks.num_taken]) {
+			take_fork(sd, cl, baby_cl, j);
+		}
 		
 		if (!past_induction && !past_recovery && (j  > anterior_time(sd,md.induction))) {
 			knockout(rs, md, 1); //knock down rates after the induction point
@@ -448,9 +907,17 @@ bool model (sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant
 		
 		// Check to make sure the numbers are still valid
 		if (any_less_than_0(baby_cl, baby_j) || concentrations_too_high(baby_cl, baby_j, sd.max_con_thresh)) {
+			sd.steps_simulated = j - time_first + 1;
+			PROFILE_COUNT(COUNT_TIME_STEPS, j - time_first + 1);
 			return false;
 		}
 		
+		// Look for a stable limit cycle and, once found, stop at the last time step in phase with the end of the simulation
+		if (monitor != NULL && monitor->period == 0 && j >= monitor->time_start && monitor_cycles(*monitor, baby_cl.cons[LIMIT_CYCLE_CON][baby_j], j)) {
+			refine_period(sd, cl, *monitor, j);
+			time_stop = sd.time_end - 1 - ((sd.time_end - 1 - j) / monitor->period) * monitor->period;
+		}
+		
 		// Split cells periodically in anterior simulations
 		if (sd.section == SEC_ANT && (steps_elapsed % sd.steps_split) == 0) {
 			split(sd, rs, baby_cl, baby_j, j);
@@ -467,15 +934,177 @@ bool model (sim_data& sd, rates& rs, con_levels& cl, con_levels& baby_cl, mutant
 		if (j % sd.big_gran == 0) {
 			baby_to_cl(baby_cl, cl, baby_j, j / sd.big_gran);
 		}
+		
+		// Stop early if the rest of the simulation only repeats the limit cycle
+		if (j == time_stop) {
+			j++;
+			baby_j = WRAP(baby_j + 1, sd.max_delay_size);
+			break;
+		}
 	}
 	
 	// Copy the last time step from the simulating cl to the analysis cl and mark where the simulating cl left off time-wise
 	baby_to_cl(baby_cl, cl, WRAP(baby_j - 1, sd.max_delay_size), (j - 1) / sd.big_gran);
 	sd.time_baby = baby_j;
+	sd.steps_simulated = j - time_first;
+	PROFILE_COUNT(COUNT_TIME_STEPS, j - time_first);
+	
+	// Fill in the skipped time steps with the limit cycle
+	if (monitor != NULL) {
+		if (j < sd.time_end) {
+			term->verbose() << term->blue << "    Stopped " << term->reset << "at a stable limit cycle after " << (j - sd.time_start) << " of " << (sd.time_end - sd.time_start) << " time steps" << endl;
+			synthesize_cycles(sd, cl, *monitor, j);
+		}
+	}
+	
+	return true;
+}
+
+/* monitor_start calculates the first time step at which the given mutant's rates stop changing for the rest of the simulation
+	parameters:
+		sd: the current simulation's data
+		md: the mutant being simulated
+	returns: the time step after the mutant's last induction or recovery in the current simulation, or the start time if neither happens
+	notes:
+		A limit cycle found before an induction or recovery does not describe the rest of the simulation, so peaks before this point are ignored.
+	todo:
+*/
+int monitor_start (sim_data& sd, mutant_data& md) {
+	int start = sd.time_start;
+	int induction = anterior_time(sd, md.induction) + 1; // model induces at the first time step past this
+	if (induction < sd.time_end) {
+		start = MAX(start, induction);
+		int recovery = md.recovery - sd.steps_til_growth + 1;
+		if (recovery < sd.time_end) {
+			start = MAX(start, recovery);
+		}
+	}
+	return start;
+}
+
+/* monitor_cycles records the peaks of the monitored concentration at the given time step and checks whether every monitored cell has reached the same stable limit cycle
+	parameters:
+		cm: the cycle monitor
+		cons: the monitored concentration of every cell at the given time step
+		time: the absolute time step
+	returns: true if a stable limit cycle was found (its period is stored in the monitor), false otherwise
+	notes:
+		A peak is registered one time step late, once the concentration starts to fall.
+	todo:
+*/
+bool monitor_cycles (cycle_monitor& cm, double* cons, int time) {
+	bool new_peak = false;
+	for (int i = 0; i < cm.num_cells; i++) {
+		double cur = cons[cm.cells[i]];
+		if (cm.prev[i] > cm.prev2[i] && cm.prev[i] >= cur && time - 1 > cm.time_start) {
+			int peak_time = time - 1;
+			double height = cm.prev[i];
+			if (cm.last_peak[i] >= 0) {
+				int period = peak_time - cm.last_peak[i];
+				if (cm.last_period[i] > 0 && ABS(period - cm.last_period[i]) <= cm.tolerance * cm.last_period[i] && ABS(height - cm.last_height[i]) <= cm.tolerance * cm.last_height[i]) {
+					cm.stable_cycles[i]++;
+				} else {
+					cm.stable_cycles[i] = 0;
+				}
+				cm.last_period[i] = period;
+			}
+			cm.last_peak[i] = peak_time;
+			cm.last_height[i] = height;
+			new_peak = true;
+		}
+		cm.prev2[i] = cm.prev[i];
+		cm.prev[i] = cur;
+	}
 	
+	// Every cell must be stable with (nearly) the same period for the tissue to repeat as a whole
+	if (!new_peak || cm.num_cells == 0) {
+		return false;
+	}
+	for (int i = 0; i < cm.num_cells; i++) {
+		if (cm.stable_cycles[i] < LIMIT_CYCLE_CYCLES || ABS(cm.last_period[i] - cm.last_period[0]) > cm.tolerance * cm.last_period[0]) {
+			return false;
+		}
+	}
+	cm.period = cm.last_period[0];
 	return true;
 }
 
+/* refine_period replaces the period of a stable limit cycle found from peak times with the shift that best maps the last cycle onto the one before it
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		cm: the cycle monitor that found the limit cycle
+		time: the current absolute time step (which has not been copied to cl yet)
+	returns: nothing
+	notes:
+		Peak times only resolve the period to within the tolerance. Using the least squares shift over a whole cycle keeps the skipped time steps in phase and the copied cycles joined smoothly.
+	todo:
+*/
+void refine_period (sim_data& sd, con_levels& cl, cycle_monitor& cm, int time) {
+	int end = (time - 1) / sd.big_gran; // The last time stored in cl
+	int length = cm.period / sd.big_gran; // The number of stored time steps in a cycle
+	int width = MAX(2, (int)(cm.tolerance * length) + 1);
+	int start = sd.time_start / sd.big_gran + 1;
+	double** cons = cl.cons[LIMIT_CYCLE_CON];
+	double min_error = INFINITY;
+	int best = length;
+	for (int p = MAX(1, length - width); p <= length + width && end - length - p >= start; p++) {
+		double error = 0;
+		for (int j = end - length + 1; j <= end; j++) {
+			for (int i = 0; i < cm.num_cells; i++) {
+				error += SQUARE(cons[j][cm.cells[i]] - cons[j - p][cm.cells[i]]);
+			}
+		}
+		if (error < min_error) {
+			min_error = error;
+			best = p;
+		}
+	}
+	cm.period = best * sd.big_gran;
+}
+
+/* synthesize_cycles fills in the analysis concentration levels after an early stop by repeating the limit cycle
+	parameters:
+		sd: the current simulation's data
+		cl: the concentration levels used for analysis and storage
+		cm: the cycle monitor that found the limit cycle
+		time_stop: the first time step that was not simulated
+	returns: nothing
+	notes:
+		model stops at a time step in phase with the end of the simulation, so baby_cl already holds the delay history the end of the simulation would have had. Only the analysis levels need filling in.
+		The copied cycles start where the monitored concentration changes fastest in the last simulated cycle so any small mismatch at the join cannot create a false peak or trough.
+	todo:
+*/
+void synthesize_cycles (sim_data& sd, con_levels& cl, cycle_monitor& cm, int time_stop) {
+	int last = (time_stop - 1) / sd.big_gran; // The last simulated time stored in cl
+	int end = (sd.time_end - 1) / sd.big_gran; // The last time to fill in
+	int length = cm.period / sd.big_gran; // The number of stored time steps in a cycle
+	
+	// Find the steepest point of the last simulated cycle to join the copied cycles at
+	double** cons = cl.cons[LIMIT_CYCLE_CON];
+	int join = last + 1;
+	double max_change = 0;
+	for (int j = last - length + 1; j <= last; j++) {
+		double change = 0;
+		for (int i = 0; i < cm.num_cells; i++) {
+			change += ABS(cons[j][cm.cells[i]] - cons[j - 1][cm.cells[i]]);
+		}
+		if (change > max_change) {
+			max_change = change;
+			join = j;
+		}
+	}
+	
+	// Repeat the cycle from the join to the end of the simulation
+	for (int j = join; j <= end; j++) {
+		for (int i = 0; i < cl.num_con_levels; i++) {
+			memcpy(cl.cons[i][j], cl.cons[i][j - length], sizeof(double) * cl.cells);
+		}
+		cl.active_start_record[j] = cl.active_start_record[j - length];
+		cl.active_end_record[j] = cl.active_end_record[j - length];
+	}
+}
+
 /* calculate_delay_indices calculates where the given cell was at the start of all mRNA and protein delays
 	parameters:
 		sd: the current simulation's data
@@ -498,8 +1127,8 @@ void calculate_delay_indices (sim_data& sd, con_levels& cl, int baby_time, int t
 		}
 	} else { // Cells in anterior simulations split so with long enough delays the cell must look to its parent for values, causing its effective index to change over time
 		for (int l = 0; l < NUM_INDICES; l++) {
-			old_cells_mrna[IMH1 + l] = index_with_splits(sd, cl, baby_time, time, cell_index, active_rates[RDELAYMH1 + l][cell_index]);
-			old_cells_protein[IPH1 + l] = index_with_splits(sd, cl, baby_time, time, cell_index, active_rates[RDELAYPH1 + l][cell_index]);
+			old_cells_mrna[IMH1 + l] = index_with_splits(sd, cl, baby_time, time, cell_index, active_rates[RDELAYMH1 + l][cell_index], 0);
+			old_cells_protein[IPH1 + l] = index_with_splits(sd, cl, baby_time, time, cell_index, active_rates[RDELAYPH1 + l][cell_index], 0);
 		}
 	}
 }
@@ -512,16 +1141,18 @@ void calculate_delay_indices (sim_data& sd, con_levels& cl, int baby_time, int t
 		time: the absolute time used by cl, the cl for analysis
 		cell_index: the current cell index
 		delay: the amount of time (in minutes) the delay takes
+		depth: the number of parents already moved through (used for profiling)
 	returns: the index of the cell at the start of the delay
 	notes:
 	todo:
 */
-inline int index_with_splits (sim_data& sd, con_levels& cl, int baby_time, int time, int cell_index, double delay) {
+inline int index_with_splits (sim_data& sd, con_levels& cl, int baby_time, int time, int cell_index, double delay, int depth) {
 	int delay_steps = delay / sd.step_size;
 	if (time - delay_steps < 0 || time - delay_steps >= cl.cons[BIRTH][baby_time][cell_index]) { // If the delay is longer than the simulation has run or shorter than the cell's age then return the cell's index
+		PROFILE_MAX(COUNT_SPLIT_DEPTH, depth);
 		return cell_index;
 	} else { // If the delay is not longer than the simulation has run but longer than the cell's age then move to the cell's parent and check again
-		return index_with_splits(sd, cl, baby_time, time, cl.cons[PARENT][baby_time][cell_index], delay);
+		return index_with_splits(sd, cl, baby_time, time, cl.cons[PARENT][baby_time][cell_index], delay, depth + 1);
 	}
 }
 
@@ -615,6 +1246,7 @@ void split (sim_data& sd, rates& rs, con_levels& cl, int baby_time, int time) {
 	}
 	
 	// Perturb the new cells and update the active record data
+	PROFILE_COUNT(COUNT_SPLITS, 1);
 	perturb_rates_column(sd, rs, next_active_start);
 	sd.active_start = next_active_start;
 	sd.active_end = WRAP(sd.active_start - sd.width_current + 1, sd.width_total);
@@ -777,7 +1409,7 @@ inline void dim_int (di_args& a, di_indices dii) {
 	notes:
 	todo:
 */
-inline void con_protein_her (cp_args& a, cph_indices i) {
+void con_protein_her (cp_args& a, cph_indices i) {
 	double** r = a.rs;
 	double*** c = a.cl.cons;
 	int cell = a.stc.cell;
@@ -27,10 +27,22 @@ sim.hpp contains function declarations for sim.cpp.
 
 using namespace std;
 
-void simulate_all_params(input_params&, rates&, sim_data&, double**, mutant_data[], ofstream*, ofstream*, char**, ofstream*, ofstream*);
+void simulate_all_params(input_params&, rates&, sim_data&, double**, mutant_data[], output_file*, output_file*, char**, output_file*, output_file*, output_file*);
+void rescore_all_params(input_params&, rates&, sim_data&, mutant_data[], output_file*, output_file*, output_file*, output_file*);
 bool determine_set_passed(sim_data&, int, double);
-double simulate_param_set(int, input_params&, sim_data&, rates&, con_levels&, con_levels&, mutant_data[], ofstream*, ofstream*, char**, ofstream*, ofstream*);
+double simulate_param_set(int, input_params&, sim_data&, rates&, con_levels&, con_levels&, mutant_data[], output_file*, output_file*, char**, output_file*, output_file*, output_file*);
+double rescore_param_set(int, input_params&, sim_data&, rates&, mutant_data[], output_file*, output_file*, output_file*, output_file*);
+double print_set_results(int, input_params&, sim_data&, rates&, mutant_data[], double[], int, output_file*, output_file*, output_file*, output_file*);
+void size_con_levels(input_params&, sim_data&, rates&, con_levels&, con_levels&, mutant_data[]);
 int simulate_section(int, input_params&, sim_data&, rates&, con_levels&, con_levels&, mutant_data[], char**, double[]);
+void order_mutants(input_params&, sim_data&, mutant_data[], int[]);
+void record_mutant_run(sim_data&, mutant_data&, bool);
+void plan_forks(sim_data&, mutant_data[]);
+int fork_time(sim_data&, mutant_data&);
+void take_fork(sim_data&, con_levels&, con_levels&, int);
+int find_fork(sim_data&, mutant_data&);
+int resume_fork(sim_data&, con_levels&, con_levels&, int);
+void copy_time_steps(con_levels&, con_levels&, int, int);
 void determine_start_end(sim_data&);
 void reset_mutant_scores(input_params&, mutant_data[]);
 void mutant_sim_message(mutant_data&, int);
@@ -38,9 +50,17 @@ void store_original_rates (rates&, mutant_data&, double[]);
 void knockout(rates& rs, mutant_data&, bool induction);
 void revert_knockout(rates& rs, mutant_data&, double[]);
 double simulate_mutant(int, input_params&, sim_data&, rates&, con_levels&, con_levels&, mutant_data&, features&, char*, double[2]);
-bool model(sim_data&, rates&, con_levels&, con_levels&, mutant_data&, double[2]);
+double score_mutant(sim_data&, mutant_data&, features&, wave_snapshot[], int);
+bool scores_waves(sim_data&, mutant_data&);
+int measure_wave_snapshots(sim_data&, con_levels&, wave_snapshot[]);
+void keep_scoring_record(sim_data&, mutant_data&, bool, wave_snapshot[], int);
+bool model(sim_data&, rates&, con_levels&, con_levels&, mutant_data&, double[2], int);
+int monitor_start(sim_data&, mutant_data&);
+bool monitor_cycles(cycle_monitor&, double*, int);
+void refine_period(sim_data&, con_levels&, cycle_monitor&, int);
+void synthesize_cycles(sim_data&, con_levels&, cycle_monitor&, int);
 void calculate_delay_indices (sim_data&, con_levels&, int, int, int, double*[], int[], int[]);
-int index_with_splits(sim_data&, con_levels&, int, int, int, double);
+int index_with_splits(sim_data&, con_levels&, int, int, int, double, int);
 bool any_less_than_0(con_levels&, int);
 bool concentrations_too_high(con_levels&, int, double);
 void split(sim_data&, rates& rs, con_levels&, int, int);
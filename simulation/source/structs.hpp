@@ -26,10 +26,13 @@ structs.hpp contains every struct used in the program.
 #include <cmath> // Needed for INFINITY
 #include <cstdlib> // Needed for cmath
 #include <cstring> // Needed for strlen, memset, memcpy
+#include <cstdio> // Needed for FILE
 #include <iostream> // Needed for cout
 #include <bitset> // Needed for bitset
 #include <fstream> // Needed for ofstream
-#include <map> // Needed for map
+#include <sstream> // Needed for ostringstream
+#include <string> // Needed for string
+#include <pthread.h> // Needed for pthread_t, pthread_mutex_t, pthread_cond_t
 
 #include "macros.hpp"
 #include "memory.hpp"
@@ -129,11 +132,20 @@ struct input_params {
 	bool read_perturb; // Whether or not to read the perturbations file, default=false
 	char* gradients_file; // The path and name of the gradients file, default=none
 	bool read_gradients; // Whether or not to read the gradients file, default=false
+	char* mutants_file; // The path and name of the mutants file, default=none
+	bool read_mutants; // Whether or not to read the mutants file instead of using the coded-in mutants, default=false
 	char* passed_file; // The path and name of the passed file, default=output.passed
 	bool print_passed; // Whether or not to print the passed file, default=false
 	char* dir_path; // The path of the output directory for concentrations or oscillation features, default=none
 	bool print_cons; // Whether or not to print concentrations, default=false
 	bool binary_cons_output; // Whether or not to print the binary or ASCII value of numbers in the concentrations output files
+	bool npy_output; // Whether or not to print concentrations and cell columns as NumPy .npy arrays, default=false
+	int print_species[NUM_CON_STORE]; // The mRNAs to print concentrations of, each to its own file
+	int num_print_species; // The number of mRNAs in print_species, default=0 (each mutant prints its print_con to one file)
+	int print_window[2]; // The first and last minute to print concentrations of, default=0 and -1 (the end of the simulation)
+	int print_rows[2]; // The first and last row of cells to print concentrations of, default=0 and -1 (the last row)
+	int print_columns[2]; // The first and last column of cells, counted from the active start of the PSM, to print concentrations of, default=0 and -1 (the last column)
+	int print_every; // Print concentrations of only every this many stored time steps, default=1
 	char* features_file; // The path and file of the features file, default=none
 	bool ant_features; // Whether or not to print oscillation features in the anterior
 	bool post_features; // Whether or not to print oscillation features in the posterior
@@ -142,6 +154,12 @@ struct input_params {
 	bool print_conditions; // Whether or not to print which conditions passed, default=false
 	char* scores_file; // The path and file of the scores file, default=none
 	bool print_scores; // Whether or not to print the scores for every mutant, default=false
+	char* features_db_file; // The path and name of the features database to store what each mutant's tests read, default=none
+	bool print_features_db; // Whether or not to print the features database, default=false
+	int output_buffer; // The megabytes of output a background thread may have queued for writing, default=0 (the simulating thread writes every file itself)
+	char* pack_file; // The path and name of the pack file to store the concentrations and oscillation features files in instead of the output directory, default=none
+	char* rescore_file; // The path and name of the features database to rescore instead of simulating, default=none
+	bool rescore; // Whether or not to rescore a features database instead of simulating, default=false
 	int num_colls_print; // The number of columns of cells to print for plotting of single cells on top of each other
 	
 	// Sets
@@ -165,14 +183,28 @@ struct input_params {
 	double step_size; // The time step in minutes used for Euler's method, default=0.01
 	double max_con_thresh; // Maximum threshold for concentrations, default=INFINITY
 	bool short_circuit; // Whether or not to stop simulating a parameter set after a mutant fails
-	int num_active_mutants; // The number of mutants to simulate for each parameter set, default=num_mutants
+	char* mutant_stats_file; // The path and name of the file to load and save the mutants' failure rates and costs, default=none
+	bool mutant_stats; // Whether or not to load and save the mutants' failure rates and costs, default=false
+	int num_active_mutants; // The number of mutants to simulate for each parameter set, default=0 (every defined mutant) until the mutants are created
+	char* selected_mutants; // A comma-separated list of the directory names of the mutants to simulate, default=none (the first num_active_mutants)
+	bool score_sections[NUM_SECTIONS]; // Whether or not to score the posterior, anterior, and wave sections, default=all
 	int big_gran; // The granularity in time steps with which to store data, default=1
 	int small_gran; // The granularit in time steps with which to simulate data, default=1
-	int her1_induction; // The time point of the induction of her1 overexpression
-	int her7_induction; // The time point of the induction of her7 overexpression
-	int DAPT_induction; // The time point of the induction of NICD perturbation
-	int mespa_induction; // The time point of the induction of mespa overexpression
-	int mespb_induction; // The time point of the induction of mespb overexpression
+	int her1_induction; // The time point of the induction of her1 overexpression in minutes, default=600
+	int her7_induction; // The time point of the induction of her7 overexpression in minutes, default=600
+	int DAPT_induction; // The time point of the induction of NICD perturbation in minutes, default=600
+	int mespa_induction; // The time point of the induction of mespa overexpression in minutes, default=600
+	int mespb_induction; // The time point of the induction of mespb overexpression in minutes, default=600
+	double limit_cycle_tol; // The relative tolerance within which successive posterior periods and peak heights must agree to stop early, default=0 (never stop early)
+	int analysis_threads; // The number of threads to analyze oscillation features with, default=1
+	int feature_backend; // How posterior periods and amplitudes are estimated (FEATURE_BACKEND_CRIT or FEATURE_BACKEND_SPECTRAL), default=FEATURE_BACKEND_CRIT
+	bool fork_inductions; // Whether or not induced mutants resume posterior simulations from the wild type's state at their induction, default=false
+	int huge_pages; // How the concentration levels are backed by huge pages (HUGE_PAGES_NONE, HUGE_PAGES_THP, or HUGE_PAGES_EXPLICIT), default=HUGE_PAGES_NONE
+	bool pin_threads; // Whether or not to pin the simulating and analysis threads to their own CPUs, default=false
+	
+	// Profiling
+	char* profile_file; // The path and name of the profiling report file, default=none
+	bool profile; // Whether or not to time phases and count events, default=false
 	
 	// Piping data
 	bool piping; // Whether or not input and output should be piped (as opposed to written to disk), default=false
@@ -194,11 +226,22 @@ struct input_params {
 		this->read_perturb = false;
 		this->gradients_file = NULL;
 		this->read_gradients = false;
+		this->mutants_file = NULL;
+		this->read_mutants = false;
 		this->passed_file = NULL;
 		this->print_passed = false;
 		this->dir_path = NULL;
 		this->print_cons = false;
 		this->binary_cons_output = false;
+		this->npy_output = false;
+		this->num_print_species = 0;
+		this->print_window[0] = 0;
+		this->print_window[1] = -1;
+		this->print_rows[0] = 0;
+		this->print_rows[1] = -1;
+		this->print_columns[0] = 0;
+		this->print_columns[1] = -1;
+		this->print_every = 1;
 		this->features_file = NULL;
 		this->ant_features = false;
 		this->post_features = false;
@@ -207,10 +250,21 @@ struct input_params {
 		this->print_conditions = false;
 		this->scores_file = NULL;
 		this->print_scores = false;
+		this->features_db_file = NULL;
+		this->print_features_db = false;
+		this->output_buffer = 0;
+		this->pack_file = NULL;
+		this->rescore_file = NULL;
+		this->rescore = false;
 		this->num_colls_print = 0;
 		this->num_sets = 1;
 		this->big_gran = 1;
 		this->small_gran = 1;
+		this->her1_induction = 600;
+		this->her7_induction = 600;
+		this->DAPT_induction = 600;
+		this->mespa_induction = 600;
+		this->mespb_induction = 600;
 		this->width_total = 3;
 		this->width_initial = 3;
 		this->height = 1;
@@ -226,7 +280,21 @@ struct input_params {
 		this->step_size = 0.01;
 		this->max_con_thresh = INFINITY;
 		this->short_circuit = false;
-		this->num_active_mutants = NUM_MUTANTS;
+		this->mutant_stats_file = NULL;
+		this->mutant_stats = false;
+		this->num_active_mutants = 0;
+		this->selected_mutants = NULL;
+		for (int i = 0; i < NUM_SECTIONS; i++) {
+			this->score_sections[i] = true;
+		}
+		this->limit_cycle_tol = 0;
+		this->analysis_threads = 1;
+		this->feature_backend = FEATURE_BACKEND_CRIT;
+		this->fork_inductions = false;
+		this->huge_pages = HUGE_PAGES_NONE;
+		this->pin_threads = false;
+		this->profile_file = NULL;
+		this->profile = false;
 		this->piping = false;
 		this->pipe_in = 0;
 		this->pipe_out = 0;
@@ -239,13 +307,20 @@ struct input_params {
 	~input_params () {
 		mfree(this->params_file);
 		mfree(this->perturb_file);
+		mfree(this->mutants_file);
+		mfree(this->selected_mutants);
 		mfree(this->gradients_file);
 		mfree(this->passed_file);
 		mfree(this->dir_path);
 		mfree(this->features_file);
 		mfree(this->conditions_file);
 		mfree(this->scores_file);
+		mfree(this->features_db_file);
+		mfree(this->rescore_file);
+		mfree(this->pack_file);
 		mfree(this->seed_file);
+		mfree(this->profile_file);
+		mfree(this->mutant_stats_file);
 		delete this->null_stream;
 	}
 };
@@ -303,7 +378,12 @@ struct con_levels {
 	int num_con_levels; // The number of concentration levels this struct stores (not necessarily the total number of concentration levels)
 	int time_steps; // The number of time steps this struct stores concentrations for
 	int cells; // The number of cells this struct stores concentrations for
+	int alloc_con_levels; // The number of concentration levels memory is allocated for (at least num_con_levels)
+	int alloc_time_steps; // The number of time steps memory is allocated for (at least time_steps)
+	int alloc_cells; // The number of cells memory is allocated for (at least cells)
 	double*** cons; // A three dimensional array that stores [concentration levels][time steps][cells] in that order
+	double** rows; // The rows cons points to, [concentration levels * time steps] of them
+	double* levels; // The memory every row points into, one block of [concentration levels][time steps][cells] doubles
 	int* active_start_record; // Record of the start of the active PSM at each time step
 	int* active_end_record; // Record of the end of the active PSM at each time step
 	
@@ -316,29 +396,34 @@ struct con_levels {
 		initialize(num_con_levels, time_steps, cells, active_start);
 	}
 	
-	// Initializes the struct with the given number of concentration levels, time steps, and cells
+	// Initializes the struct with the given number of concentration levels, time steps, and cells (the struct can be reinitialized to resize it)
 	void initialize (int num_con_levels, int time_steps, int cells, int active_start) {
 		// If the current size is big enough to fit the new size then reuse the memory, otherwise allocate the required memory
-		if (this->initialized && this->num_con_levels >= num_con_levels && this->time_steps >= time_steps && this->cells >= cells) {
-			this->reset();
-			this->active_start_record[0] = active_start;
-		} else {
+		if (this->initialized && this->alloc_con_levels >= num_con_levels && this->alloc_time_steps >= time_steps && this->alloc_cells >= cells) {
 			this->num_con_levels = num_con_levels;
 			this->time_steps = time_steps;
 			this->cells = cells;
+			this->reset();
+			this->active_start_record[0] = active_start;
+		} else {
+			this->clear();
+			this->num_con_levels = this->alloc_con_levels = num_con_levels;
+			this->time_steps = this->alloc_time_steps = time_steps;
+			this->cells = this->alloc_cells = cells;
 			this->active_start_record = new int[time_steps];
 			this->active_start_record[0] = active_start; // Initialize the active start record with the given position
 			this->active_end_record = new int[time_steps];
 			this->active_end_record[0] = 0; // Initialize the active end record at position 0
 		
+			// Allocate the levels in one block rather than a block per row so sizing for a set is a few allocations however many time steps it stores
 			this->cons = new double**[num_con_levels];
+			this->rows = new double*[num_con_levels * time_steps];
+			this->levels = (double*)allocate_pages(sizeof(double) * num_con_levels * time_steps * cells);
+			memset(this->levels, 0, sizeof(double) * num_con_levels * time_steps * cells); // Initialize every concentration level at every time step for every cell to 0 (this first touch places the pages on the NUMA node of the simulating thread, which --pin-threads pins before any levels exist)
 			for (int i = 0; i < num_con_levels; i++) {
-				this->cons[i] = new double*[time_steps];
+				this->cons[i] = this->rows + i * time_steps;
 				for (int j = 0; j < time_steps; j++) {
-					this->cons[i][j] = new double[cells];
-					for (int k = 0; k < cells; k++) {
-						this->cons[i][j][k] = 0; // Initialize every concentration level at every time step for every cell to 0
-					}
+					this->cons[i][j] = this->levels + ((size_t)i * time_steps + j) * cells;
 				}
 			}
 			for (int j = 1; j < time_steps; j++) {
@@ -369,12 +454,8 @@ struct con_levels {
 	// Frees the memory used by the struct
 	void clear () {
 		if (this->initialized) {
-			for (int i = 0; i < this->num_con_levels; i++) {
-				for (int j = 0; j < this->time_steps; j++) {
-					delete[] this->cons[i][j];
-				}
-				delete[] this->cons[i];
-			}
+			mfree(this->levels);
+			delete[] this->rows;
 			delete[] this->cons;
 			delete[] this->active_start_record;
             delete[] this->active_end_record;
@@ -387,33 +468,199 @@ struct con_levels {
 	}
 };
 
+/* cl_snapshot stores the concentration levels a mutant's anterior simulation resumes from at the end of its posterior simulation
+	notes:
+		Only the time steps the anterior simulation can read before overwriting them are kept: every delay's worth for the concentration levels read through delays (see DELAYED_CON) and only the last time step for the rest, packed into one block.
+		Time steps are kept in order, oldest first, with the last time step at the end of each concentration level's rows.
+	todo:
+*/
+struct cl_snapshot {
+	bool initialized; // Whether or not this struct's data have been initialized
+	int time_steps; // The number of time steps the simulating concentration levels store (the maximum delay size)
+	int cells; // The number of cells this struct stores concentrations for
+	int rows[NUM_CON_LEVELS]; // The number of time steps kept for each concentration level
+	size_t offsets[NUM_CON_LEVELS]; // Where each concentration level's rows start in levels
+	size_t size; // The number of doubles in levels that are used
+	size_t alloc_size; // The number of doubles memory is allocated for (at least size)
+	int alloc_time_steps; // The number of time steps memory is allocated for in the active records (at least time_steps)
+	double* levels; // The kept rows of every concentration level, [concentration levels][kept time steps][cells]
+	int* active_start_record; // Record of the start of the active PSM at each time step
+	int* active_end_record; // Record of the end of the active PSM at each time step
+	
+	cl_snapshot () {
+		this->initialized = false;
+	}
+	
+	// Initializes the struct for the given maximum delay size and number of cells (the struct can be reinitialized to resize it)
+	void initialize (int time_steps, int cells) {
+		this->time_steps = time_steps;
+		this->cells = cells;
+		size_t size = 0;
+		for (int i = 0; i < NUM_CON_LEVELS; i++) {
+			this->rows[i] = DELAYED_CON(i) ? time_steps : 1;
+			this->offsets[i] = size;
+			size += (size_t)this->rows[i] * cells;
+		}
+		this->size = size;
+		
+		// Reuse the memory if it is big enough, otherwise allocate the required memory
+		if (!this->initialized || this->alloc_size < size || this->alloc_time_steps < time_steps) {
+			this->clear();
+			this->alloc_size = size;
+			this->alloc_time_steps = time_steps;
+			this->levels = (double*)allocate_pages(sizeof(double) * size);
+			this->active_start_record = new int[time_steps];
+			this->active_end_record = new int[time_steps];
+			this->initialized = true;
+		}
+	}
+	
+	// Returns the kept row of the given concentration level at the given time step, counted back from the last time step (0 is the last)
+	double* row (int con, int steps_back) {
+		return this->levels + this->offsets[con] + (size_t)(this->rows[con] - 1 - steps_back) * this->cells;
+	}
+	
+	// Frees the memory used by the struct
+	void clear () {
+		if (this->initialized) {
+			mfree(this->levels);
+			delete[] this->active_start_record;
+			delete[] this->active_end_record;
+			this->initialized = false;
+		}
+	}
+	
+	~cl_snapshot () {
+		this->clear();
+	}
+};
+
+/* scratch_arena hands out temporary buffers from retained blocks of memory and takes them all back at once
+	notes:
+		Feature analysis borrows its buffers from the arena in sim_data, which is reset before every mutant is analyzed, so the same memory is reused for every mutant and parameter set instead of being allocated and freed each time.
+		A request that does not fit in the current block gets a new, bigger block. The next reset replaces all the blocks with one as big as everything borrowed since the previous reset, so the arena stops allocating once it has seen the biggest analysis.
+		Buffers are aligned to ARENA_ALIGN bytes and are not zeroed.
+	todo:
+*/
+struct scratch_arena {
+	char* block; // The block buffers are currently handed out from, whose first ARENA_ALIGN bytes point to the previous block (or NULL)
+	size_t capacity; // The size in bytes of the current block
+	size_t used; // The number of bytes of the current block handed out, including the link to the previous block
+	size_t borrowed; // The number of bytes handed out from every block since the last reset
+
+	scratch_arena () {
+		this->block = NULL;
+		this->capacity = 0;
+		this->used = 0;
+		this->borrowed = 0;
+	}
+	
+	// Returns an uninitialized buffer of the given size that stays valid until the next reset
+	void* borrow (size_t size) {
+		size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+		if (this->block == NULL || this->used + size > this->capacity) {
+			this->add_block(MAX(2 * this->capacity, size + ARENA_ALIGN));
+		}
+		void* buffer = this->block + this->used;
+		this->used += size;
+		this->borrowed += size;
+		return buffer;
+	}
+	
+	template<typename T> T* borrow_array (int length) {
+		return (T*)this->borrow(sizeof(T) * MAX(length, 1));
+	}
+	
+	// Returns an array of the given length with every element set to the given value
+	template<typename T> T* borrow_filled (int length, T value) {
+		T* array = this->borrow_array<T>(length);
+		for (int i = 0; i < length; i++) {
+			array[i] = value;
+		}
+		return array;
+	}
+	
+	void add_block (size_t capacity) {
+		char* new_block = (char*)mallocate(capacity);
+		*(char**)new_block = this->block;
+		this->block = new_block;
+		this->capacity = capacity;
+		this->used = ARENA_ALIGN;
+	}
+	
+	// Takes back every buffer, merging the blocks into one if more than one was needed
+	void reset () {
+		if (this->block != NULL && *(char**)this->block != NULL) {
+			size_t needed = this->borrowed + ARENA_ALIGN;
+			this->clear();
+			this->add_block(needed);
+		}
+		this->used = ARENA_ALIGN;
+		this->borrowed = 0;
+	}
+	
+	void clear () {
+		while (this->block != NULL) {
+			char* previous = *(char**)this->block;
+			mfree(this->block);
+			this->block = previous;
+		}
+		this->capacity = 0;
+		this->used = 0;
+	}
+	
+	~scratch_arena () {
+		this->clear();
+	}
+};
+
 /* growin_array is an integer array that resizes when necessary by doubling its size until it can access the requested index
 	notes:
 		The [] operator has been overloaded for the sake of convenience. It returns a reference to the value requested but also resizes the array when necessary.
+		An array given a scratch arena borrows its memory from the arena, including when it resizes, and leaves freeing it to the arena's reset.
 	todo:
 */
 struct growin_array {
 	int* array; // The array of integers
 	int size; // The size of the array
+	scratch_arena* arena; // The arena the array's memory is borrowed from, NULL to use the heap
 
 	growin_array() {}
 
 	void initialize(int size) {
 		array = new int[size];
 		this->size = size;
+		this->arena = NULL;
+	}
+	
+	void initialize(int size, scratch_arena& arena) {
+		this->size = MAX(size, 1);
+		this->arena = &arena;
+		array = arena.borrow_array<int>(this->size);
 	}
 	
 	explicit growin_array (int size) {
 		this->initialize(size);
 	}
+	
+	growin_array (int size, scratch_arena& arena) {
+		this->initialize(size, arena);
+	}
 
 	int& operator[] (int index) {
 		if (index >= this->size) {
-			int* new_array = new int[2 * this->size];
+			int* new_array;
+			if (this->arena != NULL) {
+				new_array = this->arena->borrow_array<int>(2 * this->size);
+			} else {
+				new_array = new int[2 * this->size];
+			}
 			for (int i = 0; i < this->size; i++) {
 				new_array[i] = array[i];
 			}
-			delete[] array;
+			if (this->arena == NULL) {
+				delete[] array;
+			}
 			this->size = 2 * this->size;
 			array = new_array;
 		}
@@ -429,12 +676,239 @@ struct growin_array {
 	}
 	
 	~growin_array () {
-		delete[] array;
+		if (this->arena == NULL) {
+			delete[] array;
+		}
+	}
+};
+
+/* peak_set contains the peaks and troughs of several concentrations' oscillations in several cells
+	notes:
+		The critical points of each concentration in each cell are kept contiguous and in chronological order in their own arrays, at index(con, cell), where con and cell are positions in the lists given to get_peaks_and_troughs.
+		The set's memory is borrowed from scratch arenas, so the set must not outlive their next reset. The arrays of each cell are only initialized (with initialize_cell) by whichever worker analyzes that cell so they grow in that worker's arena.
+	todo:
+*/
+struct peak_set {
+	int num_cons; // The number of concentrations analyzed
+	int num_cells; // The number of cells analyzed
+	int initial_size; // The number of points each cell's arrays start with room for
+	growin_array* times; // The time steps of the critical points of each concentration in each cell
+	growin_array* types; // Whether each critical point is a peak or a trough (-1 for trough, 1 for peak)
+	growin_array* positions; // The position in the PSM of each critical point
+	int* num_points; // The number of critical points of each concentration in each cell
+	int* lengths; // The number of time steps analyzed in each cell before it split or the simulation ended
+
+	peak_set (int num_cons, int num_cells, int size, scratch_arena& arena) {
+		this->num_cons = num_cons;
+		this->num_cells = num_cells;
+		this->initial_size = size;
+		this->times = arena.borrow_array<growin_array>(num_cons * num_cells);
+		this->types = arena.borrow_array<growin_array>(num_cons * num_cells);
+		this->positions = arena.borrow_array<growin_array>(num_cons * num_cells);
+		this->num_points = arena.borrow_array<int>(num_cons * num_cells);
+		this->lengths = arena.borrow_array<int>(num_cells);
+	}
+
+	// Empties the given cell's arrays of every concentration, borrowing their memory from the given arena
+	void initialize_cell (int cell, scratch_arena& arena) {
+		for (int c = 0; c < this->num_cons; c++) {
+			int i = this->index(c, cell);
+			this->times[i].initialize(this->initial_size, arena);
+			this->types[i].initialize(this->initial_size, arena);
+			this->positions[i].initialize(this->initial_size, arena);
+			this->num_points[i] = 0;
+		}
+		this->lengths[cell] = 0;
+	}
+
+	int index (int con, int cell) {
+		return con * this->num_cells + cell;
+	}
+
+	void add (int index, int time, int type, int position) {
+		int point = this->num_points[index]++;
+		this->times[index][point] = time;
+		this->types[index][point] = type;
+		this->positions[index][point] = position;
+	}
+};
+
+/* sync_stats contains the running statistics needed to correlate a reference series with the series of several rows at once
+	notes:
+		Points are added with Welford's updates and windows are combined with Chan et al.'s pairwise formulas, which avoids the cancellation plain running sums of x, y, xy, x^2, and y^2 suffer from.
+		The reference series' statistics are shared by every row and each row's are kept in their own array so the loops over rows vectorize.
+	todo:
+*/
+struct sync_stats {
+	int num_rows; // The number of rows correlated with the reference series
+	int n; // The number of points added
+	double mean_x; // The mean of the reference series
+	double m2_x; // The sum of the squared deviations of the reference series from its mean
+	double* mean_y; // The mean of each row's series
+	double* m2_y; // The sum of the squared deviations of each row's series from its mean
+	double* c_xy; // The sum of the products of the reference series' and each row's deviations
+
+	explicit sync_stats (int num_rows) {
+		this->num_rows = num_rows;
+		this->mean_y = (double*)mallocate(sizeof(double) * num_rows);
+		this->m2_y = (double*)mallocate(sizeof(double) * num_rows);
+		this->c_xy = (double*)mallocate(sizeof(double) * num_rows);
+		this->reset();
+	}
+
+	void reset () {
+		this->n = 0;
+		this->mean_x = 0;
+		this->m2_x = 0;
+		memset(this->mean_y, 0, sizeof(double) * this->num_rows);
+		memset(this->m2_y, 0, sizeof(double) * this->num_rows);
+		memset(this->c_xy, 0, sizeof(double) * this->num_rows);
+	}
+
+	// Adds the reference series' point x and every row's point in y
+	void add (double x, const double* y) {
+		this->n++;
+		double inv_n = 1.0 / this->n;
+		double dx = x - this->mean_x;
+		this->mean_x += dx * inv_n;
+		this->m2_x += dx * (x - this->mean_x);
+		for (int r = 0; r < this->num_rows; r++) {
+			double dy = y[r] - this->mean_y[r];
+			this->mean_y[r] += dy * inv_n;
+			double dy_new = y[r] - this->mean_y[r];
+			this->m2_y[r] += dy * dy_new;
+			this->c_xy[r] += dx * dy_new;
+		}
+	}
+
+	// Adds every point of the other statistics, which must have as many rows
+	void merge (const sync_stats& other) {
+		if (other.n == 0) {
+			return;
+		}
+		int total = this->n + other.n;
+		double weight = (double)other.n / total;
+		double product = (double)this->n * other.n / total;
+		double dx = other.mean_x - this->mean_x;
+		this->mean_x += dx * weight;
+		this->m2_x += other.m2_x + dx * dx * product;
+		for (int r = 0; r < this->num_rows; r++) {
+			double dy = other.mean_y[r] - this->mean_y[r];
+			this->mean_y[r] += dy * weight;
+			this->m2_y[r] += other.m2_y[r] + dy * dy * product;
+			this->c_xy[r] += other.c_xy[r] + dx * dy * product;
+		}
+		this->n = total;
+	}
+
+	// Returns the Pearson correlation of the reference series with the given row's series, 1 if either is constant (like pearson_correlation)
+	double correlation (int row) {
+		double sigma_x = sqrt(this->m2_x);
+		double sigma_y = sqrt(this->m2_y[row]);
+		if (sigma_x == 0 || sigma_y == 0) {
+			return 1;
+		}
+		return this->c_xy[row] / (sigma_x * sigma_y);
+	}
+
+	~sync_stats () {
+		mfree(this->mean_y);
+		mfree(this->m2_y);
+		mfree(this->c_xy);
+	}
+};
+
+/* time_series stores a feature at time points after a mutant's induction, indexed by the number of hours since the induction (the features code rounds the half hour a feature was recorded in to the nearest hour)
+	notes:
+		Like a map, reading or writing an index records it, and reading or writing past the end lengthens the series with unrecorded zeros. Only the recorded indices are printed in features databases, so they hold the same pairs the maps this replaced did. The memory is kept when the series is cleared, so once the longest series has been recorded, recording features and copying them no longer allocate.
+	todo:
+*/
+struct time_series {
+	double* values; // The value at each index
+	bool* recorded; // Whether each index has been read or written since the series was cleared
+	int length; // The number of indices in use (one more than the largest index read or written since the series was cleared)
+	int num_recorded; // The number of indices recorded since the series was cleared
+	int capacity; // The number of indices memory is allocated for
+	
+	time_series () {
+		this->values = NULL;
+		this->recorded = NULL;
+		this->length = 0;
+		this->num_recorded = 0;
+		this->capacity = 0;
+	}
+	
+	time_series (const time_series& other) {
+		this->values = NULL;
+		this->recorded = NULL;
+		this->length = 0;
+		this->num_recorded = 0;
+		this->capacity = 0;
+		*this = other;
+	}
+	
+	time_series& operator= (const time_series& other) {
+		if (this != &other) {
+			this->length = 0;
+			this->lengthen(other.length);
+			if (other.length > 0) {
+				memcpy(this->values, other.values, sizeof(double) * other.length);
+				memcpy(this->recorded, other.recorded, sizeof(bool) * other.length);
+			}
+			this->num_recorded = other.num_recorded;
+		}
+		return *this;
+	}
+	
+	double& operator[] (int index) {
+		if (index >= this->length) {
+			this->lengthen(index + 1);
+		}
+		if (!this->recorded[index]) {
+			this->recorded[index] = true;
+			this->num_recorded++;
+		}
+		return this->values[index];
+	}
+	
+	// Lengthens the series to the given length, zeroing the new indices and allocating more memory if needed
+	void lengthen (int length) {
+		if (length > this->capacity) {
+			int capacity = MAX(MAX(length, 2 * this->capacity), TIME_SERIES_MIN_CAPACITY);
+			double* values = new double[capacity];
+			bool* recorded = new bool[capacity];
+			if (this->length > 0) {
+				memcpy(values, this->values, sizeof(double) * this->length);
+				memcpy(recorded, this->recorded, sizeof(bool) * this->length);
+			}
+			delete[] this->values;
+			delete[] this->recorded;
+			this->values = values;
+			this->recorded = recorded;
+			this->capacity = capacity;
+		}
+		if (length > this->length) {
+			memset(this->values + this->length, 0, sizeof(double) * (length - this->length));
+			memset(this->recorded + this->length, false, sizeof(bool) * (length - this->length));
+			this->length = length;
+		}
+	}
+	
+	// Empties the series but keeps its memory
+	void clear () {
+		this->length = 0;
+		this->num_recorded = 0;
+	}
+	
+	~time_series () {
+		delete[] this->values;
+		delete[] this->recorded;
 	}
 };
 
 /* features contains the oscillation features for a particular simulation
 	notes:
+		The features are reset for every mutant before each parameter set, so nothing a mutant's analysis adds to carries over to the next set.
 	todo:
 */
 struct features {
@@ -449,11 +923,11 @@ struct features {
     	double comp_score_ant_mespa; // The score for the complementary expression of her and mespa
     	double comp_score_ant_mespb; // The score for the complementary expression of her and mespb
 	double num_good_somites[NUM_INDICES]; // The number of good somites for the relevant concentrations
-    	map<int, double> period_post_time[NUM_INDICES]; // The period in the posterior at various time points in the simulation
-   	map<int, double> amplitude_post_time[NUM_INDICES]; // The amplitude in the posterior at various time points in the simulation
-   	map<int, double> period_ant_time[NUM_INDICES]; // The period in the anterior at various time points in the simulation
-   	map<int, double> amplitude_ant_time[NUM_INDICES]; // The amplitude in the anterior at various time points in the simulaiton
-    	map<int, double> sync_time[NUM_INDICES]; // The amplitude in the anterior at various time points in the simulation
+	time_series period_post_time[NUM_INDICES]; // The period in the posterior at various time points in the simulation
+	time_series amplitude_post_time[NUM_INDICES]; // The amplitude in the posterior at various time points in the simulation
+	time_series period_ant_time[NUM_INDICES]; // The period in the anterior at various time points in the simulation
+	time_series amplitude_ant_time[NUM_INDICES]; // The amplitude in the anterior at various time points in the simulaiton
+	time_series sync_time[NUM_INDICES]; // The synchronization score in the anterior at various time points in the simulation
 	
 	features () {
 		memset(period_post, 0, sizeof(period_post));
@@ -481,6 +955,53 @@ struct features {
 		memset(num_good_somites, 0, sizeof(num_good_somites));
         comp_score_ant_mespa = 0;
         comp_score_ant_mespb = 0;
+		for (int i = 0; i < NUM_INDICES; i++) {
+			period_post_time[i].clear();
+			amplitude_post_time[i].clear();
+			period_ant_time[i].clear();
+			amplitude_ant_time[i].clear();
+			sync_time[i].clear();
+		}
+	}
+};
+
+/* wave_snapshot contains the traveling waves measured in the PSM at one time step
+	notes:
+		These are the only concentration levels the wave tests read, so measuring them once lets the wave tests be rerun without the concentration levels.
+	todo:
+*/
+struct wave_snapshot {
+	int num_waves; // The number of waves found, up to MAX_WAVES + 1
+	pair<int, int> waves[MAX_WAVES]; // The start and end column of each wave found
+	int wlength_post; // The length of the last wave found in the posterior half of the PSM
+	int wlength_ant; // The length of the last wave found in the anterior end of the PSM
+	
+	wave_snapshot () {
+		this->num_waves = 0;
+		this->wlength_post = 0;
+		this->wlength_ant = 0;
+	}
+};
+
+/* scoring_record contains everything a mutant's tests read in one section, so the tests can be rerun without simulating
+	notes:
+		The conditions are kept as they were before the tests ran since the analysis sets some of them (e.g. the wild type's anterior condition 0) and the tests combine their results with the rest.
+		The wild type's features are not kept since the wild type is always scored first in each section and its own record holds them.
+	todo:
+*/
+struct scoring_record {
+	bool simulated; // Whether or not the mutant was simulated in this section of the current parameter set
+	bool completed; // Whether or not the simulation completed, i.e. whether the tests ran
+	features feat; // The mutant's features when the tests ran
+	double conds_passed[NUM_SECTIONS][1 + MAX_CONDS_ANY]; // The mutant's conditions before the tests ran
+	int num_snapshots; // The number of traveling wave snapshots measured (0 unless the wave tests ran)
+	wave_snapshot snapshots[MAX_WAVE_SNAPSHOTS]; // The traveling waves at each time step the wave tests check
+	
+	scoring_record () {
+		this->simulated = false;
+		this->completed = false;
+		memset(this->conds_passed, 0, sizeof(this->conds_passed));
+		this->num_snapshots = 0;
 	}
 };
 
@@ -489,16 +1010,17 @@ struct features {
 	todo:
 */
 struct mutant_data {
-	int index; // The index, i.e. how many mutants run before this one
+	int index; // Which coded-in mutant this is (or whose tests and analysis a mutant from a mutants file uses)
 	char* print_name; // The mutant's name for printing output
 	char* dir_name; // The mutant's name for making its directory
 	int num_knockouts; // The number of knockouts required to achieve this mutant
 	int knockouts[2]; // The indices of the concentrations to knockout (num_knockouts determines how many indices to knockout)
+	bool induced_knockouts; // Whether the knockouts wait for the induction instead of applying from the start
     double overexpression_rate; // Which gene should be overexpressed, -1 = none 
 	double overexpression_factor; // Overexpression factors with 1=100% overexpressed, if 0 then no overexpression
 	int induction; // The induction point for mutants that are time sensitive
     int recovery;
-	con_levels cl; // The concentration levels at the end of this mutant's posterior simulation run
+	cl_snapshot snapshot; // The concentration levels at the end of this mutant's posterior simulation run that its anterior simulation resumes from
 	double (*tests[2])(mutant_data&, features&); // The posterior and anterior conditions tests
 	int (*wave_test)(pair<int, int>[], int, mutant_data&, int, int); // The traveling wave conditions test
 	int num_conditions[NUM_SECTIONS]; // The number of conditions this mutant is tested on
@@ -507,7 +1029,11 @@ struct mutant_data {
 	bool secs_passed[NUM_SECTIONS]; // Whether or not this mutant has passed each section's conditions
 	double conds_passed[NUM_SECTIONS][1 + MAX_CONDS_ANY]; // The score this mutant achieved for each condition when run
 	features feat; // The oscillation features this mutant produced when run
+	scoring_record records[NUM_SECTIONS]; // What this mutant's tests read in each section of the current parameter set, kept only for the features database
 	int print_con; // The index of the concentration that should be printed (usually mh1)
+	int runs[NUM_SECTIONS]; // The number of times this mutant was simulated in each section, including the runs loaded from the mutant stats file
+	int failures[NUM_SECTIONS]; // The number of those runs that failed
+	double steps_run[NUM_SECTIONS]; // The total number of time steps those runs simulated
 	
 	mutant_data () {
 		this->index = 0;
@@ -519,6 +1045,7 @@ struct mutant_data {
         this->overexpression_rate = -1;
         this->overexpression_factor = 0;
 		memset(this->knockouts, 0, sizeof(this->knockouts));
+		this->induced_knockouts = false;
 		memset(this->tests, 0, sizeof(this->tests));
 		this->wave_test = NULL;
 		memset(this->num_conditions, 0, sizeof(this->num_conditions));
@@ -527,12 +1054,15 @@ struct mutant_data {
 		memset(this->max_cond_scores, 0, sizeof(this->max_cond_scores));
 		memset(this->secs_passed, false, sizeof(this->secs_passed));
 		this->print_con = CMH1;
+		memset(this->runs, 0, sizeof(this->runs));
+		memset(this->failures, 0, sizeof(this->failures));
+		memset(this->steps_run, 0, sizeof(this->steps_run));
 	}
 	
 	~mutant_data () {
 		mfree(this->print_name);
 		mfree(this->dir_name);
-		this->cl.clear();
+		this->snapshot.clear();
 	}
 	
 	// Calculates the maximum score this mutant can achieve for each section based on the scores given for each condition
@@ -546,6 +1076,223 @@ struct mutant_data {
 	}
 };
 
+/* thread_pool contains the worker threads feature analysis splits its per-cell work across
+	notes:
+		The calling thread works as worker 0, so a pool of n workers starts n - 1 threads. Every other worker borrows from its own scratch arena in arenas so workers never share an allocator.
+		Every task is handed to all the workers at once and each worker picks its share of the cells by its index, so which worker analyzes what never depends on timing.
+	todo:
+*/
+struct thread_pool {
+	int num_workers; // The number of workers, including the calling thread
+	pthread_t* threads; // The threads of workers 1 to num_workers - 1
+	scratch_arena* arenas; // The scratch arena of each worker (worker 0 uses the one in sim_data instead of arenas[0])
+	pthread_mutex_t lock; // The lock guarding the fields below
+	pthread_cond_t task_ready; // Signaled when a new task is posted or the pool is shutting down
+	pthread_cond_t task_done; // Signaled when a worker finishes the current task
+	int generation; // The number of tasks posted so far, which lets workers tell a new task from the one they just finished
+	int num_done; // The number of threads that have finished the current task
+	bool quitting; // Whether the threads should exit
+	void (*task)(void*, int); // The current task, which is given its argument and the worker's index
+	void* task_arg; // The current task's argument
+	
+	thread_pool () {
+		this->num_workers = 1;
+		this->threads = NULL;
+		this->arenas = NULL;
+		this->generation = 0;
+		this->num_done = 0;
+		this->quitting = false;
+		this->task = NULL;
+		this->task_arg = NULL;
+	}
+};
+
+/* output_file is an output stream that either writes its file directly or collects what is written for the background writer
+	notes:
+		Without a background writer (the default) the stream writes through file like an ofstream. With one, the stream writes to buffer, and hand_off_output gives what was collected to the writer as a record with the file's path, so the simulating thread never touches the file itself. The first record creates or truncates the file and the rest append to it, so handing off never changes what the file ends up holding.
+	todo:
+*/
+struct output_file : public ostream {
+	filebuf file; // The file, when it is written directly
+	stringbuf buffer; // What was written since the last hand-off, when a background writer writes the file
+	char* path; // The path and name of the file, when a background writer writes it
+	bool append; // Whether the next record handed off should append to the file rather than create it
+	int pack_set; // The parameter set of the pack record the stream writes, when it writes to the pack file
+	char* pack_mutant; // The mutant directory name of the pack record the stream writes, NULL if it does not write to the pack file
+	char* pack_type; // The file name suffix (after "set_<n>") of the pack record the stream writes, when it writes to the pack file
+	
+	output_file () : ostream(NULL) {
+		this->path = NULL;
+		this->append = false;
+		this->pack_set = 0;
+		this->pack_mutant = NULL;
+		this->pack_type = NULL;
+	}
+	
+	~output_file () {
+		mfree(this->path);
+		mfree(this->pack_mutant);
+		mfree(this->pack_type);
+	}
+};
+
+/* output_record contains output handed to the background writer
+	notes:
+		Records own their path and data, so the stream that handed them off can be closed or destroyed right away. A record with no path asks the writer to close every file it has open.
+	todo:
+*/
+struct output_record {
+	char* path; // The path and name of the file to write to, NULL to close every open file
+	bool append; // Whether to append to the file rather than create it
+	bool last; // Whether the stream was closed after this record, so the writer should close the file once it is written
+	string* data; // The bytes to write
+};
+
+/* output_writer contains the background thread that writes output files and the queue the simulating thread hands it records through
+	notes:
+		The queue is a ring of OUTPUT_QUEUE_SLOTS records with one producer (the simulating thread) and one consumer (the writer), so it needs no lock: the producer alone advances head and the consumer alone advances tail, each publishing its slot with a release store the other reads with an acquire load.
+		The queue is bounded by both slots and bytes, and the producer waits when either runs out, so a slow disk slows the simulation down instead of filling memory. A record bigger than the byte budget is still queued once the queue is empty.
+		A side with nothing to do sleeps on its condition variable after raising its waiting flag and checking the queue once more under the lock, and the other side signals it after moving head or tail if it sees the flag, so neither side polls and no wake-up is lost.
+		The writer keeps each file open from its first record until the stream's last one or a flush, holding up to OUTPUT_OPEN_FILES at once and closing the one opened longest ago when it needs another.
+		The writer never exits the program. A failed write is recorded in failed_path and the writer keeps discarding records so the producer never waits forever; the producer reports the failure and exits the next time it hands off or flushes.
+	todo:
+*/
+struct output_writer {
+	output_record slots[OUTPUT_QUEUE_SLOTS]; // The ring of queued records
+	long long head; // The number of records queued so far, written only by the producer
+	long long tail; // The number of records written so far, written only by the writer
+	size_t bytes_queued; // The number of bytes of the records queued but not yet written
+	size_t max_bytes; // The most bytes the queued records can hold (unless only one record is queued)
+	bool quitting; // Whether the writer should exit once the queue is empty
+	char* failed_path; // The path of the file the writer failed to write, NULL if none has failed
+	pthread_t thread; // The writer thread
+	pthread_mutex_t lock; // The lock a side holds while deciding to sleep and the other holds while waking it
+	pthread_cond_t work_ready; // Signaled when a record is queued or the writer should quit
+	pthread_cond_t space_ready; // Signaled when a record has been written
+	int writer_waiting; // Whether the writer is asleep, or about to be, waiting for work_ready
+	int producer_waiting; // Whether the producer is asleep, or about to be, waiting for space_ready
+	FILE* files[OUTPUT_OPEN_FILES]; // The files the writer has open, NULL for unused entries
+	char* file_paths[OUTPUT_OPEN_FILES]; // The path of each open file
+	int next_closed; // The entry of files to close when the writer needs another and every entry is used
+	
+	output_writer () {
+		memset(this->slots, 0, sizeof(this->slots));
+		this->head = 0;
+		this->tail = 0;
+		this->bytes_queued = 0;
+		this->max_bytes = 0;
+		this->quitting = false;
+		this->failed_path = NULL;
+		this->writer_waiting = 0;
+		this->producer_waiting = 0;
+		memset(this->files, 0, sizeof(this->files));
+		memset(this->file_paths, 0, sizeof(this->file_paths));
+		this->next_closed = 0;
+	}
+};
+
+/* pack_writer contains the pack file every packed output file is appended to
+	notes:
+		Each hand-off of a packed stream appends one chunk to the file and one entry to index, which is only written, after the chunks, when the pack is closed. See the README for the file's layout.
+	todo:
+*/
+struct pack_writer {
+	output_file file; // The pack file
+	ostringstream index; // The entries of every chunk appended so far
+	int num_entries; // The number of entries in index
+	long long offset; // The offset in the file the next chunk will be appended at
+	
+	pack_writer () {
+		this->num_entries = 0;
+		this->offset = 0;
+	}
+};
+
+/* pack_entry contains the index entry of a chunk in a pack file
+	notes:
+		A record (what would have been one file) is every chunk with its set, mutant, and type, concatenated in index order.
+	todo:
+*/
+struct pack_entry {
+	int set; // The parameter set the chunk belongs to
+	string mutant; // The mutant directory name the chunk belongs to
+	string type; // The file name suffix (after "set_<n>") the chunk belongs to, e.g. ".cons" or "_period_mh1_post.feats"
+	long long offset; // The chunk's offset in the pack file
+	long long size; // The chunk's size in bytes
+};
+
+/* pack_reader contains an open pack file and its index, for reading the records of a pack file back
+	notes:
+		This is for programs that read pack files; the simulation only writes them.
+	todo:
+*/
+struct pack_reader {
+	ifstream file; // The pack file
+	pack_entry* entries; // The index entry of every chunk, in the order they were appended
+	int num_entries; // The number of entries
+	
+	pack_reader () {
+		this->entries = NULL;
+		this->num_entries = 0;
+	}
+	
+	~pack_reader () {
+		delete[] this->entries;
+	}
+};
+
+/* ring_header is the start of a shared-memory ring, a byte stream in a memfd that a sampler can pass in place of a pipe end (see -I and -O)
+	notes:
+		The ring's data follows the header. head and tail count the bytes written and read modulo 2^32, so their difference is the number of unread bytes; each is waited on as a futex and sits on its own cache line.
+		Samplers that create rings (see sres/source/ring.cpp) use the same layout, so the two must be changed together.
+	todo:
+*/
+struct ring_header {
+	char magic[8]; // RING_MAGIC
+	unsigned int capacity; // The bytes of data the ring holds, a power of 2
+	int closed; // Whether the writing side has closed the ring, i.e. will write no more
+	char pad_0[48];
+	unsigned int head; // The bytes written so far, moved only by the writing side
+	int reader_waiting; // Whether the reading side is waiting for the head to move
+	char pad_1[56];
+	unsigned int tail; // The bytes read so far, moved only by the reading side
+	int writer_waiting; // Whether the writing side is waiting for the tail to move
+	char pad_2[56];
+};
+
+/* ring contains a shared-memory ring mapped into this process
+	notes:
+	todo:
+*/
+struct ring {
+	int fd; // The file descriptor of the memfd holding the ring
+	ring_header* header; // The mapped header
+	char* data; // The mapped data, right after the header
+	size_t size; // The bytes mapped
+};
+
+/* induction_forks contains the wild type's posterior state at the time steps where induced mutants start to differ from it
+	notes:
+		Before its induction a mutant without knockouts (or whose knockouts wait for the induction, like DAPT) simulates exactly what the wild type does: both perturb their rates from the same seed and posterior simulations never update the active rates afterward. Such a mutant can copy the wild type's state at its first time step past the induction and simulate only the rest.
+		Each fork keeps baby_cl as it was before the fork's time step. The analysis levels before the last fork are kept once in cl since every fork shares them.
+		Anterior simulations split cells from their first time step, drawing random numbers the wild type and the mutants draw at different points, so they are never forked.
+	todo:
+*/
+struct induction_forks {
+	int num_forks; // The number of distinct time steps to fork at in the current section (0 if not forking)
+	int times[MAX_MUTANTS]; // The time step each fork resumes at, in increasing order
+	con_levels baby_cls[MAX_MUTANTS]; // The simulating concentration levels before each fork's time step
+	int num_taken; // The number of forks the wild type has reached in the current section (a failing or early-stopping wild type does not reach them all)
+	con_levels cl; // The wild type's analysis concentration levels before the last fork taken
+	int rows_copied; // The number of time steps of the analysis concentration levels copied to cl so far
+	
+	induction_forks () {
+		this->num_forks = 0;
+		this->num_taken = 0;
+		this->rows_copied = 0;
+	}
+};
+
 /* sim_data contains simulation data, partially taken from input_params and partially derived from other information
 	notes:
 		There should be only one instance of sim_data at any time.
@@ -559,7 +1306,7 @@ struct sim_data {
 	int steps_total; // The number of time steps to simulate (total time / step size)
 	int steps_split; // The number of time steps it takes for cells to split
 	int steps_til_growth; // The number of time steps to wait before allowing cells to grow into the anterior PSM
-	bool no_growth; // Whether or not the simulation should rerun with growth
+	bool no_growth; // Whether or not the simulation should rerun with growth (not if neither the anterior nor the wave is scored)
 	
 	// Granularities
 	int big_gran; // The granularity in time steps with which to analyze and store data
@@ -567,7 +1314,8 @@ struct sim_data {
 	
 	// Cutoff values
 	double max_con_thresh; // The maximum threshold concentrations can reach before the simulation is prematurely ended
-	int max_delay_size; // The maximum number of time steps any delay in the current parameter set takes plus 1 (so that baby_cl and each mutant know how many minutes to store)
+	int max_delay_size; // The maximum number of time steps any delay in the current parameter set takes plus 1 (so that baby_cl and each mutant know how many minutes to store), recalculated for every set
+	double limit_cycle_tol; // The relative tolerance for detecting a stable limit cycle in posterior simulations (0 = never stop early)
 	
 	// Sizes
 	int width_total; // The width in cells of the PSM
@@ -586,11 +1334,22 @@ struct sim_data {
 	int time_start; // The start time (in time steps) of the current simulation
 	int time_end; // The end time (in time steps) of the current simulation
 	int time_baby; // Time 0 for baby_cl at the end of a simulation
+	int steps_simulated; // The number of time steps the last simulation ran before finishing or failing
+	
+	// Forking induced mutants from the wild type
+	bool fork_inductions; // Whether or not induced mutants resume posterior simulations from the wild type's state at their induction
+	induction_forks forks; // The wild type's states induced mutants resume from
 	
 	// Mutants and condition scores
 	int num_active_mutants; // The number of mutants to simulate for each parameter set
 	double max_scores[NUM_SECTIONS]; // The maximum score possible for all mutants for each testing section
 	double max_score_all; // The maximum score possible for all mutants for all testing sections
+	bool score_sections[NUM_SECTIONS]; // Whether or not to score each testing section
+	
+	// Scratch memory and analysis threads
+	scratch_arena scratch; // The arena feature analysis borrows its buffers from, reset before every mutant is analyzed
+	scratch_arena set_scratch; // The arena buffers that last no longer than a parameter set are borrowed from, reset before every set is simulated
+	thread_pool* pool; // The threads feature analysis splits its per-cell work across, NULL to analyze on the calling thread only
 	
 	explicit sim_data (input_params& ip) {
 		this->step_size = ip.step_size;
@@ -598,11 +1357,12 @@ struct sim_data {
 		this->steps_total = ip.time_total / ip.step_size;
 		this->steps_split = ip.time_split / ip.step_size;
 		this->steps_til_growth = ip.time_til_growth / ip.step_size;
-		this->no_growth = this->steps_total == this->steps_til_growth || ip.width_initial == ip.width_total;
+		this->no_growth = this->steps_total == this->steps_til_growth || ip.width_initial == ip.width_total || !(ip.score_sections[SEC_ANT] || ip.score_sections[SEC_WAVE]);
 		this->big_gran = ip.big_gran;
 		this->small_gran = ip.small_gran;
 		this->max_con_thresh = ip.max_con_thresh;
 		this->max_delay_size = 0;
+		this->limit_cycle_tol = ip.limit_cycle_tol;
 		this->width_total = ip.width_total;
 		this->width_initial = ip.width_initial;
 		this->width_current = ip.width_initial;
@@ -622,9 +1382,13 @@ struct sim_data {
 		this->time_start = 0;
 		this->time_end = 0;
 		this->time_baby = 0;
+		this->steps_simulated = 0;
+		this->fork_inductions = ip.fork_inductions;
 		this->num_active_mutants = ip.num_active_mutants;
 		memset(this->max_scores, 0, sizeof(this->max_scores));
 		this->max_score_all = 0;
+		memcpy(this->score_sections, ip.score_sections, sizeof(this->score_sections));
+		this->pool = NULL;
 	}
 	
 	// Initializes the scores once mutants have been initialized
@@ -652,6 +1416,111 @@ struct sim_data {
 	}
 };
 
+/* cycle_monitor contains the peak history used to detect when a posterior simulation has settled into a stable limit cycle
+	notes:
+		Only cells that are simulated in the posterior are monitored. A cell is stable once its last LIMIT_CYCLE_CYCLES periods and peak heights each agreed with the one before within the tolerance.
+		The monitor's arrays are borrowed from the set arena in sim_data, so a monitor must not outlive the set it was created in and needs no destructor.
+	todo:
+*/
+struct cycle_monitor {
+	double tolerance; // The relative tolerance successive periods and peak heights must agree within
+	int time_start; // The first time step to monitor (no knockouts, overexpression, or recoveries happen after it)
+	int num_cells; // The number of monitored cells
+	int* cells; // The indices of the monitored cells
+	double* prev; // The concentration of each monitored cell at the previous time step
+	double* prev2; // The concentration of each monitored cell two time steps ago
+	int* last_peak; // The time step of each monitored cell's last peak, -1 if there has not been one
+	double* last_height; // The height of each monitored cell's last peak
+	int* last_period; // The length in time steps of each monitored cell's last period, 0 if there has not been one
+	int* stable_cycles; // The number of successive periods for each monitored cell that matched the one before
+	int period; // The period in time steps of the stable limit cycle, 0 until one is found
+	
+	explicit cycle_monitor (sim_data& sd, double tolerance, int time_start) {
+		this->tolerance = tolerance;
+		this->time_start = time_start;
+		scratch_arena& arena = sd.set_scratch;
+		this->cells = arena.borrow_array<int>(sd.cells_total);
+		this->num_cells = 0;
+		for (int k = 0; k < sd.cells_total; k++) {
+			if (sd.width_current == sd.width_total || k % sd.width_total <= sd.active_start) {
+				this->cells[this->num_cells++] = k;
+			}
+		}
+		this->prev = arena.borrow_filled<double>(this->num_cells, 0);
+		this->prev2 = arena.borrow_filled<double>(this->num_cells, 0);
+		this->last_peak = arena.borrow_filled<int>(this->num_cells, -1);
+		this->last_height = arena.borrow_filled<double>(this->num_cells, 0);
+		this->last_period = arena.borrow_filled<int>(this->num_cells, 0);
+		this->stable_cycles = arena.borrow_filled<int>(this->num_cells, 0);
+		this->period = 0;
+	}
+};
+
+/* memory_header precedes every block of memory handed out by mallocate
+	notes:
+		The header is 16 bytes so the memory after it keeps malloc's alignment.
+	todo:
+*/
+struct memory_header {
+	size_t size; // The number of bytes requested
+	int tag; // The subsystem the block is counted under (see MEM_OTHER, MEM_CON_LEVELS, etc.)
+	int mapped; // Whether the block was mapped by allocate_pages rather than allocated by malloc
+};
+
+/* memory_scope counts the calling thread's allocations under the given subsystem until it goes out of scope
+	notes:
+		Memory is always counted under the subsystem it was allocated under, even when it is freed elsewhere.
+	todo:
+*/
+struct memory_scope {
+	int previous; // The tag the thread was using before this scope
+	
+	explicit memory_scope (int tag) {
+		this->previous = set_memory_tag(tag);
+	}
+	
+	~memory_scope () {
+		set_memory_tag(this->previous);
+	}
+};
+
+/* profiler contains the phase times, memory peaks, and event counts of a profiled run
+	notes:
+		Times and counts accumulate for the current mutant and are added to the current set's totals when the mutant finishes. Setup is timed only for the whole run.
+		The memory peaks come from the memory accounting in memory.cpp, which runs whether or not profiling was requested.
+	todo:
+*/
+struct profiler {
+	bool enabled; // Whether or not profiling was requested
+	ofstream* file; // The report file
+	double run_started; // When the run started (in seconds)
+	double phase_started[NUM_PHASES]; // When each phase was last started (in seconds)
+	double phase_times[NUM_PHASES]; // The time spent in each phase by the current mutant (in seconds)
+	double set_times[NUM_PHASES]; // The time spent in each phase by the current set (in seconds)
+	double run_times[NUM_PHASES]; // The time spent in each phase by the whole run (in seconds)
+	size_t phase_peaks[NUM_PHASES]; // The most heap used during each phase by the current mutant (in bytes)
+	size_t set_peaks[NUM_PHASES]; // The most heap used during each phase by the current set (in bytes)
+	size_t run_peaks[NUM_PHASES]; // The most heap used during each phase by the whole run (in bytes)
+	long long counts[NUM_COUNTS]; // The events counted for the current mutant
+	long long set_counts[NUM_COUNTS]; // The events counted for the current set
+	string mutants; // The JSON reports of the mutants simulated so far in the current set
+	
+	profiler () {
+		this->enabled = false;
+		this->file = NULL;
+		this->run_started = 0;
+		memset(this->phase_started, 0, sizeof(this->phase_started));
+		memset(this->phase_times, 0, sizeof(this->phase_times));
+		memset(this->set_times, 0, sizeof(this->set_times));
+		memset(this->run_times, 0, sizeof(this->run_times));
+		memset(this->phase_peaks, 0, sizeof(this->phase_peaks));
+		memset(this->set_peaks, 0, sizeof(this->set_peaks));
+		memset(this->run_peaks, 0, sizeof(this->run_peaks));
+		memset(this->counts, 0, sizeof(this->counts));
+		memset(this->set_counts, 0, sizeof(this->set_counts));
+	}
+};
+
 /* input_data contains information for retrieving data from an input file
 	notes:
 		All input files should be read with read_file and an input_data struct, storing their contents in a string buffer.
@@ -675,6 +1544,73 @@ struct input_data {
 	}
 };
 
+/* peaks_task contains the arguments of get_peaks_and_troughs, shared by every worker that runs it
+	notes:
+		If records is not NULL, the levels of the record_cons concentrations at every analyzed time step of a cell are copied into it, record_length levels per cell and concentration starting at records + (cell * num_records + con) * record_length.
+	todo:
+*/
+struct peaks_task {
+	sim_data* sd; // The current simulation's data
+	con_levels* cl; // The concentration levels to analyze
+	int* cells; // The cells to analyze, numbered relative to the entire PSM
+	int* time_starts; // The time step after which each cell is analyzed
+	int num_cells; // The number of cells to analyze
+	const int* cons; // The concentrations to analyze
+	int num_cons; // The number of concentrations to analyze
+	peak_set* ps; // The set to store the critical points in
+	const int* record_cons; // The concentrations whose levels to record
+	int num_records; // The number of concentrations to record
+	double* records; // The array to record levels in, NULL to record nothing
+	int record_length; // The number of levels recorded per cell and concentration
+	double* comp_scores[2]; // The complementary scores of mespa and mespb with mh1 in each cell (only used by osc_features_ant)
+};
+
+/* post_task contains the posterior oscillation tracking of every gene in every cell, shared by every worker that sweeps it
+	notes:
+		Each gene's oscillations in each cell are tracked separately at index gene * cells + x * width_current + y.
+	todo:
+*/
+struct post_task {
+	sim_data* sd; // The current simulation's data
+	con_levels* cl; // The concentration levels to analyze
+	features* wtfeat; // The wild type's features
+	const int* cons; // The genes' concentrations
+	int num_genes; // The number of genes to analyze
+	int cells; // The number of posterior cells
+	int start; // The time step after which to analyze
+	int end; // The time step before which to stop analyzing
+	growin_array* peaks; // The time steps of the peaks found
+	growin_array* troughs; // The time steps of the troughs found
+	growin_array* trough_peaks; // How many peaks there were when each trough was found
+	int* num_peaks; // The number of peaks found (reset to 0 if the peaks and troughs stop alternating)
+	int* num_troughs; // The number of troughs found
+	int* peaks_period; // The number of peaks found while the amplitude was high enough to average the period
+	double* cell_period; // The sum of the periods averaged
+	bool* calc_period; // Whether the amplitude is still high enough to average the period
+	bool* stopped; // Whether the peaks and troughs stopped alternating
+};
+
+/* spectral_task contains the spectral estimates of every gene's oscillations in every posterior cell, shared by every worker that computes them
+	notes:
+		Each gene's levels in each cell are split into two halves in time. Each half is averaged down to samples sample_steps time steps apart and run through num_filters Goertzel filters under a Hann window, and the estimates of half h are kept at index (gene * cells + x * width_current + y) * 2 + h.
+	todo:
+*/
+struct spectral_task {
+	sim_data* sd; // The current simulation's data
+	con_levels* cl; // The concentration levels to analyze
+	const int* cons; // The genes' concentrations
+	int num_genes; // The number of genes to analyze
+	int cells; // The number of posterior cells
+	int start; // The time step after which to analyze
+	int end; // The time step before which to stop analyzing
+	int sample_steps; // The number of time steps averaged into each sample
+	int num_filters; // The number of filters
+	double* freqs; // The filters' frequencies in radians per sample, in increasing order
+	double* periods; // The dominant period of each half in minutes (INFINITY if the half does not oscillate)
+	double* amplitudes; // The peak to trough amplitude of each half's dominant oscillation
+	double* means; // The mean level of each half
+};
+
 /* st_context contains the spatiotemporal context at a particular point in the simulation
 	notes:
 	todo:
@@ -0,0 +1,608 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+threads.cpp contains the thread pool feature analysis splits its per-cell work across and the background thread that writes output files. All threading related functions should be placed in this file.
+The pool is only created when --analysis-threads asks for more than one thread. Tasks divide the cells between the workers by index and write each cell's results to their own slots, which the calling thread reduces in cell order afterwards, so the features are identical for any number of threads.
+The writer is only created when --async-output gives it a buffer. Records reach it in the order they were handed off and it writes them in that order, so the files are identical with or without it.
+*/
+
+#include <cstdio> // Needed for fopen, fwrite, fclose
+#include <sched.h> // Needed for sched_getaffinity, cpu_set_t
+
+#include "threads.hpp" // Function declarations
+#include "profile.hpp" // Needed for PROFILE_COUNT
+
+using namespace std;
+
+extern terminal* term; // Declared in init.cpp
+
+static thread_pool* started_pool = NULL; // The pool whose threads are running (only one exists at a time)
+static output_writer* writer = NULL; // The background writer, NULL if the simulating thread writes every file itself
+static cpu_set_t allowed_cpus; // The CPUs the process may run on, which threads are pinned to in order
+static int num_allowed_cpus = 0; // The number of CPUs in allowed_cpus, 0 if threads are not pinned
+
+static void pin_thread(int);
+static void check_output_writer();
+static void stop_output_writer();
+static bool queue_ready(bool, size_t);
+static void wait_for_writer(bool, size_t);
+static void wake_side(pthread_cond_t*);
+static void* writer_loop(void*);
+static bool write_record(output_writer*, output_record&);
+static bool close_file(output_writer*, int);
+static void close_files(output_writer*);
+static void record_failure(output_writer*, char*);
+
+/* worker_loop runs the tasks posted to the pool until the pool shuts down
+	parameters:
+		arg: a pointer to the worker's index, which the thread frees
+	returns: NULL
+	notes:
+		Each thread runs this function.
+	todo:
+*/
+static void* worker_loop (void* arg) {
+	int worker = *(int*)arg;
+	mfree(arg);
+	set_memory_tag(MEM_FEATURES); // The pool only runs feature analysis
+	pin_thread(worker);
+	thread_pool* pool = started_pool;
+	int seen = 0;
+	pthread_mutex_lock(&(pool->lock));
+	while (true) {
+		while (!pool->quitting && pool->generation == seen) {
+			pthread_cond_wait(&(pool->task_ready), &(pool->lock));
+		}
+		if (pool->quitting) {
+			break;
+		}
+		seen = pool->generation;
+		void (*task)(void*, int) = pool->task;
+		void* task_arg = pool->task_arg;
+		pthread_mutex_unlock(&(pool->lock));
+		task(task_arg, worker);
+		pthread_mutex_lock(&(pool->lock));
+		pool->num_done++;
+		pthread_cond_signal(&(pool->task_done));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+	return NULL;
+}
+
+/* init_thread_affinity pins the simulating thread to the first CPU the process may run on if the user asked for pinned threads
+	parameters:
+		ip: the program's input parameters
+	returns: nothing
+	notes:
+		Analysis thread i is pinned to the (i + 1)th allowed CPU when it starts, wrapping around when there are more threads than CPUs. The simulating thread is analysis thread 0.
+		Pinned threads keep the memory they first touch on their NUMA node: the concentration levels, which the simulating thread zeroes, and each analysis thread's scratch arena. Analysis threads on other nodes still read the levels remotely, since the levels are laid out by time step and cannot be split between nodes by cell.
+		This must be called before init_thread_pool and before any concentration levels are allocated.
+	todo:
+*/
+void init_thread_affinity (input_params& ip) {
+	if (!ip.pin_threads) {
+		return;
+	}
+	if (sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus) != 0) {
+		term->verbose() << term->red << "Couldn't read the CPUs the process may run on, so threads will not be pinned." << term->reset << endl;
+		return;
+	}
+	num_allowed_cpus = CPU_COUNT(&allowed_cpus);
+	pin_thread(0);
+}
+
+/* pin_thread pins the calling thread to the allowed CPU with the given index
+	parameters:
+		index: the index of the thread, wrapped around the number of allowed CPUs
+	returns: nothing
+	notes:
+		A thread that cannot be pinned keeps running wherever the scheduler puts it.
+	todo:
+*/
+static void pin_thread (int index) {
+	if (num_allowed_cpus == 0) {
+		return;
+	}
+	int skip = index % num_allowed_cpus;
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &allowed_cpus) && skip-- == 0) {
+			cpu_set_t pinned;
+			CPU_ZERO(&pinned);
+			CPU_SET(cpu, &pinned);
+			pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+			return;
+		}
+	}
+}
+
+/* init_thread_pool starts the analysis threads if more than one was requested
+	parameters:
+		ip: the program's input parameters
+		sd: the current simulation's data, whose pool is set
+	returns: nothing
+	notes:
+	todo:
+*/
+void init_thread_pool (input_params& ip, sim_data& sd) {
+	if (ip.analysis_threads <= 1) {
+		return;
+	}
+	thread_pool* pool = new thread_pool();
+	pool->num_workers = ip.analysis_threads;
+	pool->threads = new pthread_t[pool->num_workers];
+	pool->arenas = new scratch_arena[pool->num_workers];
+	pthread_mutex_init(&(pool->lock), NULL);
+	pthread_cond_init(&(pool->task_ready), NULL);
+	pthread_cond_init(&(pool->task_done), NULL);
+	started_pool = pool;
+	for (int i = 1; i < pool->num_workers; i++) {
+		int* worker = (int*)mallocate(sizeof(int));
+		*worker = i;
+		if (pthread_create(&(pool->threads[i]), NULL, worker_loop, worker) != 0) {
+			cout << term->red << "Couldn't start analysis thread " << i << "!" << term->reset << endl;
+			exit(EXIT_THREAD_ERROR);
+		}
+	}
+	sd.pool = pool;
+}
+
+/* free_thread_pool stops the analysis threads and frees the pool
+	parameters:
+		sd: the current simulation's data
+	returns: nothing
+	notes:
+	todo:
+*/
+void free_thread_pool (sim_data& sd) {
+	thread_pool* pool = sd.pool;
+	if (pool == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&(pool->lock));
+	pool->quitting = true;
+	pthread_cond_broadcast(&(pool->task_ready));
+	pthread_mutex_unlock(&(pool->lock));
+	for (int i = 1; i < pool->num_workers; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+	pthread_mutex_destroy(&(pool->lock));
+	pthread_cond_destroy(&(pool->task_ready));
+	pthread_cond_destroy(&(pool->task_done));
+	delete[] pool->threads;
+	delete[] pool->arenas;
+	delete pool;
+	started_pool = NULL;
+	sd.pool = NULL;
+}
+
+/* run_in_pool runs the given task on every worker and returns once all of them have finished it
+	parameters:
+		sd: the current simulation's data
+		task: the task, which is given arg and the worker's index and should only do the work worker_range assigns that index
+		arg: the argument to give the task
+	returns: nothing
+	notes:
+		Without a pool the task simply runs on the calling thread as worker 0 of 1.
+	todo:
+*/
+void run_in_pool (sim_data& sd, void (*task)(void*, int), void* arg) {
+	thread_pool* pool = sd.pool;
+	if (pool == NULL) {
+		task(arg, 0);
+		return;
+	}
+	pthread_mutex_lock(&(pool->lock));
+	pool->task = task;
+	pool->task_arg = arg;
+	pool->num_done = 0;
+	pool->generation++;
+	pthread_cond_broadcast(&(pool->task_ready));
+	pthread_mutex_unlock(&(pool->lock));
+	
+	task(arg, 0);
+	
+	pthread_mutex_lock(&(pool->lock));
+	while (pool->num_done < pool->num_workers - 1) {
+		pthread_cond_wait(&(pool->task_done), &(pool->lock));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+}
+
+/* num_workers returns how many workers each task is split between
+	parameters:
+		sd: the current simulation's data
+	returns: the number of workers
+	notes:
+	todo:
+*/
+int num_workers (sim_data& sd) {
+	return sd.pool == NULL ? 1 : sd.pool->num_workers;
+}
+
+/* worker_range calculates which of the given number of items a worker handles
+	parameters:
+		worker: the worker's index
+		workers: the number of workers
+		num_items: the number of items to split between the workers
+		first: a pointer to store the index of the worker's first item in
+		end: a pointer to store the index after the worker's last item in
+	returns: nothing
+	notes:
+		The items are split into contiguous ranges in worker order whose sizes differ by at most 1.
+	todo:
+*/
+void worker_range (int worker, int workers, int num_items, int* first, int* end) {
+	*first = (int)((long long)num_items * worker / workers);
+	*end = (int)((long long)num_items * (worker + 1) / workers);
+}
+
+/* worker_scratch returns the scratch arena the given worker borrows from
+	parameters:
+		sd: the current simulation's data
+		worker: the worker's index
+	returns: the worker's arena
+	notes:
+	todo:
+*/
+scratch_arena& worker_scratch (sim_data& sd, int worker) {
+	if (worker == 0 || sd.pool == NULL) {
+		return sd.scratch;
+	}
+	return sd.pool->arenas[worker];
+}
+
+/* reset_scratch takes back every buffer borrowed from the calling thread's and the workers' arenas
+	parameters:
+		sd: the current simulation's data
+	returns: nothing
+	notes:
+		Only call this between tasks, never while one is running.
+	todo:
+*/
+void reset_scratch (sim_data& sd) {
+	sd.scratch.reset();
+	if (sd.pool != NULL) {
+		for (int i = 1; i < sd.pool->num_workers; i++) {
+			sd.pool->arenas[i].reset();
+		}
+	}
+}
+
+
+/* init_output_writer starts the background writer if the user gave it a buffer
+	parameters:
+		ip: the program's input parameters
+	returns: nothing
+	notes:
+		The writer is also stopped at exit, after writing what was queued, so output handed off before an error exit still reaches its files.
+	todo:
+*/
+void init_output_writer (input_params& ip) {
+	if (ip.output_buffer <= 0) {
+		return;
+	}
+	memory_scope scope(MEM_OUTPUT);
+	writer = new output_writer();
+	writer->max_bytes = (size_t)ip.output_buffer * 1048576;
+	pthread_mutex_init(&(writer->lock), NULL);
+	pthread_cond_init(&(writer->work_ready), NULL);
+	pthread_cond_init(&(writer->space_ready), NULL);
+	if (pthread_create(&(writer->thread), NULL, writer_loop, writer) != 0) {
+		cout << term->red << "Couldn't start the output thread!" << term->reset << endl;
+		exit(EXIT_THREAD_ERROR);
+	}
+	atexit(stop_output_writer);
+}
+
+/* free_output_writer waits for the background writer to write every queued record and then stops it
+	parameters:
+	returns: nothing
+	notes:
+		This exits with an error if any record could not be written.
+	todo:
+*/
+void free_output_writer () {
+	if (writer == NULL) {
+		return;
+	}
+	flush_output_writer();
+	stop_output_writer();
+}
+
+/* output_async returns whether or not output files are written by the background writer
+	parameters:
+	returns: true if there is a background writer, false otherwise
+	notes:
+	todo:
+*/
+bool output_async () {
+	return writer != NULL;
+}
+
+/* submit_output queues the given data to be written to the given file by the background writer
+	parameters:
+		path: the path and name of the file to write to, NULL to have the writer close every file it has open
+		append: whether to append to the file rather than create it
+		last: whether this is the last data for the file, so the writer should close it afterwards
+		data: the bytes to write, which the writer takes ownership of
+	returns: nothing
+	notes:
+		This only waits when the queue is out of slots or bytes, i.e. when the disk cannot keep up.
+	todo:
+*/
+void submit_output (char* path, bool append, bool last, string* data) {
+	size_t size = data->size();
+	check_output_writer();
+	if (!queue_ready(false, size)) {
+		PROFILE_COUNT(COUNT_OUTPUT_STALLS, 1);
+		wait_for_writer(false, size);
+		check_output_writer();
+	}
+	long long head = writer->head;
+	output_record& record = writer->slots[head % OUTPUT_QUEUE_SLOTS];
+	record.path = path == NULL ? NULL : copy_str(path);
+	record.append = append;
+	record.last = last;
+	record.data = data;
+	__atomic_fetch_add(&(writer->bytes_queued), size, __ATOMIC_RELAXED);
+	__atomic_store_n(&(writer->head), head + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&(writer->writer_waiting), __ATOMIC_SEQ_CST)) {
+		wake_side(&(writer->work_ready));
+	}
+}
+
+/* flush_output_writer waits until the background writer has written every queued record and closed every file
+	parameters:
+	returns: nothing
+	notes:
+		This exits with an error if any record could not be written.
+	todo:
+*/
+void flush_output_writer () {
+	if (writer == NULL) {
+		return;
+	}
+	submit_output(NULL, true, true, new string());
+	wait_for_writer(true, 0);
+	check_output_writer();
+}
+
+/* check_output_writer exits with an error if the background writer failed to write a record
+	parameters:
+	returns: nothing
+	notes:
+	todo:
+*/
+static void check_output_writer () {
+	char* failed_path = __atomic_load_n(&(writer->failed_path), __ATOMIC_ACQUIRE);
+	if (failed_path != NULL) {
+		cout << term->red << "Couldn't write to " << failed_path << "!" << term->reset << endl;
+		exit(EXIT_FILE_WRITE_ERROR);
+	}
+}
+
+/* stop_output_writer stops the background writer once it has emptied the queue and frees it
+	parameters:
+	returns: nothing
+	notes:
+		This is also registered to run at exit, when it does nothing if the writer was already freed.
+	todo:
+*/
+static void stop_output_writer () {
+	if (writer == NULL) {
+		return;
+	}
+	__atomic_store_n(&(writer->quitting), true, __ATOMIC_SEQ_CST);
+	wake_side(&(writer->work_ready));
+	pthread_join(writer->thread, NULL);
+	pthread_mutex_destroy(&(writer->lock));
+	pthread_cond_destroy(&(writer->work_ready));
+	pthread_cond_destroy(&(writer->space_ready));
+	mfree(writer->failed_path);
+	delete writer;
+	writer = NULL;
+}
+
+/* queue_ready returns whether the producer can go on
+	parameters:
+		drained: whether the producer needs the queue empty rather than room for a record
+		size: the bytes of the record the producer needs room for
+	returns: true if the queue is empty or, unless drained is set, has a free slot and room for the record's bytes, false otherwise
+	notes:
+	todo:
+*/
+static bool queue_ready (bool drained, size_t size) {
+	long long head = writer->head;
+	long long tail = __atomic_load_n(&(writer->tail), __ATOMIC_SEQ_CST);
+	if (drained || head == tail) {
+		return head == tail;
+	}
+	return head - tail < OUTPUT_QUEUE_SLOTS && __atomic_load_n(&(writer->bytes_queued), __ATOMIC_ACQUIRE) + size <= writer->max_bytes;
+}
+
+/* wait_for_writer puts the producer to sleep until the queue is ready for it
+	parameters:
+		drained: whether to wait for the queue to empty rather than for room for a record
+		size: the bytes of the record to wait for room for
+	returns: nothing
+	notes:
+		The producer raises its waiting flag before checking the queue under the lock, and the writer checks the flag after moving the tail, so one of them always sees the other. The writer moves the tail past a record even when writing it fails, so this always returns.
+	todo:
+*/
+static void wait_for_writer (bool drained, size_t size) {
+	__atomic_store_n(&(writer->producer_waiting), 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock(&(writer->lock));
+	while (!queue_ready(drained, size)) {
+		pthread_cond_wait(&(writer->space_ready), &(writer->lock));
+	}
+	pthread_mutex_unlock(&(writer->lock));
+	__atomic_store_n(&(writer->producer_waiting), 0, __ATOMIC_RELAXED);
+}
+
+/* wake_side wakes the side of the output queue sleeping on the given condition variable
+	parameters:
+		ready: the condition variable to signal
+	returns: nothing
+	notes:
+		Taking the lock makes sure the sleeping side is either still before its last check of the queue or already waiting.
+	todo:
+*/
+static void wake_side (pthread_cond_t* ready) {
+	pthread_mutex_lock(&(writer->lock));
+	pthread_cond_signal(ready);
+	pthread_mutex_unlock(&(writer->lock));
+}
+
+/* writer_loop writes the queued records in order until the writer is stopped and the queue is empty
+	parameters:
+		arg: a pointer to the writer
+	returns: NULL
+	notes:
+		The writer thread runs this function. It sleeps whenever the queue is empty, raising its waiting flag before checking the queue under the lock, and the producer checks the flag after moving the head, so one of them always sees the other.
+	todo:
+*/
+static void* writer_loop (void* arg) {
+	output_writer* w = (output_writer*)arg;
+	set_memory_tag(MEM_OUTPUT);
+	long long tail = w->tail;
+	while (true) {
+		bool quitting = __atomic_load_n(&(w->quitting), __ATOMIC_SEQ_CST); // Loaded before head so the last records queued are seen
+		long long head = __atomic_load_n(&(w->head), __ATOMIC_SEQ_CST);
+		if (tail == head) {
+			if (quitting) {
+				break;
+			}
+			__atomic_store_n(&(w->writer_waiting), 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_lock(&(w->lock));
+			while (__atomic_load_n(&(w->head), __ATOMIC_SEQ_CST) == tail && !__atomic_load_n(&(w->quitting), __ATOMIC_SEQ_CST)) {
+				pthread_cond_wait(&(w->work_ready), &(w->lock));
+			}
+			pthread_mutex_unlock(&(w->lock));
+			__atomic_store_n(&(w->writer_waiting), 0, __ATOMIC_RELAXED);
+			continue;
+		}
+		
+		// Write the record unless an earlier one failed, then give back its slot
+		output_record& record = w->slots[tail % OUTPUT_QUEUE_SLOTS];
+		size_t size = record.data->size();
+		if (record.path == NULL) {
+			close_files(w);
+		} else if (w->failed_path == NULL && !write_record(w, record)) {
+			record_failure(w, record.path);
+		}
+		mfree(record.path);
+		delete record.data;
+		__atomic_fetch_sub(&(w->bytes_queued), size, __ATOMIC_RELAXED);
+		__atomic_store_n(&(w->tail), ++tail, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&(w->producer_waiting), __ATOMIC_SEQ_CST)) {
+			wake_side(&(w->space_ready));
+		}
+	}
+	close_files(w);
+	return NULL;
+}
+
+/* write_record writes the given record to its file, opening the file if the writer does not have it open yet
+	parameters:
+		w: the writer
+		record: the record to write
+	returns: true if the record was written, false otherwise
+	notes:
+		A record that creates its file reopens it even if it is open, so the file is truncated. An empty record appending to a file that is not open has nothing to write and leaves the file alone.
+	todo:
+*/
+static bool write_record (output_writer* w, output_record& record) {
+	int i = 0;
+	for (; i < OUTPUT_OPEN_FILES && (w->files[i] == NULL || strcmp(w->file_paths[i], record.path) != 0); i++) {}
+	if (i < OUTPUT_OPEN_FILES && !record.append && !close_file(w, i)) {
+		return false;
+	}
+	if (i == OUTPUT_OPEN_FILES || w->files[i] == NULL) {
+		if (record.append && record.data->empty()) {
+			return true;
+		}
+		for (i = 0; i < OUTPUT_OPEN_FILES && w->files[i] != NULL; i++) {}
+		if (i == OUTPUT_OPEN_FILES) { // Make room by closing the file opened longest ago
+			i = w->next_closed;
+			w->next_closed = (w->next_closed + 1) % OUTPUT_OPEN_FILES;
+			if (!close_file(w, i)) {
+				return false;
+			}
+		}
+		w->files[i] = fopen(record.path, record.append ? "ab" : "wb");
+		if (w->files[i] == NULL) {
+			return false;
+		}
+		w->file_paths[i] = copy_str(record.path);
+	}
+	bool written = fwrite(record.data->data(), 1, record.data->size(), w->files[i]) == record.data->size();
+	if (record.last) {
+		return close_file(w, i) && written;
+	}
+	return written;
+}
+
+/* close_file closes the given open file of the writer
+	parameters:
+		w: the writer
+		index: the index of the file in the writer's open files
+	returns: true if the file was closed with everything written to it, false otherwise
+	notes:
+		A file that fails to close is recorded as the failed file, since the records written to it may already be done.
+	todo:
+*/
+static bool close_file (output_writer* w, int index) {
+	bool closed = fclose(w->files[index]) == 0;
+	if (!closed) {
+		record_failure(w, w->file_paths[index]);
+	}
+	w->files[index] = NULL;
+	mfree(w->file_paths[index]);
+	w->file_paths[index] = NULL;
+	return closed;
+}
+
+/* close_files closes every file the writer has open
+	parameters:
+		w: the writer
+	returns: nothing
+	notes:
+	todo:
+*/
+static void close_files (output_writer* w) {
+	for (int i = 0; i < OUTPUT_OPEN_FILES; i++) {
+		if (w->files[i] != NULL) {
+			close_file(w, i);
+		}
+	}
+}
+
+/* record_failure records that the writer failed to write the given file, unless an earlier failure was already recorded
+	parameters:
+		w: the writer
+		path: the path and name of the file that could not be written
+	returns: nothing
+	notes:
+	todo:
+*/
+static void record_failure (output_writer* w, char* path) {
+	if (w->failed_path == NULL) {
+		__atomic_store_n(&(w->failed_path), copy_str(path), __ATOMIC_RELEASE);
+	}
+}
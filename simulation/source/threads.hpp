@@ -0,0 +1,45 @@
+/*
+Simulation for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+threads.hpp contains function declarations for threads.cpp.
+*/
+
+#ifndef THREADS_HPP
+#define THREADS_HPP
+
+#include "structs.hpp"
+
+using namespace std;
+
+void init_thread_affinity(input_params&);
+void init_thread_pool(input_params&, sim_data&);
+void free_thread_pool(sim_data&);
+void run_in_pool(sim_data&, void (*)(void*, int), void*);
+int num_workers(sim_data&);
+void worker_range(int, int, int, int*, int*);
+scratch_arena& worker_scratch(sim_data&, int);
+void reset_scratch(sim_data&);
+void init_output_writer(input_params&);
+void free_output_writer();
+bool output_async();
+void submit_output(char*, bool, bool, string*);
+void flush_output_writer();
+
+#endif
+
@@ -230,7 +230,7 @@ void ESDeInitialParam(ESParameter *param)
  ** param: point to this parameter                                  **
  **   -> index: 0->eslambda-1                                       **
  **   -> individual[eslambda]                                       **
- **   -> fg(individual)                                             **
+ **   -> fg(individual[eslambda]) in one call                       **
  **   -> f,phi                                                      **
  ** the initialization is looked as first generation                **
  **                                                                 **
@@ -262,6 +262,11 @@ void ESInitialPopulation(ESPopulation **population, ESParameter *param)
     (*population)->member[i] = NULL;
     ESInitialIndividual(&((*population)->member[i]), param);
     (*population)->index[i] = i;
+  }
+
+  ESEvaluate((*population)->member, eslambda, param);
+  for(i=0; i<eslambda; i++)
+  {
     (*population)->f[i] = (*population)->member[i]->f;
     (*population)->phi[i] = (*population)->member[i]->phi;
   }
@@ -292,9 +297,8 @@ void ESDeInitialPopulation(ESPopulation *population, ESParameter *param)
 /*********************************************************************
  ** initialize individual                                           **
  ** ESInitialIndividual(indvdl, param)                              **
- ** to calculate f,g,and phi                                        **
  ** to initialize op and sp                                         **
- ** phi=sum{(g>0)^2}                                                **
+ ** f,g,and phi are calculated later by ESEvaluate                  **
  ** op = rand(lb, ub)                                               **
  ** sp = (ub - lb)/sqrt(dim)                                        **
  **                                                                 **
@@ -312,12 +316,10 @@ void ESInitialIndividual(ESIndividual **indvdl, ESParameter *param)
   int i;
   int dim;
   int constraint;
-  ESfcnFG fg;
   double *ub, *lb;
 
   dim = param->dim;
   constraint = param->constraint;
-  fg = param->fg;
   ub = param->ub;
   lb = param->lb;
 
@@ -340,13 +342,8 @@ void ESInitialIndividual(ESIndividual **indvdl, ESParameter *param)
     (*indvdl)->sp[i] = (ub[i] - lb[i])/sqrt(dim);
   }
 
-  fg((*indvdl)->op, &((*indvdl)->f), (*indvdl)->g);
+  (*indvdl)->f = 0.0;
   (*indvdl)->phi = 0.0;
-  for(i=0; i<constraint; i++)
-  {
-    if((*indvdl)->g[i] > 0.0)
-      (*indvdl)->phi += ((*indvdl)->g[i])*((*indvdl)->g[i]);
-  }
 
   return;
 }
@@ -416,6 +413,54 @@ void ESPrintSp(ESIndividual *indvdl, ESParameter *param)
   return;
 }
 
+/*********************************************************************
+ ** evaluate individuals                                            **
+ ** ESEvaluate(indvdl, count, param)                                **
+ ** indvdl[count]: the individuals to evaluate                      **
+ **   -> fg(op[count]) in one call                                  **
+ **   -> f,g,phi of every individual                                **
+ ** phi=sum{(g>0)^2}                                                **
+ *********************************************************************/
+void ESEvaluate(ESIndividual **indvdl, int count, ESParameter *param)
+{
+  int i, j;
+  int constraint;
+  double **op, **g;
+  double *f;
+
+  constraint = param->constraint;
+  op = (double **)ShareMallocM1c(count*sizeof(double *));
+  g = (double **)ShareMallocM1c(count*sizeof(double *));
+  f = ShareMallocM1d(count);
+  for(i=0; i<count; i++)
+  {
+    op[i] = indvdl[i]->op;
+    g[i] = indvdl[i]->g;
+  }
+
+  param->fg(op, f, g, count);
+
+  for(i=0; i<count; i++)
+  {
+    indvdl[i]->f = f[i];
+    indvdl[i]->phi = 0.0;
+    for(j=0; j<constraint; j++)
+    {
+      if(indvdl[i]->g[j] > 0.0)
+        indvdl[i]->phi += (indvdl[i]->g[j] * indvdl[i]->g[j]);
+    }
+  }
+
+  ShareFreeM1c((char *)op);
+  op = NULL;
+  ShareFreeM1c((char *)g);
+  g = NULL;
+  ShareFreeM1d(f);
+  f = NULL;
+
+  return;
+}
+
 /*********************************************************************
  ** copy a individual                                               **
  ** ESCopyIndividual(from, to, param)                               **
@@ -455,6 +500,8 @@ void ESCopyIndividual(ESIndividual *from, ESIndividual *to, ESParameter *param)
 void ESInitialStat(ESStatistics **stats, ESPopulation *population,   \
                    ESParameter *param)
 {
+  ESIndividual *indvdl[2];
+
   (*stats) = (ESStatistics *)ShareMallocM1c(sizeof(ESStatistics));
   (*stats)->bestgen = 0;
   (*stats)->curgen = 0;
@@ -466,6 +513,9 @@ void ESInitialStat(ESStatistics **stats, ESPopulation *population,   \
 
   ESInitialIndividual(&((*stats)->bestindvdl), param);
   ESInitialIndividual(&((*stats)->thisbestindvdl), param); 
+  indvdl[0] = (*stats)->bestindvdl;
+  indvdl[1] = (*stats)->thisbestindvdl;
+  ESEvaluate(indvdl, 2, param);
 
 /*********************************************************************
  ** dont do stat when initializing                                  ** 
@@ -691,7 +741,7 @@ void ESSelectPopulation(ESPopulation *population, ESParameter *param)
  ** sp(miu->lambda): sp = sp_ + alpha * (sp - sp_)                  **
  ** 
  ** Master: send op to other processors                             **
- ** Slave:  re-calculate f/g/phi                                    **
+ ** Slave:  re-calculate f/g/phi of all its op in one call          **
  *********************************************************************/
 void ESMutate(ESPopulation * population, ESParameter *param)
 {
@@ -855,7 +905,8 @@ void ESMPIMutate(ESPopulation *population, ESParameter *param)
   int i,j,k,l;
   int lambda, dim, constraint;
 
-  double *op, **gfphi;
+  double **op, **g, **gfphi;
+  double *f;
   int nummpi;
   int myid, numprocs;
   MPI_Status status;
@@ -880,7 +931,9 @@ void ESMPIMutate(ESPopulation *population, ESParameter *param)
   if(nummpi<=0)
     return;
 
-  op = ShareMallocM1d(dim);
+  op = ShareMallocM2d(nummpi,dim);
+  g = (double **)ShareMallocM1c(nummpi*sizeof(double *));
+  f = ShareMallocM1d(nummpi);
   gfphi = ShareMallocM2d(nummpi,2+constraint);
 
   for(i=0,j=1,l=0; i<lambda; i++,j++)
@@ -889,15 +942,21 @@ void ESMPIMutate(ESPopulation *population, ESParameter *param)
       j = 1;
     if(j!=myid)
       continue;
-    MPI_Recv(op, dim, MPI_DOUBLE, 0,i,MPI_COMM_WORLD,&status);
-    param->fg(op, &(gfphi[l][constraint]),gfphi[l]);
+    MPI_Recv(op[l], dim, MPI_DOUBLE, 0,i,MPI_COMM_WORLD,&status);
+    g[l] = gfphi[l];
+    l++;
+  }
+
+  param->fg(op, f, g, nummpi);
+  for(l=0; l<nummpi; l++)
+  {
+    gfphi[l][constraint] = f[l];
     gfphi[l][constraint+1] = 0.0;
     for(k=0;k<constraint;k++)
     {
       if(gfphi[l][k]>0.0)
         gfphi[l][constraint+1] += (gfphi[l][k]*gfphi[l][k]);
     }
-    l++;
   }
 
   MPI_Recv(buf,lenOK,MPI_BYTE,0,myid,MPI_COMM_WORLD, &status);
@@ -911,8 +970,12 @@ void ESMPIMutate(ESPopulation *population, ESParameter *param)
     l++;
   }
 
-  ShareFreeM1d(op);
+  ShareFreeM2d(op,nummpi);
   op = NULL;
+  ShareFreeM1c((char *)g);
+  g = NULL;
+  ShareFreeM1d(f);
+  f = NULL;
   ShareFreeM2d(gfphi,nummpi);
   gfphi = NULL;
 
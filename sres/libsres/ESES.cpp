@@ -202,7 +202,7 @@ void ESDeInitialParam(ESParameter *param)
  ** param: point to this parameter                                  **
  **   -> index: 0->eslambda-1                                       **
  **   -> individual[eslambda]                                       **
- **   -> fg(individual)                                             **
+ **   -> fg(individual[eslambda]) in one call                       **
  **   -> f,phi                                                      **
  ** the initialization is looked as first generation                **
  **                                                                 **
@@ -234,6 +234,11 @@ void ESInitialPopulation(ESPopulation **population, ESParameter *param)
     (*population)->member[i] = NULL;
     ESInitialIndividual(&((*population)->member[i]), param);
     (*population)->index[i] = i;
+  }
+
+  ESEvaluate((*population)->member, eslambda, param);
+  for(i=0; i<eslambda; i++)
+  {
     (*population)->f[i] = (*population)->member[i]->f;
     (*population)->phi[i] = (*population)->member[i]->phi;
   }
@@ -264,9 +269,8 @@ void ESDeInitialPopulation(ESPopulation *population, ESParameter *param)
 /*********************************************************************
  ** initialize individual                                           **
  ** ESInitialIndividual(indvdl, param)                              **
- ** to calculate f,g,and phi                                        **
  ** to initialize op and sp                                         **
- ** phi=sum{(g>0)^2}                                                **
+ ** f,g,and phi are calculated later by ESEvaluate                  **
  ** op = rand(lb, ub)                                               **
  ** sp = (ub - lb)/sqrt(dim)                                        **
  **                                                                 **
@@ -284,12 +288,10 @@ void ESInitialIndividual(ESIndividual **indvdl, ESParameter *param)
   int i;
   int dim;
   int constraint;
-  ESfcnFG fg;
   double *ub, *lb;
 
   dim = param->dim;
   constraint = param->constraint;
-  fg = param->fg;
   ub = param->ub;
   lb = param->lb;
 
@@ -312,13 +314,8 @@ void ESInitialIndividual(ESIndividual **indvdl, ESParameter *param)
     (*indvdl)->sp[i] = (ub[i] - lb[i])/sqrt(dim);
   }
 
-  fg((*indvdl)->op, &((*indvdl)->f), (*indvdl)->g);
+  (*indvdl)->f = 0.0;
   (*indvdl)->phi = 0.0;
-  for(i=0; i<constraint; i++)
-  {
-    if((*indvdl)->g[i] > 0.0)
-      (*indvdl)->phi += ((*indvdl)->g[i])*((*indvdl)->g[i]);
-  }
 
   return;
 }
@@ -388,6 +385,54 @@ void ESPrintSp(ESIndividual *indvdl, ESParameter *param)
   return;
 }
 
+/*********************************************************************
+ ** evaluate individuals                                            **
+ ** ESEvaluate(indvdl, count, param)                                **
+ ** indvdl[count]: the individuals to evaluate                      **
+ **   -> fg(op[count]) in one call                                  **
+ **   -> f,g,phi of every individual                                **
+ ** phi=sum{(g>0)^2}                                                **
+ *********************************************************************/
+void ESEvaluate(ESIndividual **indvdl, int count, ESParameter *param)
+{
+  int i, j;
+  int constraint;
+  double **op, **g;
+  double *f;
+
+  constraint = param->constraint;
+  op = (double **)ShareMallocM1c(count*sizeof(double *));
+  g = (double **)ShareMallocM1c(count*sizeof(double *));
+  f = ShareMallocM1d(count);
+  for(i=0; i<count; i++)
+  {
+    op[i] = indvdl[i]->op;
+    g[i] = indvdl[i]->g;
+  }
+
+  param->fg(op, f, g, count);
+
+  for(i=0; i<count; i++)
+  {
+    indvdl[i]->f = f[i];
+    indvdl[i]->phi = 0.0;
+    for(j=0; j<constraint; j++)
+    {
+      if(indvdl[i]->g[j] > 0.0)
+        indvdl[i]->phi += (indvdl[i]->g[j] * indvdl[i]->g[j]);
+    }
+  }
+
+  ShareFreeM1c((char *)op);
+  op = NULL;
+  ShareFreeM1c((char *)g);
+  g = NULL;
+  ShareFreeM1d(f);
+  f = NULL;
+
+  return;
+}
+
 /*********************************************************************
  ** copy a individual                                               **
  ** ESCopyIndividual(from, to, param)                               **
@@ -427,6 +472,8 @@ void ESCopyIndividual(ESIndividual *from, ESIndividual *to, ESParameter *param)
 void ESInitialStat(ESStatistics **stats, ESPopulation *population,   \
                    ESParameter *param)
 {
+  ESIndividual *indvdl[2];
+
   (*stats) = (ESStatistics *)ShareMallocM1c(sizeof(ESStatistics));
   (*stats)->bestgen = 0;
   (*stats)->curgen = 0;
@@ -438,6 +485,9 @@ void ESInitialStat(ESStatistics **stats, ESPopulation *population,   \
 
   ESInitialIndividual(&((*stats)->bestindvdl), param);
   ESInitialIndividual(&((*stats)->thisbestindvdl), param); 
+  indvdl[0] = (*stats)->bestindvdl;
+  indvdl[1] = (*stats)->thisbestindvdl;
+  ESEvaluate(indvdl, 2, param);
 
 /*********************************************************************
  ** dont do stat when initializing                                  ** 
@@ -646,12 +696,12 @@ void ESSelectPopulation(ESPopulation *population, ESParameter *param)
  ** exponential smoothing                                           **
  ** sp(miu->lambda): sp = sp_ + alpha * (sp - sp_)                  **
  ** 
- ** re-calculate f/g/phi                                            **
+ ** re-calculate f/g/phi of the whole population in one call        **
  *********************************************************************/
 void ESMutate(ESPopulation * population, ESParameter *param)
 {
   int i, j, k;
-  int miu, dim,lambda, constraint;
+  int miu, dim,lambda;
   double gamma, alpha;
   double tau, tau_;
   int retry;
@@ -661,7 +711,6 @@ void ESMutate(ESPopulation * population, ESParameter *param)
   ESIndividual *indvdl;
   double **sp_, **op_;
   double tmp;
-  ESfcnFG fg;
   
   randvec = NULL;
   sp_ = NULL;
@@ -669,7 +718,6 @@ void ESMutate(ESPopulation * population, ESParameter *param)
 
   miu = param->miu;
   lambda = param->lambda;
-  constraint = param->constraint;
   gamma = param->gamma;
   alpha = param->alpha;
   tau = param->tau;
@@ -679,7 +727,6 @@ void ESMutate(ESPopulation * population, ESParameter *param)
   ub = param->ub;
   lb = param->lb;
   dim = param->dim;
-  fg = param->fg;
   randvec = ShareMallocM1d(dim);
   sp_ = ShareMallocM2d(lambda, dim);
   op_ = ShareMallocM2d(lambda, dim);
@@ -749,18 +796,11 @@ void ESMutate(ESPopulation * population, ESParameter *param)
       indvdl->sp[j] = sp_[i][j] + alpha *(indvdl->sp[j] - sp_[i][j]);
   }
 
+  ESEvaluate(population->member, lambda, param);
   for(i=0; i<lambda; i++)
   {
-    indvdl = population->member[i];
-    fg(indvdl->op, &(indvdl->f), indvdl->g);
-    indvdl->phi = 0.0;
-    for(j=0; j<constraint; j++)
-    {
-      if(indvdl->g[j] > 0.0)
-        indvdl->phi += (indvdl->g[j] * indvdl->g[j]);
-    }
-    population->f[i] = indvdl->f;
-    population->phi[i] = indvdl->phi;
+    population->f[i] = population->member[i]->f;
+    population->phi[i] = population->member[i]->phi;
   }
 
   ShareFreeM1d(randvec);
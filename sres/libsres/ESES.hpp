@@ -45,10 +45,11 @@
 
 /*********************************************************************
  ** function of fitness and constraints                             **
- ** to calculate fitness and constraints and assign to ESIndividual **
- ** fg(x,dim, f, g)                                                 **
+ ** to calculate fitness and constraints of a whole population      **
+ ** at once and assign to ESIndividual                              **
+ ** fg(x[count], f[count], g[count], count)                         **
  *********************************************************************/
-typedef void(*ESfcnFG) (double *, double *, double *);
+typedef void(*ESfcnFG) (double **, double *, double **, int);
 
 /*********************************************************************
  ** function to transform x(op) and sp                              **
@@ -228,7 +229,7 @@ void ESDeInitialParam(ESParameter *);
  ** param: point to this parameter                                  **
  **   -> index: 0->lambda-1                                         **
  **   -> individual[lambda]                                         **
- **   -> fg(individual)                                             **
+ **   -> fg(individual[lambda]) in one call                         **
  **   -> f,phi                                                      **
  ** the initialization is looked as first generation                **
  **                                                                 **
@@ -240,9 +241,8 @@ void ESDeInitialPopulation(ESPopulation *, ESParameter *);
 /*********************************************************************
  ** initialize individual                                           **
  ** ESInitialIndividual(indvdl, param)                              **
- ** to calculate f,g,and phi                                        **
  ** to initialize op and sp                                         **
- ** phi=sum{(g>0)^2}                                                **
+ ** f,g,and phi are calculated later by ESEvaluate                  **
  ** op = rand(lb, ub)                                               **
  ** sp = (ub - lb)/sqrt(dim)                                        **
  **                                                                 **
@@ -260,6 +260,15 @@ void ESDeInitialIndividual(ESIndividual *);
 void ESPrintIndividual(ESIndividual *, ESParameter *);
 void ESPrintOp(ESIndividual *, ESParameter *);
 void ESPrintSp(ESIndividual *, ESParameter *);
+/*********************************************************************
+ ** evaluate individuals                                            **
+ ** ESEvaluate(indvdl, count, param)                                **
+ ** indvdl[count]: the individuals to evaluate                      **
+ **   -> fg(op[count]) in one call                                  **
+ **   -> f,g,phi of every individual                                **
+ ** phi=sum{(g>0)^2}                                                **
+ *********************************************************************/
+void ESEvaluate(ESIndividual **, int, ESParameter *);
 /*********************************************************************
  ** copy a individual                                               **
  ** ESCopyIndividual(from, to, param)                               **
@@ -340,7 +349,7 @@ void ESSelectPopulation(ESPopulation *, ESParameter *);
  ** exponential smoothing                                           **
  ** sp(miu->lambda): sp = sp_ + alpha * (sp - sp_)                  **
  **                                                                 **
- ** re-calculate f/g/phi                                            **
+ ** re-calculate f/g/phi of the whole population in one call        **
  *********************************************************************/
 void ESMutate(ESPopulation *, ESParameter *);
 
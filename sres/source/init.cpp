@@ -152,7 +152,22 @@ void accept_input_params (int num_args, char** args, input_params& ip) {
                 ensure_nonempty(option, value);
                 store_filename(&(ip.good_sets_file), value);
                 ip.print_good_sets = true;
-            } else if (option_set(option, "-a", "--arguments")) {
+            } else if (option_set(option, "-k", "--processes")) {
+				ensure_nonempty(option, value);
+				ip.sim_processes = atoi(value);
+				if (ip.sim_processes < 1) {
+					usage("Each generation must be simulated by at least one process. Set -k or --processes to at least 1.");
+				}
+			} else if (option_set(option, "-t", "--transport")) {
+				ensure_nonempty(option, value);
+				if (strcmp(value, "pipe") == 0) {
+					ip.transport = TRANSPORT_PIPE;
+				} else if (strcmp(value, "shm") == 0) {
+					ip.transport = TRANSPORT_SHM;
+				} else {
+					usage("The transport must be pipe or shm. Set -t or --transport to one of them.");
+				}
+			} else if (option_set(option, "-a", "--arguments")) {
 				ensure_nonempty(option, value);
 				++i;
 				ip.num_sim_args = num_args - i + NUM_IMPLICIT_SIM_ARGS;
@@ -245,6 +260,9 @@ void check_input_params (input_params& ip) {
 		usage("A ranges file must be specified! Set the ranges file with -r or --ranges-file.");
 	}
 	printing_precision = ip.printing_precision; // ip cannot be imported into a C file so the printing precision must be its own global
+	if (ip.transport == TRANSPORT_SHM) {
+		ip.sim_rings = new ring[ip.sim_processes]; // Each ring is created when it is first used
+	}
 }
 
 /* init_verbosity sets the verbose stream to /dev/null if verbose mode is not enabled
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 io.cpp contains functions for input and output of files and pipes. All I/O related functions should be placed in this file.
 */
 
+#include <cerrno> // Needed for errno, EINTR
 #include <sys/wait.h> // Needed for waitpid
 #include <unistd.h> // Needed for pipe, read, write, close, fork, execv
 
@@ -27,6 +28,7 @@ io.cpp contains functions for input and output of files and pipes. All I/O relat
 
 #include "init.hpp"
 #include "macros.hpp"
+#include "ring.hpp"
 #include "sres.hpp"
 
 extern terminal* term; // Declared in init.cpp
@@ -170,28 +172,118 @@ void open_file (ofstream* file_pointer, char* file_name, bool append) {
 	term->done(v);
 }
 
-/* simulate_set performs the required piping to setup and run a simulation with the given parameters
+/* simulate_sets splits the given parameter sets across the user-specified number of simulation processes, runs them all at once, and stores the score each set received
 	parameters:
-		parameters: the parameters to pass as a parameter set to the simulation
-	returns: the score the simulation received
+		sets: the parameter sets to simulate
+		scores: the array to store each set's score in
+		num_sets: the number of parameter sets
+	returns: nothing
 	notes:
+		Each process is sent its share of the sets through its own pipe or shared-memory ring and pipes back a score per set, so a generation launches at most ip.sim_processes simulations instead of one per set.
+		Every process is started before any is waited on so that they run concurrently.
 	todo:
 */
-double simulate_set (double parameters[]) {
+void simulate_sets (double* sets[], double scores[], int num_sets) {
 	// Get the MPI rank of the process
 	int rank = get_rank();
 	ostream& v = term->verbose();
 	
-	// Create a pipe
-	int pipes[2];
+	// Give each process an even share of the sets, the first few taking one more if they do not divide evenly
+	int num_processes = min(ip.sim_processes, num_sets);
+	pid_t pids[num_processes];
+	int pipes[num_processes][2];
+	int first_sets[num_processes + 1];
+	first_sets[0] = 0;
+	for (int i = 0; i < num_processes; i++) {
+		first_sets[i + 1] = first_sets[i] + num_sets / num_processes + (i < num_sets % num_processes);
+	}
+	
+	// Start every process and pipe in its sets
+	for (int i = 0; i < num_processes; i++) {
+		pids[i] = start_simulation(i, pipes[i], sets + first_sets[i], first_sets[i + 1] - first_sets[i]);
+	}
+	
+	// Wait for each process to finish simulating and pipe in its scores
+	for (int i = 0; i < num_processes; i++) {
+		int status = 0;
+		waitpid(pids[i], &status, WUNTRACED);
+		if (WIFEXITED(status) == 0) {
+			term->failed_child();
+			exit(EXIT_CHILD_ERROR);
+		}
+		
+		// Close the writing end of the pipe (the ring is kept for the next generation)
+		if (ip.transport == TRANSPORT_PIPE && close(pipes[i][1]) == -1) {
+			term->failed_pipe_write();
+			exit(EXIT_PIPE_WRITE_ERROR);
+		}
+		
+		// Pipe in the simulation's scores
+		int process_sets = first_sets[i + 1] - first_sets[i];
+		double max_score;
+		double raw_scores[process_sets];
+		v << "  ";
+		term->rank(rank, v);
+		v << term->blue << "Reading the pipe " << term->reset << "(file descriptor " << pipes[i][0] << ") . . . ";
+		read_pipe(pipes[i][0], &max_score, raw_scores, process_sets);
+		v << term->blue << "Done: " << term->reset << "(maximum raw score " << max_score << ")" << endl;
+		
+		// libSRES requires scores from 0 to 1 with 0 being a perfect score so convert the simulation's score format into libSRES's
+		for (int j = 0; j < process_sets; j++) {
+			int set = first_sets[i] + j;
+			scores[set] = 1 - (raw_scores[j] / max_score);
+			print_good_set(sets[set], scores[set]);
+		}
+		
+		// Close the reading end of the pipe
+		v << "  ";
+		term->rank(rank, v);
+		v << term->blue << "Closing the reading end of the pipe " << term->reset << "(file descriptor " << pipes[i][0] << ") . . . ";
+		if (ip.transport == TRANSPORT_PIPE && close(pipes[i][0]) == -1) {
+			term->failed_pipe_read();
+			exit(EXIT_PIPE_WRITE_ERROR);
+		}
+		term->done(v);
+	}
+}
+
+/* start_simulation creates a pipe, or readies a shared-memory ring, and forks a simulation that is piped the given parameter sets through it
+	parameters:
+		process: the index of the process among those simulating the generation, which picks its ring
+		pipes: the array to store the file descriptors of the pipe's reading and writing ends in (both the ring's if transport is shm)
+		sets: the parameter sets to pipe to the simulation
+		num_sets: the number of parameter sets
+	returns: the PID of the simulation's process
+	notes:
+		The simulation reads every set before it writes any score, so the same pipe or ring carries the sets in and the scores back.
+	todo:
+*/
+pid_t start_simulation (int process, int pipes[], double* sets[], int num_sets) {
+	int rank = get_rank();
+	ostream& v = term->verbose();
+	
+	// Create a pipe, or use the process's shared-memory ring for both of its ends if the user chose that transport
 	v << "  ";
 	term->rank(rank, v);
-	v << term->blue << "Creating a pipe " << term->reset << ". . . ";
-	if (pipe(pipes) == -1) {
-		term->failed_pipe_create();
-		exit(EXIT_PIPE_CREATE_ERROR);
+	if (ip.transport == TRANSPORT_SHM) {
+		v << term->blue << "Resetting the shared-memory ring " << term->reset << ". . . ";
+		ring& r = ip.sim_rings[process];
+		size_t bytes = max(2 * sizeof(int) + sizeof(double) * ip.num_dims * num_sets, sizeof(double) * (num_sets + 1)); // The sets sent or the scores received, whichever is larger
+		if (r.fd == -1 || r.header->capacity < bytes) {
+			free_ring(r);
+			init_ring(r, bytes);
+		}
+		reset_ring(r);
+		pipes[0] = pipes[1] = r.fd;
+		v << term->blue << "Done: " << term->reset << "using file descriptor " << pipes[0] << endl;
+	} else {
+		v << term->blue << "Creating a pipe " << term->reset << ". . . ";
+		if (pipe(pipes) == -1) {
+			term->failed_pipe_create();
+			exit(EXIT_PIPE_CREATE_ERROR);
+		}
+		v << term->blue << "Done: " << term->reset << "using file descriptors " << pipes[0] << " and " << pipes[1] << endl;
 	}
-	v << term->blue << "Done: " << term->reset << "using file descriptors " << pipes[0] << " and " << pipes[1] << endl;
 	
 	// Copy the user-specified simulation arguments and fill the copy with the pipe's file descriptors
 	char** sim_args = copy_args(ip.sim_args, ip.num_sim_args);
@@ -220,58 +312,21 @@ double simulate_set (double parameters[]) {
 			term->failed_exec();
 			exit(EXIT_EXEC_ERROR);
 		}
-	} else { // The parent pipes in the parameter set to run
+	} else { // The parent pipes in the parameter sets to run
 		v << term->blue << "Done: " << term->reset << "the child process's PID is " << pid << endl;
 		v << "  ";
 		term->rank(rank, v);
-		v << term->blue << "Writing to the pipe " << term->reset << "(file descriptor " << pipes[1] << ") . . . ";
-		write_pipe(pipes[1], parameters);
+		v << term->blue << "Writing to the pipe " << term->reset << "(file descriptor " << pipes[1] << ", " << num_sets << " parameter sets) . . . ";
+		write_pipe(pipes[1], sets, num_sets);
 		term->done(v);
 	}
 	
-	// Wait for the child to finish simulating
-	int status = 0;
-	waitpid(pid, &status, WUNTRACED);
-	if (WIFEXITED(status) == 0) {
-		term->failed_child();
-		exit(EXIT_CHILD_ERROR);
-	}
-	
-	// Close the writing end of the pipe
-	if (close(pipes[1]) == -1) {
-		term->failed_pipe_write();
-		exit(EXIT_PIPE_WRITE_ERROR);
-	}
-	
-	// Pipe in the simulation's score
-	double max_score;
-	double score;
-	v << "  ";
-	term->rank(rank, v);
-	v << term->blue << "Reading the pipe " << term->reset << "(file descriptor " << pipes[0] << ") . . . ";
-	read_pipe(pipes[0], &max_score, &score);
-	v << term->blue << "Done: " << term->reset << "(raw score " << score << " / " << max_score << ")" << endl;
-
-    double SRESscore = 1 - ((double)score / max_score);
-	print_good_set(parameters, SRESscore);
-	// Close the reading end of the pipe
-	v << "  ";
-	term->rank(rank, v);
-	v << term->blue << "Closing the reading end of the pipe " << term->reset << "(file descriptor " << pipes[0] << ") . . . ";
-	if (close(pipes[0]) == -1) {
-		term->failed_pipe_read();
-		exit(EXIT_PIPE_WRITE_ERROR);
-	}
-	term->done(v);
-	
 	// Free the simulation arguments
 	for (int i = 0; sim_args[i] != NULL; i++) {
 		mfree(sim_args[i]);
 	}
 	mfree(sim_args);
-	
-	// libSRES requires scores from 0 to 1 with 0 being a perfect score so convert the simulation's score format into libSRES's
-	return SRESscore;
+	return pid;
 }
 
 void print_good_set (double parameters[], double score) {
@@ -288,20 +343,20 @@ void print_good_set (double parameters[], double score) {
     }
 }
 
-/* write_pipe writes the given parameter set to the given pipe
+/* write_pipe writes the given parameter sets to the given pipe
 	parameters:
 		fd: the file descriptor of the pipe to write to
-		parameters: the parameter set to pipe
+		sets: the parameter sets to pipe
+		num_sets: the number of parameter sets
 	returns: nothing
 	notes:
 	todo:
 */
-void write_pipe (int fd, double parameters[]) {
+void write_pipe (int fd, double* sets[], int num_sets) {
 	write_pipe_int(fd, ip.num_dims); // Write the number of dimensions, i.e. parameters per set, being sent
-	write_pipe_int(fd, 1); // Write that one parameter set is being sent
-	if (write(fd, parameters, sizeof(double) * ip.num_dims) == -1) {
-		term->failed_pipe_write();
-		exit(EXIT_PIPE_WRITE_ERROR);
+	write_pipe_int(fd, num_sets); // Write how many parameter sets are being sent
+	for (int i = 0; i < num_sets; i++) {
+		write_pipe_bytes(fd, sets[i], sizeof(double) * ip.num_dims);
 	}
 }
 
@@ -314,24 +369,53 @@ void write_pipe (int fd, double parameters[]) {
 	todo:
 */
 void write_pipe_int (int fd, int value) {
-	if (write(fd, &value, sizeof(int)) == -1) {
-		term->failed_pipe_write();
-		exit(EXIT_PIPE_WRITE_ERROR);
+	write_pipe_bytes(fd, &value, sizeof(int));
+}
+
+/* write_pipe_bytes writes the given bytes to the given pipe or, if the user chose that transport, the shared-memory ring
+	parameters:
+		fd: the file descriptor of the pipe to write to
+		buffer: the bytes to write
+		bytes: the number of bytes to write
+	returns: nothing
+	notes:
+	todo:
+*/
+void write_pipe_bytes (int fd, const void* buffer, size_t bytes) {
+	if (ip.transport == TRANSPORT_SHM) {
+		write_ring(*find_ring(fd), buffer, bytes);
+		return;
+	}
+	const char* next = (const char*)buffer;
+	while (bytes > 0) { // A pipe can take fewer bytes than asked, so write until every byte is in
+		ssize_t bytes_written = write(fd, next, bytes);
+		if (bytes_written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			term->failed_pipe_write();
+			exit(EXIT_PIPE_WRITE_ERROR);
+		}
+		next += bytes_written;
+		bytes -= bytes_written;
 	}
 }
 
-/* read_pipe reads the maximum score and the received score from the given pipe
+/* read_pipe reads the maximum score and the score each set received from the given pipe
 	parameters:
 		fd: the file descriptor of the pipe to write to
-		max_score: a pointer to store the maximum score the simulation could have received
-		score: a pointer to store the score the simulation actually received
+		max_score: a pointer to store the maximum score a set could have received
+		scores: the array to store the score each set actually received in
+		num_sets: the number of sets the simulation was sent
 	returns: nothing
 	notes:
 	todo:
 */
-void read_pipe (int fd, double* max_score, double* score) {
+void read_pipe (int fd, double* max_score, double scores[], int num_sets) {
 	read_pipe_int(fd, max_score);
-	read_pipe_int(fd, score);
+	for (int i = 0; i < num_sets; i++) {
+		read_pipe_int(fd, &(scores[i]));
+	}
 }
 
 /* read_pipe_int writes an integer from the given pipe
@@ -340,13 +424,44 @@ void read_pipe (int fd, double* max_score, double* score) {
 		address: a pointer to store the received integer
 	returns: nothing
 	notes:
+		A simulation that exits before sending every byte ends the pipe early, which is reported as a failed read.
 	todo:
 */
 void read_pipe_int (int fd, double* address) {
-	if (read(fd, address, sizeof(double)) == -1) {
-		term->failed_pipe_read();
-		exit(EXIT_PIPE_READ_ERROR);
+	if (ip.transport == TRANSPORT_SHM) {
+		read_ring(*find_ring(fd), address, sizeof(double));
+		return;
+	}
+	char* next = (char*)address;
+	size_t bytes = sizeof(double);
+	while (bytes > 0) { // A pipe can return fewer bytes than asked, so read until every byte is in
+		ssize_t bytes_read = read(fd, next, bytes);
+		if (bytes_read == -1 && errno == EINTR) {
+			continue;
+		}
+		if (bytes_read <= 0) {
+			term->failed_pipe_read();
+			exit(EXIT_PIPE_READ_ERROR);
+		}
+		next += bytes_read;
+		bytes -= bytes_read;
+	}
+}
+
+/* find_ring returns the shared-memory ring of the simulation process with the given file descriptor
+	parameters:
+		fd: the file descriptor of the ring
+	returns: a pointer to the ring
+	notes:
+		The file descriptor must belong to one of ip.sim_rings.
+	todo:
+*/
+ring* find_ring (int fd) {
+	int i = 0;
+	while (ip.sim_rings[i].fd != fd) {
+		i++;
 	}
+	return &(ip.sim_rings[i]);
 }
 
 /* close_if_open closes the given output file stream if it is open
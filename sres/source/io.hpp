@@ -23,18 +23,23 @@ io.hpp contains function declarations for io.cpp.
 #ifndef IO_HPP
 #define IO_HPP
 
+#include <sys/types.h> // Needed for pid_t
+
 #include "structs.hpp"
 
 void store_filename(char**, const char*);
 void read_file(input_data*);
 void parse_ranges_file (char*, input_params&, sres_params&);
 void open_file(ofstream*, char*, bool);
-double simulate_set(double[]);
+void simulate_sets(double*[], double[], int);
+pid_t start_simulation(int, int[], double*[], int);
 void print_good_set (double parameters[], double score);
-void write_pipe(int, double[]);
+void write_pipe(int, double*[], int);
 void write_pipe_int(int, int);
-void read_pipe(int, double*, double*);
+void write_pipe_bytes(int, const void*, size_t);
+void read_pipe(int, double*, double[], int);
 void read_pipe_int(int, double*);
+ring* find_ring(int);
 void close_if_open(ofstream&);
 
 #endif
@@ -26,6 +26,12 @@ macros.hpp contains every constant and macro function used in the program.
 // The number of implicit arguments sent to the simulation
 #define NUM_IMPLICIT_SIM_ARGS 6
 
+// Ways of sending parameter sets to simulations and receiving their scores
+#define TRANSPORT_PIPE		0 // A pipe per simulation process
+#define TRANSPORT_SHM		1 // A shared-memory ring per simulation process, reused every generation (see ring.cpp)
+#define RING_MAGIC			"SIMRING" // The 8 bytes (including the terminating null) every shared-memory ring starts with
+#define RING_MIN_CAPACITY	4096 // The fewest bytes of data a shared-memory ring holds
+
 // Exit statuses
 #define EXIT_SUCCESS			0
 #define EXIT_MEMORY_ERROR		1
@@ -32,6 +32,7 @@ Avoid putting functions in main.cpp that could be put in a more specific file.
 
 #include "init.hpp"
 #include "macros.hpp"
+#include "ring.hpp"
 #include "sres.hpp"
 
 using namespace std;
@@ -77,6 +78,12 @@ int main (int argc, char** argv) {
 	
 	// Free used memory, wrap up libSRES, etc.
 	free_sres(sp);
+	if (ip.sim_rings != NULL) {
+		for (int i = 0; i < ip.sim_processes; i++) {
+			free_ring(ip.sim_rings[i]);
+		}
+		delete[] ip.sim_rings;
+	}
 	#if defined(MEMTRACK)
 		print_heap_usage();
 	#endif
@@ -110,6 +117,8 @@ void usage (const char* message) {
 	cout << "-g, --generations        [int]        : the number of generations to run before returning results, min=1, default=1750" << endl;
 	cout << "-s, --seed               [int]        : the seed used in the evolutionary strategy (not simulations), min=1, default=time" << endl;
 	cout << "-e, --printing-precision [int]        : how many digits of precision parameters should be printed with, min=1, default=6" << endl;
+	cout << "-k, --processes          [int]        : the number of simulation processes each generation's population is split across, min=1, default=1" << endl;
+	cout << "-t, --transport          [string]     : how parameter sets and scores are sent to and from simulations, pipe or shm (a shared-memory ring per process reused every generation), default=pipe" << endl;
 	cout << "-a, --arguments          [N/A]        : every argument following this will be sent to the simulation" << endl;
 	cout << "-c, --no-color           [N/A]        : disable coloring the terminal output, default=unused" << endl;
 	cout << "-v, --verbose            [N/A]        : print detailed messages about the program state" << endl;
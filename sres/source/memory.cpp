@@ -28,9 +28,10 @@ Many features and functions are enabled only when scons-compiling with 'memtrack
 
 extern terminal* term; // Declared in init.cpp
 
-// Variables the memory tracker uses to keep track of heap usage
+// Variables the memory tracker uses to keep track of heap usage (updated atomically so libSRES may be built with threads)
 #if defined(MEMTRACK)
 	size_t heap_current = 0;
+	size_t heap_peak = 0;
 	size_t heap_total = 0;
 #endif
 
@@ -57,8 +58,10 @@ void* mallocate (size_t size) {
 			exit(EXIT_MEMORY_ERROR);
 		}
 		#if defined(MEMTRACK)
-			heap_current += size;
-			heap_total += size;
+			size_t current = __atomic_add_fetch(&heap_current, size, __ATOMIC_RELAXED);
+			size_t peak = __atomic_load_n(&heap_peak, __ATOMIC_RELAXED);
+			while (current > peak && !__atomic_compare_exchange_n(&heap_peak, &peak, current, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+			__atomic_fetch_add(&heap_total, size, __ATOMIC_RELAXED);
 			size_t* sizeblock = (size_t*)block;
 			*sizeblock = size;
 			return (void*)(sizeblock + 1);
@@ -132,7 +135,7 @@ void mfree (void* mem) {
 	#if defined(MEMTRACK)
 		if (mem != NULL) {
 			size_t* memblock = (size_t*)mem - 1;
-			heap_current -= *memblock;
+			__atomic_fetch_sub(&heap_current, *memblock, __ATOMIC_RELAXED);
 			free(memblock);
 		}
 	#else
@@ -215,11 +218,12 @@ static void print_mem_amount (size_t mem) {
 	cout << endl;
 }
 
-/* print_heap_usage prints the current and total heap usage calculated with the memory tracker
+/* print_heap_usage prints the current, peak, and total heap usage calculated with the memory tracker
 	parameters:
 	returns: nothing
 	notes:
 		Current heap usage indicates how much unfreed memory is on the heap.
+		Peak heap usage indicates the most memory that was on the heap at once.
 		Total heap usage indicates how much memory has been allocated since the program's inception.
 		Do not call this function after free_terminal or reset_cout since it uses terminal colors allocated by init_terminal and quiet mode does not work after reset_cout.
 	todo:
@@ -227,6 +231,8 @@ static void print_mem_amount (size_t mem) {
 void print_heap_usage () {
 	cout << term->blue << "Current heap usage:\t" << term->reset;
 	print_mem_amount(heap_current);
+	cout << term->blue << "Peak heap usage:\t" << term->reset;
+	print_mem_amount(heap_peak);
 	cout << term->blue << "Total heap usage:\t" << term->reset;
 	print_mem_amount(heap_total);
 }
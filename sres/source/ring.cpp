@@ -0,0 +1,154 @@
+/*
+Stochastically ranked evolutionary strategy sampler for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ring.cpp contains the functions that create and use the shared-memory ring simulations are sent parameter sets through when --transport is shm. All shared-memory ring related functions should be placed in this file.
+The ring carries exactly what a pipe would, but the sampler and the simulation copy the data straight into and out of a shared mapping instead of making a system call per value. One ring is created per simulation process a generation is split across (see simulate_sets in io.cpp) and reused every generation, growing if a generation sends more than it holds.
+*/
+
+#include <linux/futex.h> // Needed for FUTEX_WAKE
+#include <sys/mman.h> // Needed for memfd_create, mmap, munmap
+#include <sys/syscall.h> // Needed for SYS_futex
+#include <unistd.h> // Needed for ftruncate, close, syscall
+
+#include "ring.hpp" // Function declarations
+
+#include "macros.hpp"
+
+extern terminal* term; // Declared in init.cpp
+
+/* init_ring creates a shared-memory ring that holds at least the given number of bytes
+	parameters:
+		r: the ring to create
+		bytes: the most bytes that will be unread at once
+	returns: nothing
+	notes:
+		The memfd is not closed on exec so simulations forked afterward inherit it and can be passed its file descriptor.
+	todo:
+*/
+void init_ring (ring& r, size_t bytes) {
+	unsigned int capacity = RING_MIN_CAPACITY;
+	while (capacity < bytes) {
+		capacity *= 2;
+	}
+	r.size = sizeof(ring_header) + capacity;
+	r.fd = memfd_create("sres-ring", 0);
+	if (r.fd == -1 || ftruncate(r.fd, r.size) == -1) {
+		term->failed_pipe_create();
+		exit(EXIT_PIPE_CREATE_ERROR);
+	}
+	void* mapped = mmap(NULL, r.size, PROT_READ | PROT_WRITE, MAP_SHARED, r.fd, 0);
+	if (mapped == MAP_FAILED) {
+		term->failed_pipe_create();
+		exit(EXIT_PIPE_CREATE_ERROR);
+	}
+	r.header = (ring_header*)mapped;
+	r.data = (char*)mapped + sizeof(ring_header);
+	strcpy(r.header->magic, RING_MAGIC);
+	r.header->capacity = capacity;
+	reset_ring(r);
+}
+
+/* reset_ring empties the given ring so the next simulation can use it
+	parameters:
+		r: the ring to reset
+	returns: nothing
+	notes:
+		This must only be called while no simulation is using the ring.
+	todo:
+*/
+void reset_ring (ring& r) {
+	r.header->closed = 0;
+	r.header->head = 0;
+	r.header->reader_waiting = 0;
+	r.header->tail = 0;
+	r.header->writer_waiting = 0;
+}
+
+/* write_ring copies the given bytes into the given ring and wakes the simulation if it is waiting for them
+	parameters:
+		r: the ring to write to
+		buffer: the bytes to write
+		bytes: the number of bytes to write
+	returns: nothing
+	notes:
+		The ring is sized when it is created to hold everything sent to a simulation, so this function never waits for space; it exits with an error if there is not enough.
+	todo:
+*/
+void write_ring (ring& r, const void* buffer, size_t bytes) {
+	ring_header* header = r.header;
+	unsigned int head = header->head; // Only the writer moves the head
+	unsigned int tail = __atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE);
+	if (bytes > header->capacity - (head - tail)) {
+		term->failed_pipe_write();
+		exit(EXIT_PIPE_WRITE_ERROR);
+	}
+	
+	// Copy the bytes, in two parts if they wrap around the end of the data
+	size_t offset = head & (header->capacity - 1);
+	size_t first = min(bytes, header->capacity - offset);
+	memcpy(r.data + offset, buffer, first);
+	memcpy(r.data, (const char*)buffer + first, bytes - first);
+	__atomic_store_n(&(header->head), head + (unsigned int)bytes, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&(header->reader_waiting), __ATOMIC_SEQ_CST)) {
+		syscall(SYS_futex, &(header->head), FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+
+/* read_ring copies the given number of bytes out of the given ring
+	parameters:
+		r: the ring to read from
+		buffer: the address to store the bytes read
+		bytes: the number of bytes to read
+	returns: nothing
+	notes:
+		This is only called after the simulation has exited, so every byte it wrote has arrived; the function exits with an error if fewer are unread.
+	todo:
+*/
+void read_ring (ring& r, void* buffer, size_t bytes) {
+	ring_header* header = r.header;
+	unsigned int tail = header->tail; // Only the reader moves the tail
+	unsigned int head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+	if (bytes > head - tail) {
+		term->failed_pipe_read();
+		exit(EXIT_PIPE_READ_ERROR);
+	}
+	
+	// Copy the bytes, in two parts if they wrap around the end of the data
+	size_t offset = tail & (header->capacity - 1);
+	size_t first = min(bytes, header->capacity - offset);
+	memcpy(buffer, r.data + offset, first);
+	memcpy((char*)buffer + first, r.data, bytes - first);
+	__atomic_store_n(&(header->tail), tail + (unsigned int)bytes, __ATOMIC_RELEASE);
+}
+
+/* free_ring unmaps and closes the given ring if it was created
+	parameters:
+		r: the ring to free
+	returns: nothing
+	notes:
+	todo:
+*/
+void free_ring (ring& r) {
+	if (r.fd != -1) {
+		munmap(r.header, r.size);
+		close(r.fd);
+		r.fd = -1;
+	}
+}
+
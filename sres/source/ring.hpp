@@ -0,0 +1,35 @@
+/*
+Stochastically ranked evolutionary strategy sampler for zebrafish segmentation
+Copyright (C) 2013 Ahmet Ay, Jack Holland, Adriana Sperlea, Sebastian Sangervasi
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ring.hpp contains function declarations for ring.cpp.
+*/
+
+#ifndef RING_HPP
+#define RING_HPP
+
+#include "structs.hpp"
+
+void init_ring(ring&, size_t);
+void reset_ring(ring&);
+void write_ring(ring&, const void*, size_t);
+void read_ring(ring&, void*, size_t);
+void free_ring(ring&);
+
+#endif
+
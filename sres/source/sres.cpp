@@ -142,18 +142,19 @@ void free_sres (sres_params& sp) {
 	ESDeInitial(sp.param, sp.population, sp.stats);
 }
 
-/* fitness runs a simulation and stores its resulting score in a variable libSRES then accesses
+/* fitness simulates the given population and stores each member's resulting score in an array libSRES then accesses
 	parameters:
-		parameters: the parameters provided by libSRES
-		score: a pointer to store the score the simulation received
-		constraints: parameter constraints (not used but required by libSRES's code structure)
+		parameters: the parameter set of each population member provided by libSRES
+		scores: the array to store the score each member's simulation received in
+		constraints: each member's parameter constraints (not used but required by libSRES's code structure)
+		num_members: the number of population members
 	returns: nothing
 	notes:
-		This function is called by libSRES for every population member every generation.
+		This function is called by libSRES once for the whole population every generation, so the population can be simulated in as few processes as the user specified.
 	todo:
 */
-void fitness (double* parameters, double* score, double* constraints) {
-	*score = simulate_set(parameters);
+void fitness (double** parameters, double* scores, double** constraints, int num_members) {
+	simulate_sets(parameters, scores, num_members);
 }
 
 /* transform is a dummy function required by libSRES's code structure
@@ -29,7 +29,7 @@ int get_rank();
 void init_sres(input_params&, sres_params&);
 void run_sres(sres_params&);
 void free_sres(sres_params&);
-void fitness(double*, double*, double*);
+void fitness(double**, double*, double**, int);
 double transform(double);
 
 #endif
@@ -34,6 +34,7 @@ structs.hpp contains every struct used in the program.
 	#include "../libsres/ESES.hpp"
 #endif
 
+#include "macros.hpp"
 #include "memory.hpp"
 
 using namespace std;
@@ -154,6 +155,43 @@ struct terminal {
 	}
 };
 
+/* ring_header is the start of a shared-memory ring, a byte stream in a memfd passed to simulations in place of their pipe ends
+	notes:
+		The ring's data follows the header. head and tail count the bytes written and read modulo 2^32, so their difference is the number of unread bytes; each is waited on as a futex and sits on its own cache line.
+		The simulation reads and writes rings with the same layout (see simulation/source/structs.hpp), so the two must be changed together.
+	todo:
+*/
+struct ring_header {
+	char magic[8]; // RING_MAGIC
+	unsigned int capacity; // The bytes of data the ring holds, a power of 2
+	int closed; // Whether the writing side has closed the ring, i.e. will write no more
+	char pad_0[48];
+	unsigned int head; // The bytes written so far, moved only by the writing side
+	int reader_waiting; // Whether the reading side is waiting for the head to move
+	char pad_1[56];
+	unsigned int tail; // The bytes read so far, moved only by the reading side
+	int writer_waiting; // Whether the writing side is waiting for the tail to move
+	char pad_2[56];
+};
+
+/* ring contains a shared-memory ring created by this process
+	notes:
+	todo:
+*/
+struct ring {
+	int fd; // The file descriptor of the memfd holding the ring, -1 if the ring has not been created
+	ring_header* header; // The mapped header
+	char* data; // The mapped data, right after the header
+	size_t size; // The bytes mapped
+	
+	ring () {
+		this->fd = -1;
+		this->header = NULL;
+		this->data = NULL;
+		this->size = 0;
+	}
+};
+
 /* input_params contains all of the program's input parameters (i.e. the given command-line arguments) as well as data associated with them
 	notes:
 		There should be only one instance of input_params at any time.
@@ -183,6 +221,9 @@ struct input_params {
 	// Simulation parameters
 	char** sim_args; // Arguments to be passed to the simulation
 	int num_sim_args; // The number of arguments to be passed to the simulation
+	int sim_processes; // The number of simulation processes each generation's population is split across, default=1
+	int transport; // How parameter sets and scores are sent to and from simulations (TRANSPORT_PIPE or TRANSPORT_SHM), default=TRANSPORT_PIPE
+	ring* sim_rings; // The shared-memory ring each simulation process uses if transport is TRANSPORT_SHM, one per process
 	
 	// Output stream data
 	int printing_precision; // The number of digits of precision parameters should be printed with, default=6
@@ -205,6 +246,9 @@ struct input_params {
 		//this->good_sets_stream = NULL;
 		this->sim_args = NULL;
 		this->num_sim_args = 0;
+		this->sim_processes = 1;
+		this->transport = TRANSPORT_PIPE;
+		this->sim_rings = NULL;
 		this->printing_precision = 6;
 		this->verbose = false;
 		this->quiet = false;